@@ -19,15 +19,13 @@ namespace Linear {
      * @return PxQ submatrix of A
      */
     template <size_t P, size_t Q, typename T, size_t M, size_t N, unsigned int Flags>
-    Matrix<T,P,Q,Flags> SubMatrix(Matrix<T,M,N,Flags> A, size_t i = 0, size_t j = 0) {
+    Matrix<T,P,Q,Flags> SubMatrix(const Matrix<T,M,N,Flags>& A, size_t i = 0, size_t j = 0) {
         if (i+P > A.NumRows() || j+Q > A.NumColumns())
             throw "Cannot create submatrix, indices out of bounds.";
         Matrix<T,P,Q,Flags> ret(P,Q,T(0));
-        for (size_t r = 0; r < P; ++r) {
-            for (size_t c = 0; c < Q; ++c) {
-                ret(r,c) = A(i+r,j+c);
-            }
-        }
+        ForEachIndex<(Flags & ColumnMajor) != 0, false>(P, Q, [&](size_t r, size_t c) {
+            ret.At(r,c) = A.At(i+r,j+c);
+        });
         return ret;
     }
     /**
@@ -47,15 +45,13 @@ namespace Linear {
      * @return nrowsxncols submatrix of A
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
-    Matrix<T,Dynamic,Dynamic,Flags> SubMatrix(Matrix<T,M,N,Flags> A, size_t nrows, size_t ncols, size_t i = 0, size_t j = 0) {
+    Matrix<T,Dynamic,Dynamic,Flags> SubMatrix(const Matrix<T,M,N,Flags>& A, size_t nrows, size_t ncols, size_t i = 0, size_t j = 0) {
         if (i+nrows > A.NumRows() || j+ncols > A.NumColumns())
             throw "Cannot create submatrix, indices out of bounds.";
         Matrix<T,Dynamic,Dynamic,Flags> ret(nrows,ncols,T(0));
-        for (size_t r = 0; r < nrows; ++r) {
-            for (size_t c = 0; c < ncols; ++c) {
-                ret(r,c) = A(i+r,j+c);
-            }
-        }
+        ForEachIndex<(Flags & ColumnMajor) != 0, false>(nrows, ncols, [&](size_t r, size_t c) {
+            ret.At(r,c) = A.At(i+r,j+c);
+        });
         return ret;
     }
     /**
@@ -65,7 +61,7 @@ namespace Linear {
      * @return (M-1)xN submatrix of A
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
-    Matrix<T,(M==Dynamic?Dynamic:M-1),N,Flags> RemoveRow(Matrix<T,M,N,Flags> A, size_t i) {
+    Matrix<T,(M==Dynamic?Dynamic:M-1),N,Flags> RemoveRow(const Matrix<T,M,N,Flags>& A, size_t i) {
         if (A.NumRows() == 0)
             throw "Cannot remove row from a matrix with 0 rows.";
         if (i >= A.NumRows())
@@ -74,14 +70,9 @@ namespace Linear {
         if (ret.NumEntries() == 0)
             return ret;
 
-        for (size_t r = 0; r < A.NumRows(); ++r) {
-            for (size_t c = 0; c < A.NumColumns(); ++c) {
-                if (r < i)
-                    ret(r,c) = A(r,c);
-                if (r > i)
-                    ret(r-1,c) = A(r,c);
-            }
-        }
+        ForEachIndex<(Flags & ColumnMajor) != 0, false>(ret.NumRows(), ret.NumColumns(), [&](size_t r, size_t c) {
+            ret.At(r,c) = A.At((r < i ? r : r+1),c);
+        });
         return ret;
     }
     /**
@@ -91,7 +82,7 @@ namespace Linear {
      * @return Mx(N-1) submatrix of A
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
-    Matrix<T,M,(N==Dynamic?Dynamic:N-1),Flags> RemoveColumn(Matrix<T,M,N,Flags> A, size_t i) {
+    Matrix<T,M,(N==Dynamic?Dynamic:N-1),Flags> RemoveColumn(const Matrix<T,M,N,Flags>& A, size_t i) {
         if (A.NumColumns() == 0)
             throw "Cannot remove column from a matrix with 0 columns.";
         if (i >= A.NumColumns())
@@ -100,14 +91,9 @@ namespace Linear {
         if (ret.NumEntries() == 0)
             return ret;
 
-        for (size_t r = 0; r < A.NumRows(); ++r) {
-            for (size_t c = 0; c < A.NumColumns(); ++c) {
-                if (c < i)
-                    ret(r,c) = A(r,c);
-                if (c > i)
-                    ret(r,c-1) = A(r,c);
-            }
-        }
+        ForEachIndex<(Flags & ColumnMajor) != 0, false>(ret.NumRows(), ret.NumColumns(), [&](size_t r, size_t c) {
+            ret.At(r,c) = A.At(r,(c < i ? c : c+1));
+        });
         return ret;
     }
     /**
@@ -118,7 +104,7 @@ namespace Linear {
      * @return (M-1)x(N-1) submatrix of A
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
-    Matrix<T,(M==Dynamic?Dynamic:M-1),(N==Dynamic?Dynamic:N-1),Flags> RemoveRowAndColumn(Matrix<T,M,N,Flags> A, size_t i, size_t j) {
+    Matrix<T,(M==Dynamic?Dynamic:M-1),(N==Dynamic?Dynamic:N-1),Flags> RemoveRowAndColumn(const Matrix<T,M,N,Flags>& A, size_t i, size_t j) {
         if (A.NumRows() == 0)
             throw "Cannot remove row from a matrix with 0 rows.";
         if (A.NumColumns() == 0)
@@ -129,18 +115,9 @@ namespace Linear {
         if (ret.NumEntries() == 0)
             return ret;
 
-        for (size_t r = 0; r < A.NumRows(); ++r) {
-            for (size_t c = 0; c < A.NumColumns(); ++c) {
-                if (r < i && c < j)
-                    ret(r,c) = A(r,c);
-                if (r > i && c < j)
-                    ret(r-1,c) = A(r,c);
-                if (r < i && c > j)
-                    ret(r,c-1) = A(r,c);
-                if (r > i && c > j)
-                    ret(r-1,c-1) = A(r,c);
-            }
-        }
+        ForEachIndex<(Flags & ColumnMajor) != 0, false>(ret.NumRows(), ret.NumColumns(), [&](size_t r, size_t c) {
+            ret.At(r,c) = A.At((r < i ? r : r+1),(c < j ? c : c+1));
+        });
         return ret;
     }
 
@@ -151,14 +128,34 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,N,M,Flags> Transpose(const Matrix<T,M,N,Flags>& A) {
+        typedef typename Matrix<T,M,N,Flags>::Scalar Scalar;
         Matrix<T,N,M,Flags> ret(A.NumColumns(), A.NumRows(), T(0));
-        for (size_t r = 0; r < ret.NumRows(); ++r) {
-            for (size_t c = 0; c < ret.NumColumns(); ++c) {
-                ret(r,c) = A(c,r);
-            }
+        if (IsSmallSize<M,N>::value) {
+            SmallTranspose<M,N,(Flags & ColumnMajor) != 0>(A.Data(), ret.Data());
+            return ret;
+        }
+        if (ret.NumEntries() != 0) {
+            // The array of ret is the transpose of the array of A, whichever order they are stored in.
+            size_t lines = ((Flags & ColumnMajor) ? A.NumColumns() : A.NumRows());
+            TransposeEntries(A.Data(), lines, A.NumEntries()/lines, A.LeadingDimension(), ret.WritableData(), ret.LeadingDimension(),
+                             [](const Scalar& a) { return a; });
         }
         return ret;
     }
+    /**
+     * Transposes a temporary matrix. Square matrices are transposed in place, see Matrix::TransposeInPlace().
+     * @param A NxN matrix
+     * @return NxN matrix
+     */
+    template <typename T, size_t M, size_t N, unsigned int Flags>
+    typename std::enable_if<M == N, Matrix<T,N,M,Flags>>::type Transpose(Matrix<T,M,N,Flags>&& A) {
+        // Following the cycles of a rectangular transpose is slower than copying the tiles out, and small matrices are
+        // copied in straight-line code.
+        if (A.NumRows() != A.NumColumns() || IsSmallSize<M,N>::value)
+            return Transpose(static_cast<const Matrix<T,M,N,Flags>&>(A));
+        A.TransposeInPlace();
+        return std::move(A);
+    }
 
     /**
      * Returns the NxM matrix \f$B=A^*\f$ defined by \f$b_{ij}=\overline{a_{ji}}\f$.
@@ -166,15 +163,34 @@ namespace Linear {
      * @return NxM matrix
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
-    Matrix<T,N,M,Flags> ConjugateTranspose(Matrix<T,M,N,Flags> A) {
+    Matrix<T,N,M,Flags> ConjugateTranspose(const Matrix<T,M,N,Flags>& A) {
+        typedef typename Matrix<T,M,N,Flags>::Scalar Scalar;
         Matrix<T,N,M,Flags> ret(A.NumColumns(), A.NumRows(), T(0));
-        for (size_t r = 0; r < ret.NumRows(); ++r) {
-            for (size_t c = 0; c < ret.NumColumns(); ++c) {
-                ret(r,c) = Conjugate(A(c,r));
-            }
+        if (IsSmallSize<M,N>::value) {
+            SmallTranspose<M,N,(Flags & ColumnMajor) != 0,true>(A.Data(), ret.Data());
+            return ret;
+        }
+        if (ret.NumEntries() != 0) {
+            size_t lines = ((Flags & ColumnMajor) ? A.NumColumns() : A.NumRows());
+            TransposeEntries(A.Data(), lines, A.NumEntries()/lines, A.LeadingDimension(), ret.WritableData(), ret.LeadingDimension(),
+                             [](const Scalar& a) { return Conjugate(a); });
         }
         return ret;
     }
+    /**
+     * Conjugate transposes a temporary matrix. Square matrices are transposed in place, see Matrix::TransposeInPlace().
+     * @param A NxN matrix
+     * @return NxN matrix
+     */
+    template <typename T, size_t M, size_t N, unsigned int Flags>
+    typename std::enable_if<M == N, Matrix<T,N,M,Flags>>::type ConjugateTranspose(Matrix<T,M,N,Flags>&& A) {
+        if (A.NumRows() != A.NumColumns())
+            return ConjugateTranspose(static_cast<const Matrix<T,M,N,Flags>&>(A));
+        A.TransposeInPlace();
+        for (auto& a : A)
+            a = Conjugate(a);
+        return std::move(A);
+    }
 
     /**
      * Computes A's reduced row echelon form.
@@ -232,17 +248,23 @@ namespace Linear {
         return ret;
     }
 
+    /// \cond DO_NOT_DOCUMENT
     /**
-     * Computes the determinant of a square matrix defined by \f$\sum_{i=0}^{N-1}(-1)^ia_{0i}\det(A_{0i})\f$ where \f$A_{0i}\f$ is the (N-1)x(N-1)
-     * matrix obtained by deleting the 0th row and ith column. If A is not square, an exception is thrown.
-     * @param A MxN matrix
-     * @return Complex number
+     * Determinant of a fixed-size matrix of at most 4x4, in closed form (see SmallSquare).
+     */
+    template <typename T, size_t N, unsigned int Flags>
+    typename std::enable_if<IsSmallSize<N,N>::value, typename Matrix<T,N,N,Flags>::Scalar>::type
+    CofactorExpansion(const Matrix<T,N,N,Flags>& A) {
+        return SmallSquare<N,(Flags & ColumnMajor) != 0>::Determinant(A.Data());
+    }
+    /**
+     * Cofactor expansion along the 0th row, carried out in the same arithmetic A is stored in. Real matrices are expanded
+     * with real multiplications only.
+     * @param A NxN matrix
+     * @return Real number if A uses RealStorage, complex number otherwise
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
-    Complex<T> Determinant(const Matrix<T,M,N,Flags>& A) {
-        if (A.NumRows() != A.NumColumns())
-            throw "Cannot take the determinant of a non-square matrix.";
-
+    typename Matrix<T,M,N,Flags>::Scalar CofactorExpansion(const Matrix<T,M,N,Flags>& A) {
         if (A.NumRows() == 0)
             return T(1);
         if (A.NumRows() == 1)
@@ -250,15 +272,30 @@ namespace Linear {
         if (A.NumRows() == 2)
             return (A(0,0)*A(1,1) - A(0,1)*A(1,0));
 
-        Complex<T> ret;
+        typename Matrix<T,M,N,Flags>::Scalar ret = T(0);
         for (size_t i = 0; i < A.NumRows(); ++i) {
             if (i % 2 == 0)
-                ret += A(0,i)*Minor(A, 0, i);
+                ret += A(0,i)*CofactorExpansion(RemoveRowAndColumn(A, 0, i));
             else
-                ret -= A(0,i)*Minor(A, 0, i);
+                ret -= A(0,i)*CofactorExpansion(RemoveRowAndColumn(A, 0, i));
         }
         return ret;
     }
+    /// \endcond
+
+    /**
+     * Computes the determinant of a square matrix defined by \f$\sum_{i=0}^{N-1}(-1)^ia_{0i}\det(A_{0i})\f$ where \f$A_{0i}\f$ is the (N-1)x(N-1)
+     * matrix obtained by deleting the 0th row and ith column. If A is not square, an exception is thrown.
+     * If A uses RealStorage, the determinant is computed in real arithmetic.
+     * @param A MxN matrix
+     * @return Complex number
+     */
+    template <typename T, size_t M, size_t N, unsigned int Flags>
+    Complex<T> Determinant(const Matrix<T,M,N,Flags>& A) {
+        if (A.NumRows() != A.NumColumns())
+            throw "Cannot take the determinant of a non-square matrix.";
+        return CofactorExpansion(A);
+    }
 
     /**
      * Computes the (i,j)-minor of a square matrix defined by \f$\det(A_{ij})\f$ where \f$A_{ij}\f$ is the (N-1)x(N-1)
@@ -302,6 +339,42 @@ namespace Linear {
         return T(-1.0)*Minor(A, i, j);
     }
 
+    /// \cond DO_NOT_DOCUMENT
+    /**
+     * Computes the adjugate of the square matrix A into ret cofactor by cofactor, or in closed form for fixed 2x2, 3x3 and
+     * 4x4 matrices (see SmallSquare). The closed form also gives the determinant, which is returned.
+     */
+    template <typename T, size_t M, size_t N, unsigned int Flags>
+    void AdjugateInto(const Matrix<T,M,N,Flags>& A, Matrix<T,M,N,Flags>& ret, std::false_type) {
+        for (size_t r = 0; r < A.NumRows(); ++r) {
+            for (size_t c = 0; c < A.NumColumns(); ++c) {
+                ret(c,r) = ret.ToScalar(Cofactor(A, r, c));
+            }
+        }
+    }
+    template <typename T, size_t M, size_t N, unsigned int Flags>
+    typename Matrix<T,M,N,Flags>::Scalar AdjugateInto(const Matrix<T,M,N,Flags>& A, Matrix<T,M,N,Flags>& ret, std::true_type) {
+        return SmallSquare<M,(Flags & ColumnMajor) != 0>::Adjugate(A.Data(), ret.Data());
+    }
+
+    template <typename T, size_t M, size_t N, unsigned int Flags>
+    Matrix<T,M,N,Flags> InverseOf(const Matrix<T,M,N,Flags>& A, std::false_type) {
+        Complex<T> det = Determinant(A);
+        if (det == 0)
+            throw "Cannot take the inverse of a singular matrix.";
+        return Adjugate(A)/A.ToScalar(det);
+    }
+    template <typename T, size_t M, size_t N, unsigned int Flags>
+    Matrix<T,M,N,Flags> InverseOf(const Matrix<T,M,N,Flags>& A, std::true_type) {
+        Matrix<T,M,N,Flags> ret;
+        typename Matrix<T,M,N,Flags>::Scalar det = AdjugateInto(A, ret, std::true_type());
+        if (det == T(0))
+            throw "Cannot take the inverse of a singular matrix.";
+        ret *= T(1)/det;
+        return ret;
+    }
+    /// \endcond
+
     /**
      * Computes the NxN adjugate B of a square matrix A defined by \f$b_{ij}=c_{ji}\f$ where \f$c_{ij}\f$ represents the (i,j)-cofactor of A.
      * If A is not square, an exception is thrown.
@@ -313,11 +386,7 @@ namespace Linear {
         if (A.NumRows() != A.NumColumns())
             throw "Cannot take the adjugate of a non-square matrix.";
         Matrix<T,M,N,Flags> ret(A.NumRows(), A.NumColumns(), T(0));
-        for (size_t r = 0; r < A.NumRows(); ++r) {
-            for (size_t c = 0; c < A.NumColumns(); ++c) {
-                ret(c,r) = Cofactor(A, r, c);
-            }
-        }
+        AdjugateInto(A, ret, IsSmallSquare<M,N>());
         return ret;
     }
 
@@ -331,9 +400,20 @@ namespace Linear {
     Matrix<T,M,N,Flags> Inverse(const Matrix<T,M,N,Flags>& A) {
         if (A.NumRows() != A.NumColumns())
             throw "Cannot take the inverse of a non-square matrix.";
-        Complex<T> det = Determinant(A);
-        if (det == 0)
-            throw "Cannot take the inverse of a singular matrix.";
-        return Adjugate(A)/det;
+        return InverseOf(A, IsSmallSquare<M,N>());
     }
+
+    // Accept unevaluated expressions, e.g. RemoveRow(A - B).
+    LINEAR_EVALUATE_EXPRESSIONS(RemoveRow)
+    LINEAR_EVALUATE_EXPRESSIONS(RemoveColumn)
+    LINEAR_EVALUATE_EXPRESSIONS(RemoveRowAndColumn)
+    LINEAR_EVALUATE_EXPRESSIONS(Transpose)
+    LINEAR_EVALUATE_EXPRESSIONS(ConjugateTranspose)
+    LINEAR_EVALUATE_EXPRESSIONS(RREF)
+    LINEAR_EVALUATE_EXPRESSIONS(Trace)
+    LINEAR_EVALUATE_EXPRESSIONS(Determinant)
+    LINEAR_EVALUATE_EXPRESSIONS(Minor)
+    LINEAR_EVALUATE_EXPRESSIONS(Cofactor)
+    LINEAR_EVALUATE_EXPRESSIONS(Adjugate)
+    LINEAR_EVALUATE_EXPRESSIONS(Inverse)
 }
@@ -0,0 +1,642 @@
+#pragma once
+#include <cstddef> // For size_t
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <vector>
+#include "Complex.h"
+#include "Storage.h"
+#include "Matrix.h"
+#include "Parallel.h"
+#include "Simd.h"
+
+namespace Linear {
+    template <typename MatrixType>
+    class Batch;
+
+    /// \cond DO_NOT_DOCUMENT
+    /**
+     * Number of matrices the batch kernels work on at once: one 512-bit vector of entries, i.e. 8 doubles or 16 floats.
+     */
+    template <typename T>
+    struct BatchLanes {
+        static const size_t value = (sizeof(T) < 64 ? 64/sizeof(T) : 1);
+    };
+    /// \endcond
+
+    /**
+     * Many matrices of the same fixed size, stored across the batch: entry (r,c) of every matrix is kept in one contiguous
+     * array (a plane), followed by the planes of the imaginary parts unless Flags contains RealStorage. The batch functions
+     * below (products, Transpose, Determinant, Inverse and Solve) work on a vector's worth of matrices at a time, each
+     * instruction handling the same entry of 4, 8 or 16 matrices, instead of one small matrix after another:
+     *
+     *     Batch<RealMatrix3d> poses(count), points(count);
+     *     for (size_t i = 0; i < count; ++i)
+     *         poses.Set(i, Pose(i));
+     *     Batch<RealMatrix3d> moved = poses*points;
+     *     Batch<RealMatrix3d> inverses = Inverse(poses);
+     *
+     * The storage order of the matrix type does not matter to the batch, and its entries come from the current default
+     * memory resource like those of a dynamically sized matrix.
+     * @param T Type to store matrix entries as.
+     * @param M Number of rows, fixed at compile time.
+     * @param N Number of columns, fixed at compile time.
+     * @param Flags Flags of the matrices (RealStorage keeps only the real planes).
+     */
+    template <typename T, size_t M, size_t N, unsigned int Flags>
+    class Batch<Matrix<T,M,N,Flags>> {
+        static_assert(M != Dynamic && N != Dynamic, "A batch holds matrices whose size is fixed at compile time.");
+    public:
+        typedef Matrix<T,M,N,Flags> MatrixType;
+        /**
+         * Type of each entry: T if Flags contains RealStorage, Complex<T> otherwise.
+         */
+        typedef typename MatrixType::Scalar Scalar;
+        static const bool IsComplex = !(Flags & RealStorage);
+        /**
+         * Matrices handled together by the batch kernels. Planes are padded to a multiple of it.
+         */
+        static const size_t Lanes = BatchLanes<T>::value;
+
+        /**
+         * Constructor.
+         * Creates a batch of count zero matrices.
+         * @param count Number of matrices (default = 0)
+         */
+        explicit Batch(size_t count = 0) {
+            Allocate(count);
+        }
+        /**
+         * Constructor.
+         * Creates a batch of count copies of A.
+         * @param count Number of matrices
+         * @param A MxN matrix
+         */
+        Batch(size_t count, const MatrixType& A) {
+            Allocate(count);
+            for (size_t r = 0; r < M; ++r) {
+                for (size_t c = 0; c < N; ++c) {
+                    std::fill(RealData(r,c), RealData(r,c)+count, GemmRe(A(r,c)));
+                    if (IsComplex)
+                        std::fill(Plane(M*N+r*N+c), Plane(M*N+r*N+c)+count, GemmIm(A(r,c)));
+                }
+            }
+        }
+
+        /**
+         * @return Number of matrices in the batch
+         */
+        size_t Size() const { return this->count; }
+        /**
+         * @return Number of rows of each matrix
+         */
+        size_t NumRows() const { return M; }
+        /**
+         * @return Number of columns of each matrix
+         */
+        size_t NumColumns() const { return N; }
+
+        /**
+         * Returns a copy of matrix i. If i is out of range, an exception is thrown.
+         * @param i Index in the batch
+         * @return MxN matrix
+         */
+        MatrixType Get(size_t i) const {
+            if (i >= Size())
+                throw "Cannot access batch. Index out of range.";
+            MatrixType A;
+            for (size_t r = 0; r < M; ++r) {
+                for (size_t c = 0; c < N; ++c)
+                    A(r,c) = Entry(i, r, c);
+            }
+            return A;
+        }
+        /**
+         * Sets matrix i to A. If i is out of range, an exception is thrown.
+         * @param i Index in the batch
+         * @param A MxN matrix
+         */
+        void Set(size_t i, const MatrixType& A) {
+            if (i >= Size())
+                throw "Cannot access batch. Index out of range.";
+            for (size_t r = 0; r < M; ++r) {
+                for (size_t c = 0; c < N; ++c) {
+                    RealData(r,c)[i] = GemmRe(A(r,c));
+                    if (IsComplex)
+                        Plane(M*N+r*N+c)[i] = GemmIm(A(r,c));
+                }
+            }
+        }
+
+        /**
+         * @return Pointer to the real parts of entry (r,c) of every matrix, Size() of them.
+         */
+        T * RealData(size_t r, size_t c) { return Plane(r*N+c); }
+        const T * RealData(size_t r, size_t c) const { return Plane(r*N+c); }
+        /**
+         * @return Pointer to the imaginary parts of entry (r,c) of every matrix, laid out like RealData(). If the batch
+         * uses RealStorage an exception is thrown.
+         */
+        T * ImagData(size_t r, size_t c) {
+            if (!IsComplex)
+                throw "A batch with real storage has no imaginary parts.";
+            return Plane(M*N+r*N+c);
+        }
+        const T * ImagData(size_t r, size_t c) const {
+            if (!IsComplex)
+                throw "A batch with real storage has no imaginary parts.";
+            return Plane(M*N+r*N+c);
+        }
+
+        /// \cond DO_NOT_DOCUMENT
+        // Planes are numbered by entry (r*N+c), the imaginary ones following the real ones, and are Stride() entries apart.
+        T * Plane(size_t p) { return this->planes.Data() + p*Stride(); }
+        const T * Plane(size_t p) const { return this->planes.Data() + p*Stride(); }
+        size_t Stride() const { return this->planes.LeadingDimension(); }
+        /// \endcond
+    private:
+        void Allocate(size_t count) {
+            this->count = count;
+            size_t padded = (count+Lanes-1)/Lanes*Lanes;
+            this->planes.Allocate((IsComplex ? 2 : 1)*M*N, padded, PaddedLeadingDimension<T>(padded));
+        }
+        static T MakeEntry(T re, T, T *) { return re; }
+        static Complex<T> MakeEntry(T re, T im, Complex<T> *) { return Complex<T>(re, im); }
+        Scalar Entry(size_t i, size_t r, size_t c) const {
+            return MakeEntry(RealData(r,c)[i], (IsComplex ? Plane(M*N+r*N+c)[i] : T(0)), (Scalar *)NULL);
+        }
+
+        DenseStorage<T,Dynamic,Dynamic> planes;
+        size_t count;
+    };
+
+    /// \cond DO_NOT_DOCUMENT
+// The kernels rely on being inlined into the loops below and on their loops over the entries being unrolled, so that the
+// entries live in registers and only the loops over the lanes are left, as vector instructions.
+#if defined(__clang__)
+#define LINEAR_BATCH_INLINE __attribute__((always_inline)) inline
+#define LINEAR_BATCH_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__)
+#define LINEAR_BATCH_INLINE __attribute__((always_inline)) inline
+#define LINEAR_BATCH_UNROLL _Pragma("GCC unroll 16")
+#else
+#define LINEAR_BATCH_INLINE inline
+#define LINEAR_BATCH_UNROLL
+#endif
+    /**
+     * The same entry of L matrices, held in local arrays so that the compiler can keep them in vector registers. Complex
+     * entries keep their real and imaginary parts in separate arrays. The operations below loop over the L lanes.
+     */
+    template <typename T, bool IsComplex, size_t L>
+    struct BatchValue {
+        T re[L], im[L];
+    };
+    template <typename T, size_t L>
+    struct BatchValue<T,false,L> {
+        T re[L];
+    };
+
+    /**
+     * Loads entry p of the lanes of chunk from the planes of a batch (of complexity C), which has count planes per part.
+     */
+    template <bool C, typename T, size_t L>
+    LINEAR_BATCH_INLINE void BatchLoad(BatchValue<T,false,L>& x, const T * planes, size_t stride, size_t, size_t p, size_t chunk) {
+        const T * re = planes + p*stride + chunk*L;
+        for (size_t l = 0; l < L; ++l)
+            x.re[l] = re[l];
+    }
+    template <bool C, typename T, size_t L>
+    LINEAR_BATCH_INLINE void BatchLoad(BatchValue<T,true,L>& x, const T * planes, size_t stride, size_t count, size_t p, size_t chunk) {
+        const T * re = planes + p*stride + chunk*L, * im = (C ? planes + (count+p)*stride + chunk*L : re);
+        for (size_t l = 0; l < L; ++l) {
+            x.re[l] = re[l];
+            x.im[l] = (C ? im[l] : T(0));
+        }
+    }
+    template <typename T, size_t L>
+    LINEAR_BATCH_INLINE void BatchStore(T * planes, size_t stride, size_t, size_t p, size_t chunk, const BatchValue<T,false,L>& x) {
+        T * re = planes + p*stride + chunk*L;
+        for (size_t l = 0; l < L; ++l)
+            re[l] = x.re[l];
+    }
+    template <typename T, size_t L>
+    LINEAR_BATCH_INLINE void BatchStore(T * planes, size_t stride, size_t count, size_t p, size_t chunk, const BatchValue<T,true,L>& x) {
+        T * re = planes + p*stride + chunk*L, * im = planes + (count+p)*stride + chunk*L;
+        for (size_t l = 0; l < L; ++l) {
+            re[l] = x.re[l];
+            im[l] = x.im[l];
+        }
+    }
+
+    template <typename T, size_t L>
+    LINEAR_BATCH_INLINE void BatchSet(BatchValue<T,false,L>& x, T re, T) {
+        for (size_t l = 0; l < L; ++l)
+            x.re[l] = re;
+    }
+    template <typename T, size_t L>
+    LINEAR_BATCH_INLINE void BatchSet(BatchValue<T,true,L>& x, T re, T im) {
+        for (size_t l = 0; l < L; ++l) {
+            x.re[l] = re;
+            x.im[l] = im;
+        }
+    }
+
+    // x += a*b, or x -= a*b if Subtract.
+    template <bool Subtract, typename T, size_t L>
+    LINEAR_BATCH_INLINE void BatchMulAdd(BatchValue<T,false,L>& x, const BatchValue<T,false,L>& a, const BatchValue<T,false,L>& b) {
+        for (size_t l = 0; l < L; ++l)
+            x.re[l] = (Subtract ? x.re[l] - a.re[l]*b.re[l] : x.re[l] + a.re[l]*b.re[l]);
+    }
+    template <bool Subtract, typename T, size_t L>
+    LINEAR_BATCH_INLINE void BatchMulAdd(BatchValue<T,true,L>& x, const BatchValue<T,true,L>& a, const BatchValue<T,true,L>& b) {
+        for (size_t l = 0; l < L; ++l) {
+            T re = a.re[l]*b.re[l] - a.im[l]*b.im[l], im = a.re[l]*b.im[l] + a.im[l]*b.re[l];
+            x.re[l] = (Subtract ? x.re[l] - re : x.re[l] + re);
+            x.im[l] = (Subtract ? x.im[l] - im : x.im[l] + im);
+        }
+    }
+
+    // x = a*b
+    template <typename T, size_t L>
+    LINEAR_BATCH_INLINE void BatchMul(BatchValue<T,false,L>& x, const BatchValue<T,false,L>& a, const BatchValue<T,false,L>& b) {
+        for (size_t l = 0; l < L; ++l)
+            x.re[l] = a.re[l]*b.re[l];
+    }
+    template <typename T, size_t L>
+    LINEAR_BATCH_INLINE void BatchMul(BatchValue<T,true,L>& x, const BatchValue<T,true,L>& a, const BatchValue<T,true,L>& b) {
+        for (size_t l = 0; l < L; ++l) {
+            T re = a.re[l]*b.re[l] - a.im[l]*b.im[l], im = a.re[l]*b.im[l] + a.im[l]*b.re[l];
+            x.re[l] = re;
+            x.im[l] = im;
+        }
+    }
+
+    // x = 1/a, or 1 in the lanes where a is 0 (singular lanes go on without producing infinities).
+    template <typename T, size_t L>
+    LINEAR_BATCH_INLINE void BatchReciprocal(BatchValue<T,false,L>& x, const BatchValue<T,false,L>& a) {
+        for (size_t l = 0; l < L; ++l)
+            x.re[l] = T(1)/(a.re[l] == T(0) ? T(1) : a.re[l]);
+    }
+    template <typename T, size_t L>
+    LINEAR_BATCH_INLINE void BatchReciprocal(BatchValue<T,true,L>& x, const BatchValue<T,true,L>& a) {
+        for (size_t l = 0; l < L; ++l) {
+            T n = a.re[l]*a.re[l] + a.im[l]*a.im[l];
+            bool zero = (n == T(0));
+            x.re[l] = (zero ? T(1) : a.re[l]/n);
+            x.im[l] = (zero ? T(0) : -a.im[l]/n);
+        }
+    }
+
+    // m = |re|+|im| of a, a cheap magnitude for choosing pivots.
+    template <typename T, size_t L>
+    LINEAR_BATCH_INLINE void BatchMagnitude(T * m, const BatchValue<T,false,L>& a) {
+        for (size_t l = 0; l < L; ++l)
+            m[l] = std::abs(a.re[l]);
+    }
+    template <typename T, size_t L>
+    LINEAR_BATCH_INLINE void BatchMagnitude(T * m, const BatchValue<T,true,L>& a) {
+        for (size_t l = 0; l < L; ++l)
+            m[l] = std::abs(a.re[l]) + std::abs(a.im[l]);
+    }
+
+    // Swaps x and y in the lanes whose pivot is row.
+    template <typename T, size_t L>
+    LINEAR_BATCH_INLINE void BatchSwap(BatchValue<T,false,L>& x, BatchValue<T,false,L>& y, const T * pivot, T row) {
+        for (size_t l = 0; l < L; ++l) {
+            T a = x.re[l], b = y.re[l];
+            x.re[l] = (pivot[l] == row ? b : a);
+            y.re[l] = (pivot[l] == row ? a : b);
+        }
+    }
+    template <typename T, size_t L>
+    LINEAR_BATCH_INLINE void BatchSwap(BatchValue<T,true,L>& x, BatchValue<T,true,L>& y, const T * pivot, T row) {
+        for (size_t l = 0; l < L; ++l) {
+            T a = x.re[l], b = y.re[l], c = x.im[l], d = y.im[l];
+            x.re[l] = (pivot[l] == row ? b : a);
+            y.re[l] = (pivot[l] == row ? a : b);
+            x.im[l] = (pivot[l] == row ? d : c);
+            y.im[l] = (pivot[l] == row ? c : d);
+        }
+    }
+
+    // Negates x in the lanes whose pivot is not row.
+    template <typename T, size_t L>
+    LINEAR_BATCH_INLINE void BatchNegate(BatchValue<T,false,L>& x, const T * pivot, T row) {
+        for (size_t l = 0; l < L; ++l)
+            x.re[l] = (pivot[l] != row ? -x.re[l] : x.re[l]);
+    }
+    template <typename T, size_t L>
+    LINEAR_BATCH_INLINE void BatchNegate(BatchValue<T,true,L>& x, const T * pivot, T row) {
+        for (size_t l = 0; l < L; ++l) {
+            x.re[l] = (pivot[l] != row ? -x.re[l] : x.re[l]);
+            x.im[l] = (pivot[l] != row ? -x.im[l] : x.im[l]);
+        }
+    }
+
+    /**
+     * C = A*B for the L matrices of a chunk, A MxK and B KxN, computed in the arithmetic of C.
+     */
+    template <typename T, bool CA, bool CB, bool CC, size_t M, size_t K, size_t N>
+    struct BatchMultiplyKernel {
+        static const size_t L = BatchLanes<T>::value;
+
+        LINEAR_BATCH_INLINE void operator()(size_t chunk) const {
+            BatchValue<T,CC,L> a[M*K], b[K*N];
+            LINEAR_BATCH_UNROLL
+            for (size_t p = 0; p < M*K; ++p)
+                BatchLoad<CA>(a[p], this->a, this->aStride, M*K, p, chunk);
+            LINEAR_BATCH_UNROLL
+            for (size_t p = 0; p < K*N; ++p)
+                BatchLoad<CB>(b[p], this->b, this->bStride, K*N, p, chunk);
+            LINEAR_BATCH_UNROLL
+            for (size_t i = 0; i < M; ++i) {
+                LINEAR_BATCH_UNROLL
+                for (size_t j = 0; j < N; ++j) {
+                    BatchValue<T,CC,L> sum;
+                    BatchMul(sum, a[i*K], b[j]);
+                    LINEAR_BATCH_UNROLL
+                    for (size_t p = 1; p < K; ++p)
+                        BatchMulAdd<false>(sum, a[i*K+p], b[p*N+j]);
+                    BatchStore(this->c, this->cStride, M*N, i*N+j, chunk, sum);
+                }
+            }
+        }
+
+        const T * a, * b;
+        T * c;
+        size_t aStride, bStride, cStride;
+    };
+
+    /**
+     * Gaussian elimination with partial pivoting on the NxN matrices A of a chunk, each lane choosing its own pivots.
+     * With Q > 0 the NxQ right-hand sides B are reduced alongside and replaced by the solutions X of AX=B. With Q = 0 the
+     * determinants are stored in x instead. Lanes below valid whose matrix is singular raise the singular flag.
+     */
+    template <typename T, bool CA, bool CB, bool C, size_t N, size_t Q>
+    struct BatchSolveKernel {
+        static const size_t L = BatchLanes<T>::value;
+
+        LINEAR_BATCH_INLINE void operator()(size_t chunk) const {
+            BatchValue<T,C,L> a[N*N], b[(Q > 0 ? N*Q : 1)], inverse[N], det;
+            LINEAR_BATCH_UNROLL
+            for (size_t p = 0; p < N*N; ++p)
+                BatchLoad<CA>(a[p], this->a, this->aStride, N*N, p, chunk);
+            LINEAR_BATCH_UNROLL
+            for (size_t p = 0; p < N*Q; ++p)
+                BatchLoad<CB>(b[p], this->b, this->bStride, N*Q, p, chunk);
+            BatchSet(det, T(1), T(0));
+            T singular[L] = {};
+            LINEAR_BATCH_UNROLL
+            for (size_t k = 0; k < N; ++k) {
+                // Each lane picks the row with the largest entry in column k, and swaps it into row k.
+                T best[L], pivot[L], m[L];
+                BatchMagnitude(best, a[k*N+k]);
+                for (size_t l = 0; l < L; ++l)
+                    pivot[l] = T(k);
+                LINEAR_BATCH_UNROLL
+                for (size_t i = k+1; i < N; ++i) {
+                    BatchMagnitude(m, a[i*N+k]);
+                    for (size_t l = 0; l < L; ++l) {
+                        pivot[l] = (m[l] > best[l] ? T(i) : pivot[l]);
+                        best[l] = (m[l] > best[l] ? m[l] : best[l]);
+                    }
+                }
+                LINEAR_BATCH_UNROLL
+                for (size_t i = k+1; i < N; ++i) {
+                    LINEAR_BATCH_UNROLL
+                    for (size_t j = k; j < N; ++j)
+                        BatchSwap(a[k*N+j], a[i*N+j], pivot, T(i));
+                    LINEAR_BATCH_UNROLL
+                    for (size_t j = 0; j < Q; ++j)
+                        BatchSwap(b[k*Q+j], b[i*Q+j], pivot, T(i));
+                }
+                for (size_t l = 0; l < L; ++l)
+                    singular[l] = (best[l] == T(0) ? T(1) : singular[l]);
+                BatchNegate(det, pivot, T(k));
+                BatchMul(det, det, a[k*N+k]);
+                BatchReciprocal(inverse[k], a[k*N+k]);
+                LINEAR_BATCH_UNROLL
+                for (size_t i = k+1; i < N; ++i) {
+                    BatchValue<T,C,L> f;
+                    BatchMul(f, a[i*N+k], inverse[k]);
+                    LINEAR_BATCH_UNROLL
+                    for (size_t j = k+1; j < N; ++j)
+                        BatchMulAdd<true>(a[i*N+j], f, a[k*N+j]);
+                    LINEAR_BATCH_UNROLL
+                    for (size_t j = 0; j < Q; ++j)
+                        BatchMulAdd<true>(b[i*Q+j], f, b[k*Q+j]);
+                }
+            }
+            // Lanes past the end of the batch are padding.
+            const size_t valid = std::min(size_t(L), this->count-chunk*L);
+            for (size_t l = 0; l < valid; ++l) {
+                if (singular[l] != T(0))
+                    *this->singular = true;
+            }
+            if (Q == 0) {
+                BatchStore(this->x, this->xStride, 1, 0, chunk, det);
+                return;
+            }
+            // Back substitution, row by row from the bottom.
+            LINEAR_BATCH_UNROLL
+            for (size_t r = 0; r < N; ++r) {
+                const size_t k = N-1-r;
+                LINEAR_BATCH_UNROLL
+                for (size_t j = 0; j < Q; ++j) {
+                    LINEAR_BATCH_UNROLL
+                    for (size_t i = k+1; i < N; ++i)
+                        BatchMulAdd<true>(b[k*Q+j], a[k*N+i], b[i*Q+j]);
+                    BatchMul(b[k*Q+j], b[k*Q+j], inverse[k]);
+                }
+            }
+            LINEAR_BATCH_UNROLL
+            for (size_t p = 0; p < N*Q; ++p)
+                BatchStore(this->x, this->xStride, N*Q, p, chunk, b[p]);
+        }
+
+        const T * a, * b;
+        T * x;
+        size_t aStride, bStride, xStride, count;
+        std::atomic<bool> * singular;
+    };
+
+    /**
+     * Calls kernel(chunk) for chunks [begin, end). Every instruction set gets its own copy of the loop, compiled for it
+     * through the target attribute; the kernel is inlined into it, so its loops over the lanes use that instruction set's
+     * vectors. Only the copy for the detected instruction set runs.
+     */
+    template <typename Kernel>
+    void BatchLoopPortable(const Kernel& kernel, size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; ++chunk)
+            kernel(chunk);
+    }
+#if defined(LINEAR_SIMD_X86)
+    template <typename Kernel>
+    LINEAR_TARGET_AVX2 void BatchLoopAVX2(const Kernel& kernel, size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; ++chunk)
+            kernel(chunk);
+    }
+    template <typename Kernel>
+    LINEAR_TARGET_AVX512 void BatchLoopAVX512(const Kernel& kernel, size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; ++chunk)
+            kernel(chunk);
+    }
+#endif
+    template <typename Kernel>
+    void BatchLoop(const Kernel& kernel, size_t begin, size_t end) {
+        switch (DetectSimdLevel()) {
+#if defined(LINEAR_SIMD_X86)
+        case SimdAVX512:
+            BatchLoopAVX512(kernel, begin, end);
+            break;
+        case SimdAVX2:
+            BatchLoopAVX2(kernel, begin, end);
+            break;
+#endif
+        default:
+            BatchLoopPortable(kernel, begin, end);
+        }
+    }
+#undef LINEAR_BATCH_INLINE
+#undef LINEAR_BATCH_UNROLL
+
+    /**
+     * Runs kernel over the chunks of a batch of count matrices, each taking about work multiply-adds, on the shared
+     * thread pool if the batch is large.
+     */
+    template <typename Kernel>
+    void RunBatchKernel(const Kernel& kernel, size_t count, size_t work) {
+        const size_t L = Kernel::L, chunks = (count+L-1)/L;
+        const size_t threads = GetNumThreads();
+        if (count*work < LINEAR_PARALLEL_THRESHOLD || threads == 1 || chunks < 2) {
+            BatchLoop(kernel, 0, chunks);
+            return;
+        }
+        const size_t tasks = std::min(chunks, 4*threads), size = (chunks+tasks-1)/tasks;
+        GetThreadPool()->ParallelFor((chunks+size-1)/size, [&](size_t t) {
+            BatchLoop(kernel, t*size, std::min(chunks, (t+1)*size));
+        });
+    }
+
+    template <typename T, size_t M, size_t N, unsigned int Flags, size_t P, size_t Q, unsigned int Flags2>
+    using BatchProduct = Batch<Matrix<T,M,Q,((Flags & RealStorage) && (Flags2 & RealStorage) ? RealStorage : 0) | (Flags & ColumnMajor)>>;
+    /// \endcond
+
+    /**
+     * Computes \f$C_i=A_iB_i\f$ for every i. If the batches have different sizes an exception is raised. The result only
+     * uses real storage if both A and B do.
+     * @param A Batch of MxN matrices
+     * @param B Batch of NxQ matrices
+     * @return Batch of MxQ matrices
+     */
+    template <typename T, size_t M, size_t N, unsigned int Flags, size_t Q, unsigned int Flags2>
+    BatchProduct<T,M,N,Flags,N,Q,Flags2> operator*(const Batch<Matrix<T,M,N,Flags>>& A, const Batch<Matrix<T,N,Q,Flags2>>& B) {
+        typedef BatchProduct<T,M,N,Flags,N,Q,Flags2> Result;
+        if (A.Size() != B.Size())
+            throw "Cannot multiply two batches of different sizes.";
+        Result C(A.Size());
+        BatchMultiplyKernel<T,!(Flags & RealStorage),!(Flags2 & RealStorage),Result::IsComplex,M,N,Q> kernel;
+        kernel.a = A.Plane(0);
+        kernel.b = B.Plane(0);
+        kernel.c = C.Plane(0);
+        kernel.aStride = A.Stride();
+        kernel.bStride = B.Stride();
+        kernel.cStride = C.Stride();
+        RunBatchKernel(kernel, A.Size(), M*N*Q);
+        return C;
+    }
+
+    /**
+     * Computes the transpose of every matrix of the batch. Each plane is copied whole.
+     * @param A Batch of MxN matrices
+     * @return Batch of NxM matrices
+     */
+    template <typename T, size_t M, size_t N, unsigned int Flags>
+    Batch<Matrix<T,N,M,Flags>> Transpose(const Batch<Matrix<T,M,N,Flags>>& A) {
+        Batch<Matrix<T,N,M,Flags>> B(A.Size());
+        const size_t parts = ((Flags & RealStorage) ? 1 : 2);
+        for (size_t part = 0; part < parts; ++part) {
+            for (size_t r = 0; r < M; ++r) {
+                for (size_t c = 0; c < N; ++c) {
+                    const T * src = A.Plane(part*M*N + r*N+c);
+                    std::copy(src, src+A.Size(), B.Plane(part*M*N + c*M+r));
+                }
+            }
+        }
+        return B;
+    }
+
+    /**
+     * Computes the determinant of every matrix of the batch, by Gaussian elimination with partial pivoting.
+     * @param A Batch of NxN matrices
+     * @return Determinants, in the order of the batch
+     */
+    template <typename T, size_t N, unsigned int Flags>
+    std::vector<Complex<T>> Determinant(const Batch<Matrix<T,N,N,Flags>>& A) {
+        Batch<Matrix<T,1,1,Flags & RealStorage>> det(A.Size());
+        std::atomic<bool> singular(false);
+        BatchSolveKernel<T,!(Flags & RealStorage),false,!(Flags & RealStorage),N,0> kernel;
+        kernel.a = A.Plane(0);
+        kernel.b = NULL;
+        kernel.x = det.Plane(0);
+        kernel.aStride = A.Stride();
+        kernel.bStride = 0;
+        kernel.xStride = det.Stride();
+        kernel.count = A.Size();
+        kernel.singular = &singular;
+        RunBatchKernel(kernel, A.Size(), N*N*N/3+1);
+        std::vector<Complex<T>> ret(A.Size());
+        const T * re = det.RealData(0,0), * im = ((Flags & RealStorage) ? NULL : det.ImagData(0,0));
+        for (size_t i = 0; i < A.Size(); ++i)
+            ret[i] = Complex<T>(re[i], (im ? im[i] : T(0)));
+        return ret;
+    }
+
+    /**
+     * Solves \f$A_iX_i=B_i\f$ for every i, by Gaussian elimination with partial pivoting. If the batches have different
+     * sizes, or any A_i is singular, an exception is raised.
+     * @param A Batch of NxN matrices
+     * @param B Batch of NxQ matrices (Q = 1 for vectors)
+     * @return Batch of NxQ matrices
+     */
+    template <typename T, size_t N, unsigned int Flags, size_t Q, unsigned int Flags2>
+    BatchProduct<T,N,N,Flags,N,Q,Flags2> Solve(const Batch<Matrix<T,N,N,Flags>>& A, const Batch<Matrix<T,N,Q,Flags2>>& B) {
+        typedef BatchProduct<T,N,N,Flags,N,Q,Flags2> Result;
+        if (A.Size() != B.Size())
+            throw "Cannot solve batches of different sizes.";
+        Result X(A.Size());
+        std::atomic<bool> singular(false);
+        BatchSolveKernel<T,!(Flags & RealStorage),!(Flags2 & RealStorage),Result::IsComplex,N,Q> kernel;
+        kernel.a = A.Plane(0);
+        kernel.b = B.Plane(0);
+        kernel.x = X.Plane(0);
+        kernel.aStride = A.Stride();
+        kernel.bStride = B.Stride();
+        kernel.xStride = X.Stride();
+        kernel.count = A.Size();
+        kernel.singular = &singular;
+        RunBatchKernel(kernel, A.Size(), N*N*(N/3+Q)+1);
+        if (singular)
+            throw "No solution.";
+        return X;
+    }
+
+    /**
+     * Computes the inverse of every matrix of the batch, by solving against the identity. If any matrix is singular, an
+     * exception is thrown.
+     * @param A Batch of NxN matrices
+     * @return Batch of NxN matrices
+     */
+    template <typename T, size_t N, unsigned int Flags>
+    Batch<Matrix<T,N,N,Flags>> Inverse(const Batch<Matrix<T,N,N,Flags>>& A) {
+        Matrix<T,N,N,Flags> identity;
+        for (size_t i = 0; i < N; ++i)
+            identity(i,i) = T(1);
+        try {
+            return Solve(A, Batch<Matrix<T,N,N,Flags>>(A.Size(), identity));
+        }
+        catch (const char *) {
+            throw "Cannot take the inverse of a singular matrix.";
+        }
+    }
+}
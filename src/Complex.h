@@ -1,6 +1,7 @@
 #pragma once
 #include <ostream>
 #include <cmath>
+#include <type_traits>
 
 namespace Linear {
     /**
@@ -277,6 +278,15 @@ namespace Linear {
     using Complexf = Complex<float>;
     using Complexd = Complex<double>;
 
+    /**
+     * Checks if a real number is real.
+     * @param x Real number.
+     * @return Returns true.
+     */
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value>::type* = nullptr>
+    bool IsReal(T) {
+        return true;
+    }
     /**
      * Checks if a complex number \f$z=a+bi\f$ is real.
      * @param z Complex number.
@@ -337,6 +347,15 @@ namespace Linear {
         return z / Abs(z);
     }
 
+    /**
+     * Takes a real number \f$x\f$ and computes \f$arg(x)=atan2(0,x)\f$.
+     * @param x Real number.
+     * @return Real number.
+     */
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value>::type* = nullptr>
+    T Arg(T x) {
+        return std::atan2(T(0),x);
+    }
     /**
      * Takes a complex number \f$z=a+bi\f$ and computes \f$arg(z)=atan2(b,a)\f$.
      * @param z Complex number.
@@ -347,6 +366,15 @@ namespace Linear {
         return std::atan2(z.Im,z.Re);
     }
 
+    /**
+     * Takes a real number \f$x\f$ and computes it's conjugate \f$\bar{x}=x\f$.
+     * @param x Real number.
+     * @return Real number.
+     */
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value>::type* = nullptr>
+    T Conjugate(T x) {
+        return x;
+    }
     /**
      * Takes a complex number \f$z=a+bi\f$ and computes it's conjugate \f$\bar{z}=a-bi\f$.
      * @param z Complex number.
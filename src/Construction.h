@@ -235,7 +235,7 @@ namespace Linear {
         Matrix<T,M,N,Flags> ret(T(0));
         for (size_t r = 0; r < ret.NumRows(); ++r) {
             for (size_t c = 0; c < ret.NumColumns(); ++c) {
-                ret(r,c) = Complex<T>(distrRe(random_number_generator), distrIm(random_number_generator));
+                ret(r,c) = ret.ToScalar(Complex<T>(distrRe(random_number_generator), distrIm(random_number_generator)));
             }
         }
         return ret;
@@ -258,7 +258,7 @@ namespace Linear {
         Matrix<T,Dynamic,Dynamic,Flags> ret(nrows, ncols, T(0));
         for (size_t r = 0; r < ret.NumRows(); ++r) {
             for (size_t c = 0; c < ret.NumColumns(); ++c) {
-                ret(r,c) = Complex<T>(distrRe(random_number_generator), distrIm(random_number_generator));
+                ret(r,c) = ret.ToScalar(Complex<T>(distrRe(random_number_generator), distrIm(random_number_generator)));
             }
         }
         return ret;
@@ -312,21 +312,17 @@ namespace Linear {
      * @return M1x(N1+N2) Matrix
      */
     template<typename T, size_t M1, size_t N1, unsigned int Flags1, size_t M2, size_t N2, unsigned int Flags2>
-    typename std::enable_if<(M1==M2||M1==Dynamic||M2==Dynamic), Matrix<T,M1,(N1==Dynamic||N2==Dynamic?Dynamic:N1+N2),Flags1>>::type
+    typename std::enable_if<(M1==M2||M1==Dynamic||M2==Dynamic), Matrix<T,M1,(N1==Dynamic||N2==Dynamic?Dynamic:N1+N2),PromoteFlags(Flags1,Flags2)>>::type
     Augmented(const Matrix<T,M1,N1,Flags1>& left, const Matrix<T,M2,N2,Flags2>& right) {
         if (left.NumRows() != right.NumRows())
             throw "Malformed augmented matrix. Differing number of rows.";
-        Matrix<T,M1,(N1==Dynamic||N2==Dynamic?Dynamic:N1+N2),Flags1> ret(left.NumRows(),left.NumColumns()+right.NumColumns(),T(0));
-        for (size_t r = 0; r < left.NumRows(); ++r) {
-            for (size_t c = 0; c < left.NumColumns(); ++c) {
-                ret(r,c) = left(r,c);
-            }
-        }
-        for (size_t r = 0; r < right.NumRows(); ++r) {
-            for (size_t c = 0; c < right.NumColumns(); ++c) {
-                ret(r,c+left.NumColumns()) = right(r,c);
-            }
-        }
+        Matrix<T,M1,(N1==Dynamic||N2==Dynamic?Dynamic:N1+N2),PromoteFlags(Flags1,Flags2)> ret(left.NumRows(),left.NumColumns()+right.NumColumns(),T(0));
+        ForEachIndex<(Flags1 & ColumnMajor) != 0, false>(left.NumRows(), left.NumColumns(), [&](size_t r, size_t c) {
+            ret.At(r,c) = left.At(r,c);
+        });
+        ForEachIndex<(Flags1 & ColumnMajor) != 0, ((Flags1 ^ Flags2) & ColumnMajor) != 0>(right.NumRows(), right.NumColumns(), [&](size_t r, size_t c) {
+            ret.At(r,c+left.NumColumns()) = right.At(r,c);
+        });
         return ret;
     }
     /**
@@ -338,21 +334,17 @@ namespace Linear {
      * @return (M1+M2)xN1 Matrix
      */
     template<typename T, size_t M1, size_t N1, unsigned int Flags1, size_t M2, size_t N2, unsigned int Flags2>
-    typename std::enable_if<(N1==N2||N1==Dynamic||N2==Dynamic), Matrix<T,(M1==Dynamic||M2==Dynamic?Dynamic:M1+M2),N1,Flags1>>::type
+    typename std::enable_if<(N1==N2||N1==Dynamic||N2==Dynamic), Matrix<T,(M1==Dynamic||M2==Dynamic?Dynamic:M1+M2),N1,PromoteFlags(Flags1,Flags2)>>::type
     RowAugmented(const Matrix<T,M1,N1,Flags1>& top, const Matrix<T,M2,N2,Flags2>& bottom) {
         if (top.NumColumns() != bottom.NumColumns())
             throw "Malformed row augmented matrix. Differing number of columns.";
-        Matrix<T,(M1==Dynamic||M2==Dynamic?Dynamic:M1+M2),N1,Flags1> ret(top.NumRows()+bottom.NumRows(),top.NumColumns(),T(0));
-        for (size_t r = 0; r < top.NumRows(); ++r) {
-            for (size_t c = 0; c < top.NumColumns(); ++c) {
-                ret(r,c) = top(r,c);
-            }
-        }
-        for (size_t r = 0; r < bottom.NumRows(); ++r) {
-            for (size_t c = 0; c < bottom.NumColumns(); ++c) {
-                ret(r+top.NumRows(),c) = bottom(r,c);
-            }
-        }
+        Matrix<T,(M1==Dynamic||M2==Dynamic?Dynamic:M1+M2),N1,PromoteFlags(Flags1,Flags2)> ret(top.NumRows()+bottom.NumRows(),top.NumColumns(),T(0));
+        ForEachIndex<(Flags1 & ColumnMajor) != 0, false>(top.NumRows(), top.NumColumns(), [&](size_t r, size_t c) {
+            ret.At(r,c) = top.At(r,c);
+        });
+        ForEachIndex<(Flags1 & ColumnMajor) != 0, ((Flags1 ^ Flags2) & ColumnMajor) != 0>(bottom.NumRows(), bottom.NumColumns(), [&](size_t r, size_t c) {
+            ret.At(r+top.NumRows(),c) = bottom.At(r,c);
+        });
         return ret;
     }
 
@@ -371,11 +363,11 @@ namespace Linear {
             size_t M3, size_t N3, unsigned int Flags3,
             size_t M4, size_t N4, unsigned int Flags4>
     typename std::enable_if<((M1+M3==M2+M4||M1==Dynamic||M2==Dynamic||M3==Dynamic||M4==Dynamic)&&(N1+N2==N3+N4||N1==Dynamic||N2==Dynamic||N3==Dynamic||N4==Dynamic)),
-        Matrix<T,(M1==Dynamic||M2==Dynamic||M3==Dynamic||M4==Dynamic?Dynamic:M1+M3),(N1==Dynamic||N2==Dynamic||N3==Dynamic||N4==Dynamic?Dynamic:N1+N2),Flags1>>::type
+        Matrix<T,(M1==Dynamic||M2==Dynamic||M3==Dynamic||M4==Dynamic?Dynamic:M1+M3),(N1==Dynamic||N2==Dynamic||N3==Dynamic||N4==Dynamic?Dynamic:N1+N2),PromoteFlags(PromoteFlags(PromoteFlags(Flags1,Flags2),Flags3),Flags4)>>::type
     Block(const Matrix<T,M1,N1,Flags1>& tl, const Matrix<T,M2,N2,Flags2>& tr, const Matrix<T,M3,N3,Flags3>& bl, const Matrix<T,M4,N4,Flags4>& br) {
         if (tl.NumRows()+bl.NumRows() != tr.NumRows()+br.NumRows() || tl.NumColumns()+tr.NumColumns() != bl.NumColumns()+br.NumColumns())
             throw "Malformed block matrix. Sizes don't add up equally.";
-        Matrix<T,(M1==Dynamic||M2==Dynamic||M3==Dynamic||M4==Dynamic?Dynamic:M1+M3),(N1==Dynamic||N2==Dynamic||N3==Dynamic||N4==Dynamic?Dynamic:N1+N2),Flags1> ret(tl.NumRows()+bl.NumRows(),tl.NumColumns()+tr.NumColumns());
+        Matrix<T,(M1==Dynamic||M2==Dynamic||M3==Dynamic||M4==Dynamic?Dynamic:M1+M3),(N1==Dynamic||N2==Dynamic||N3==Dynamic||N4==Dynamic?Dynamic:N1+N2),PromoteFlags(PromoteFlags(PromoteFlags(Flags1,Flags2),Flags3),Flags4)> ret(tl.NumRows()+bl.NumRows(),tl.NumColumns()+tr.NumColumns());
         for (size_t r = 0; r < tl.NumRows(); ++r) {
             for (size_t c = 0; c < tl.NumColumns(); ++c) {
                 ret(r,c) = tl(r,c);
@@ -413,9 +405,9 @@ namespace Linear {
      */
     template<typename T, size_t M, size_t N, unsigned int Flags, size_t P, size_t Q>
     typename std::enable_if<((M==P||M==Dynamic||P==Dynamic)&&(N==Q||N==Dynamic||Q==Dynamic)),
-        Matrix<T,(M==Dynamic?Dynamic:M+1),(N==Dynamic?Dynamic:N+1),Flags>>::type
+        Matrix<T,(M==Dynamic?Dynamic:M+1),(N==Dynamic?Dynamic:N+1),Flags & ~RealStorage>>::type
     Block(const Matrix<T,M,N,Flags>& tl, const Vector<T,P>& tr, const RowVector<T,Q>& bl, Complex<T> br) {
-        return Block(tl, tr, bl, Matrix<T,1,1,Flags>(br));
+        return Block(tl, tr, bl, Matrix<T,1,1,Flags & ~RealStorage>(br));
     }
     /**
      * Creates the (M+1)x(N+1) block matrix
@@ -429,9 +421,9 @@ namespace Linear {
      */
     template<typename T, size_t M, size_t N, unsigned int Flags, size_t P, size_t Q>
     typename std::enable_if<((M==P||M==Dynamic||P==Dynamic)&&(N==Q||N==Dynamic||Q==Dynamic)),
-        Matrix<T,(M==Dynamic?Dynamic:M+1),(N==Dynamic?Dynamic:N+1),Flags>>::type
+        Matrix<T,(M==Dynamic?Dynamic:M+1),(N==Dynamic?Dynamic:N+1),Flags & ~RealStorage>>::type
     Block(Complex<T> tl, const RowVector<T,Q>& tr, const Vector<T,P>& bl, const Matrix<T,M,N,Flags>& br) {
-        return Block(Matrix<T,1,1,Flags>(tl), tr, bl, br);
+        return Block(Matrix<T,1,1,Flags & ~RealStorage>(tl), tr, bl, br);
     }
 
     /**
@@ -448,13 +440,11 @@ namespace Linear {
      * @return (MP)x(NQ) Matrix
      */
     template<typename T, size_t M, size_t N, unsigned int Flags1, size_t P, size_t Q, unsigned int Flags2>
-    Matrix<T,M*P,Q*N,Flags1> Kronecker(const Matrix<T,M,N,Flags1>& A, const Matrix<T,P,Q,Flags2>& B) {
-        Matrix<T,M*P,Q*N,Flags1> ret(A.NumRows()*B.NumRows(), A.NumColumns()*B.NumColumns(), T(0));
-        for (size_t r = 0; r < ret.NumRows(); ++r) {
-            for (size_t c = 0; c < ret.NumColumns(); ++c) {
-                ret(r,c) = A(r/B.NumRows(),c/B.NumColumns())*B(r%B.NumRows(),c%B.NumColumns());
-            }
-        }
+    Matrix<T,M*P,Q*N,PromoteFlags(Flags1,Flags2)> Kronecker(const Matrix<T,M,N,Flags1>& A, const Matrix<T,P,Q,Flags2>& B) {
+        Matrix<T,M*P,Q*N,PromoteFlags(Flags1,Flags2)> ret(A.NumRows()*B.NumRows(), A.NumColumns()*B.NumColumns(), T(0));
+        ForEachIndex<(Flags1 & ColumnMajor) != 0, false>(ret.NumRows(), ret.NumColumns(), [&](size_t r, size_t c) {
+            ret.At(r,c) = A.At(r/B.NumRows(),c/B.NumColumns())*B.At(r%B.NumRows(),c%B.NumColumns());
+        });
         return ret;
     }
     /**
@@ -468,17 +458,17 @@ namespace Linear {
      * @return (NQ)x(NQ) Matrix
      */
     template<typename T, size_t M, size_t N, unsigned int Flags1, size_t P, size_t Q, unsigned int Flags2>
-    SquareMatrix<T,N*Q,Flags1> KroneckerSum(const Matrix<T,M,N,Flags1>& A, const Matrix<T,P,Q,Flags2>& B) {
+    SquareMatrix<T,N*Q,PromoteFlags(Flags1,Flags2)> KroneckerSum(const Matrix<T,M,N,Flags1>& A, const Matrix<T,P,Q,Flags2>& B) {
         if (!IsSquare(A) || !IsSquare(B))
             throw "The Kronecker sum is only defined for two square matrices.";
         if (A.NumEntries() == 0 || B.NumEntries() == 0) {
-            SquareMatrix<T,N*Q,Flags1> ret(T(0));
+            SquareMatrix<T,N*Q,PromoteFlags(Flags1,Flags2)> ret(T(0));
             return ret;
         }
         SquareMatrix<T,Dynamic,Flags1> In = Identity<T,Flags1>(A.NumRows());
         SquareMatrix<T,Dynamic,Flags1> Iq = Identity<T,Flags1>(B.NumRows());
         SquareMatrix<T,N*Q,Flags1> first = Kronecker(A, Iq);
-        SquareMatrix<T,N*Q,Flags2> second = Kronecker(In, B);
+        SquareMatrix<T,N*Q,PromoteFlags(Flags1,Flags2)> second = Kronecker(In, B);
         return first+second;
     }
 
@@ -492,18 +482,14 @@ namespace Linear {
      * @return (M1+M2)x(N1+N2) Matrix
      */
     template<typename T, size_t M1, size_t N1, unsigned int Flags1, size_t M2, size_t N2, unsigned int Flags2>
-    Matrix<T,(M1==Dynamic||M2==Dynamic?Dynamic:M1+M2),(N1==Dynamic||N2==Dynamic?Dynamic:N1+N2),Flags1> Diag(const Matrix<T,M1,N1,Flags1>& A, const Matrix<T,M2,N2,Flags2>& B) {
-        Matrix<T,(M1==Dynamic||M2==Dynamic?Dynamic:M1+M2),(N1==Dynamic||N2==Dynamic?Dynamic:N1+N2),Flags1> ret(A.NumRows()+B.NumRows(),A.NumColumns()+B.NumColumns(),T(0));
-        for (size_t r = 0; r < ret.NumRows(); ++r) {
-            for (size_t c = 0; c < ret.NumColumns(); ++c) {
-                if (r < A.NumRows() && c < A.NumColumns())
-                    ret(r,c) = A(r,c);
-                else if (r >= A.NumRows() && c >= A.NumColumns())
-                    ret(r,c) = B(r-A.NumRows(),c-A.NumColumns());
-                else
-                    ret(r,c) = T(0);
-            }
-        }
+    Matrix<T,(M1==Dynamic||M2==Dynamic?Dynamic:M1+M2),(N1==Dynamic||N2==Dynamic?Dynamic:N1+N2),PromoteFlags(Flags1,Flags2)> Diag(const Matrix<T,M1,N1,Flags1>& A, const Matrix<T,M2,N2,Flags2>& B) {
+        Matrix<T,(M1==Dynamic||M2==Dynamic?Dynamic:M1+M2),(N1==Dynamic||N2==Dynamic?Dynamic:N1+N2),PromoteFlags(Flags1,Flags2)> ret(A.NumRows()+B.NumRows(),A.NumColumns()+B.NumColumns(),T(0));
+        ForEachIndex<(Flags1 & ColumnMajor) != 0, false>(A.NumRows(), A.NumColumns(), [&](size_t r, size_t c) {
+            ret.At(r,c) = A.At(r,c);
+        });
+        ForEachIndex<(Flags1 & ColumnMajor) != 0, ((Flags1 ^ Flags2) & ColumnMajor) != 0>(B.NumRows(), B.NumColumns(), [&](size_t r, size_t c) {
+            ret.At(r+A.NumRows(),c+A.NumColumns()) = B.At(r,c);
+        });
         return ret;
     }
     /**
@@ -518,12 +504,10 @@ namespace Linear {
     template<typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,(M==Dynamic?Dynamic:M+1),(N==Dynamic?Dynamic:N+1),Flags> Diag(const Matrix<T,M,N,Flags>& A, Complex<T> z) {
         Matrix<T,(M==Dynamic?Dynamic:M+1),(N==Dynamic?Dynamic:N+1),Flags> ret(A.NumRows()+1,A.NumColumns()+1,T(0));
-        for (size_t r = 0; r < A.NumRows(); ++r) {
-            for (size_t c = 0; c < A.NumColumns(); ++c) {
-                ret(r,c) = A(r,c);
-            }
-        }
-        ret(ret.NumRows()-1,ret.NumColumns()-1) = z;
+        ForEachIndex<(Flags & ColumnMajor) != 0, false>(A.NumRows(), A.NumColumns(), [&](size_t r, size_t c) {
+            ret.At(r,c) = A.At(r,c);
+        });
+        ret(ret.NumRows()-1,ret.NumColumns()-1) = ret.ToScalar(z);
         return ret;
     }
     /**
@@ -539,8 +523,8 @@ namespace Linear {
     template<typename T, unsigned int Flags=0>
     Matrix<T,2,2,Flags> Diag(Complex<T> z, Complex<T> w) {
         Matrix<T,2,2,Flags> ret(T(0));
-        ret(0,0) = z;
-        ret(1,1) = w;
+        ret(0,0) = ret.ToScalar(z);
+        ret(1,1) = ret.ToScalar(w);
         return ret;
     }
     template<typename T, size_t M1, size_t N1, unsigned int Flags1, size_t M2, size_t N2, unsigned int Flags2, typename... Ts>
@@ -568,7 +552,7 @@ namespace Linear {
             throw "Cannot create a diagonal matrix based on a empty list.";
         SquareMatrix<T,Dynamic,Flags> ret(v.size(), v.size(), T(0));
         for (size_t i = 0; i < v.size(); ++i)
-            ret(i,i) = v[i];
+            ret(i,i) = ret.ToScalar(v[i]);
         return ret;
     }
     /**
@@ -602,7 +586,7 @@ namespace Linear {
     SquareMatrix<T,N> Diag(Vector<T,N> v) {
         SquareMatrix<T,N,Flags> ret(v.NumRows(), v.NumRows(), T(0));
         for (size_t i = 0; i < v.Length(); ++i)
-            ret(i,i) = v[i];
+            ret(i,i) = ret.ToScalar(v[i]);
         return ret;
     }
     /**
@@ -646,7 +630,7 @@ namespace Linear {
         for (size_t i = 0; i < ret.NumColumns()-1; ++i)
             ret(i+1,i) = T(1);
         for (size_t i = 0; i < ret.NumColumns(); ++i)
-            ret(i,ret.NumColumns()-1) = -c[i]/c[c.Length()-1];
+            ret(i,ret.NumColumns()-1) = ret.ToScalar(-c[i]/c[c.Length()-1]);
         return ret;
     }
     /**
@@ -691,7 +675,7 @@ namespace Linear {
     SquareMatrix<T,(N==Dynamic?Dynamic:N+1),Flags> Translation(const Vector<T,N>& t) {
         SquareMatrix<T,(N==Dynamic?Dynamic:N+1),Flags> ret = Identity<T,Flags>(t.Length()+1);
         for (size_t i = 0; i < t.Length(); ++i) {
-            ret(i,t.Length()-1) = t[i];
+            ret(i,t.Length()) = ret.ToScalar(t[i]);
         }
         return ret;
     }
@@ -714,7 +698,7 @@ namespace Linear {
     SquareMatrix<T,N,Flags> Scaling(const Vector<T,N>& s) {
         SquareMatrix<T,N,Flags> ret = Zero<T,Flags>(s.Length(), s.Length());
         for (size_t i = 0; i < s.Length(); ++i) {
-            ret(i,i) = s[i];
+            ret(i,i) = ret.ToScalar(s[i]);
         }
         return ret;
     }
@@ -815,15 +799,18 @@ namespace Linear {
         Complex<T> x = axis[0], y = axis[1], z = axis[2];
         T c = Cos(theta);
         T s = Sin(theta);
-        SquareMatrix<T,4,Flags> ret = {
-            { c+x*x*(1-c), x*y*(1-c)-z*s, x*z*(1-c)+y*s, 0 },
-            { y*x*(1-c)+z*s, c+y*y*(1-c), y*z*(1-c)-x*s, 0 },
-            { z*x*(1-c)-y*s, z*y*(1-c)+z*s, c+z*z*(1-c), 0 },
-            { 0, 0, 0, 1 }
-        };
-        if (N == 4)
-            return ret;
-        return RemoveRowAndColumn(ret, 3, 3);
+        // The 3x3 rotation is written straight into the identity, which is the rest of the 4x4 matrix.
+        SquareMatrix<T,N,Flags> ret = Identity<T,N,Flags>();
+        ret(0,0) = ret.ToScalar(c+x*x*(1-c));
+        ret(0,1) = ret.ToScalar(x*y*(1-c)-z*s);
+        ret(0,2) = ret.ToScalar(x*z*(1-c)+y*s);
+        ret(1,0) = ret.ToScalar(y*x*(1-c)+z*s);
+        ret(1,1) = ret.ToScalar(c+y*y*(1-c));
+        ret(1,2) = ret.ToScalar(y*z*(1-c)-x*s);
+        ret(2,0) = ret.ToScalar(z*x*(1-c)-y*s);
+        ret(2,1) = ret.ToScalar(z*y*(1-c)+x*s);
+        ret(2,2) = ret.ToScalar(c+z*z*(1-c));
+        return ret;
     }
     /**
      * Computes the 4x4 rotatation matrix given a quaternion q.
@@ -837,19 +824,18 @@ namespace Linear {
     typename std::enable_if<((N==3||N==4)&&(P==4||P==Dynamic)), SquareMatrix<T,N,Flags>>::type Rotation(Vector<T,P> q) {
         if (q.Length() != 4)
             throw "Quaternion q should be length 4.";
-        T q0 = q[0];
-        T q1 = q[1];
-        T q2 = q[2];
-        T q3 = q[3];
-        SquareMatrix<T,4,Flags> ret = {
-            { 1-2*(q2*q2+q3*q3), 2*(q1*q2-q0*q3), 2*(q0*q2+q1*q3), 0 },
-            {   2*(q1*q2+q0*q3), 1-2*(q1*q1+q3*q3), 2*(q2*q3-q0*q1), 0 },
-            {   2*(q1*q3-q0*q2), 2*(q0*q1+q2*q3), 1-2*(q1*q1+q2*q2), 0 },
-            { 0, 0, 0, 1 }
-        };
-        if (N == 4)
-            return ret;
-        return RemoveRowAndColumn(ret, 3, 3);
+        Complex<T> q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+        SquareMatrix<T,N,Flags> ret = Identity<T,N,Flags>();
+        ret(0,0) = ret.ToScalar(T(1)-T(2)*(q2*q2+q3*q3));
+        ret(0,1) = ret.ToScalar(T(2)*(q1*q2-q0*q3));
+        ret(0,2) = ret.ToScalar(T(2)*(q0*q2+q1*q3));
+        ret(1,0) = ret.ToScalar(T(2)*(q1*q2+q0*q3));
+        ret(1,1) = ret.ToScalar(T(1)-T(2)*(q1*q1+q3*q3));
+        ret(1,2) = ret.ToScalar(T(2)*(q2*q3-q0*q1));
+        ret(2,0) = ret.ToScalar(T(2)*(q1*q3-q0*q2));
+        ret(2,1) = ret.ToScalar(T(2)*(q0*q1+q2*q3));
+        ret(2,2) = ret.ToScalar(T(1)-T(2)*(q1*q1+q2*q2));
+        return ret;
     }
     /**
      * Computes the 4x4 orthographic projection matrix.
@@ -901,16 +887,28 @@ namespace Linear {
      */
     template <typename T, size_t N1, size_t N2, size_t N3, size_t N4, unsigned int Flags=0>
     typename std::enable_if<((N1==3||N1==Dynamic)||(N2==3||N2==Dynamic)||(N3==3||N3==Dynamic)||(N4==3||N4==Dynamic)), SquareMatrix<T,4,Flags>>::type
-    LookAt(Vector<T,N1> right, Vector<T,N2> up, Vector<T,N3> dir, Vector<T,N4> eye) {
+    LookAt(const Vector<T,N1>& right, const Vector<T,N2>& up, const Vector<T,N3>& dir, const Vector<T,N4>& eye) {
         if (right.Length() != 3 || up.Length() != 3 || dir.Length() != 3 || eye.Length() != 3)
             throw "All vectors in LookAt should be length 3.";
 
-        SquareMatrix<T,4,Flags> ret = {
-            { right[0], right[1], right[2], 0 },
-            { up[0], up[1], up[2], 0 },
-            { dir[0], dir[1], dir[2], 0 },
-            { 0, 0, 0, 1 }
-        };
-        return ret*Translation(-eye);
+        // The product of the rotation with Translation(-eye), written out: the last column is -R*eye.
+        SquareMatrix<T,4,Flags> ret = Identity<T,4,Flags>();
+        for (size_t c = 0; c < 3; ++c) {
+            ret(0,c) = ret.ToScalar(right[c]);
+            ret(1,c) = ret.ToScalar(up[c]);
+            ret(2,c) = ret.ToScalar(dir[c]);
+        }
+        ret(0,3) = ret.ToScalar(-(right[0]*eye[0] + right[1]*eye[1] + right[2]*eye[2]));
+        ret(1,3) = ret.ToScalar(-(up[0]*eye[0] + up[1]*eye[1] + up[2]*eye[2]));
+        ret(2,3) = ret.ToScalar(-(dir[0]*eye[0] + dir[1]*eye[1] + dir[2]*eye[2]));
+        return ret;
     }
+
+    // Accept unevaluated expressions, e.g. Augmented(A - B).
+    LINEAR_EVALUATE_EXPRESSIONS(Augmented)
+    LINEAR_EVALUATE_EXPRESSIONS(RowAugmented)
+    LINEAR_EVALUATE_EXPRESSIONS(Block)
+    LINEAR_EVALUATE_EXPRESSIONS(Kronecker)
+    LINEAR_EVALUATE_EXPRESSIONS(KroneckerSum)
+    LINEAR_EVALUATE_EXPRESSIONS(Diag)
 }
@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <vector>
 #include <tuple>
 #include "Matrix.h"
@@ -37,6 +38,14 @@ namespace Linear {
         LUP(const Matrix<T,P,Q,Flags2>& A) {
             Compute(A);
         }
+        /**
+         * Constructor. Evaluates the expression A (e.g. B - C) and calls Compute.
+         * @param A Matrix expression
+         */
+        template <typename E>
+        LUP(const MatrixExpression<E>& A) {
+            Compute(A.Eval());
+        }
         /**
          * Computes the LUP decomposition. If A is not square or Q != N, then an exception is thrown.
          * @param A PxQ Matrix
@@ -56,7 +65,7 @@ namespace Linear {
                 T Amax = T(0);
                 size_t imax = i;
                 for (size_t j = i; j < A.NumRows(); ++j) {
-                    Complex<T> Aii=A(j,i);
+                    typename Matrix<T,P,Q,Flags2>::Scalar Aii=A(j,i);
                     for (size_t q = 0; q < i; ++q) {
                         Aii -= A(j, q)*A(q, j);
                     }
@@ -86,7 +95,7 @@ namespace Linear {
             }
 
             // Get the U matrix.
-            this->U = A + Zero<T,Flags>(A.NumRows(), A.NumRows()); // to avoid move operator.
+            this->U = A;
             for (size_t c = 0; c < A.NumColumns(); ++c) {
                 for (size_t r=c+1; r < A.NumRows(); ++r)
                     this->U(r,c) = T(0);
@@ -112,17 +121,28 @@ namespace Linear {
         /**
         * Constructor. Just calls Compute.
         * @param A PxQ Matrix
+        * @param workspace Workspace for the temporaries (default = NULL, the one bound to the thread if any)
         */
         template <size_t P, size_t Q, unsigned int Flags2>
-        QR(const Matrix<T,P,Q,Flags2>& A) {
-            Compute(A);
+        QR(const Matrix<T,P,Q,Flags2>& A, Workspace * workspace = NULL) {
+            Compute(A, workspace);
+        }
+        /**
+        * Constructor. Evaluates the expression A (e.g. B - C) and calls Compute.
+        * @param A Matrix expression
+        * @param workspace Workspace for the temporaries (default = NULL, the one bound to the thread if any)
+        */
+        template <typename E>
+        QR(const MatrixExpression<E>& A, Workspace * workspace = NULL) {
+            Compute(A.Eval(), workspace);
         }
         /**
         * Computes the QR decomposition. If P != M or Q != N, then an exception is thrown.
         * @param A PxQ Matrix
+        * @param workspace Workspace for the temporaries (default = NULL, the one bound to the thread if any)
         */
         template <size_t P, size_t Q, unsigned int Flags2>
-        void Compute(Matrix<T,P,Q,Flags2> A) {
+        void Compute(const Matrix<T,P,Q,Flags2>& A, Workspace * workspace = NULL) {
             if (A.NumRows() < A.NumColumns())
                 throw "QR Decomposition is defined for m-by-n matrices where m>=n.";
             if ((A.NumRows() != M && M != Dynamic) || (A.NumColumns() != N && N != Dynamic))
@@ -130,17 +150,23 @@ namespace Linear {
             if (A.NumEntries() == 0)
                 throw "Cannot perform QR decomposition of a 0x0, Mx0 or 0xN matrix.";
 
-            // Perform Householder reflections.
-            this->Q = Identity<T,Flags>(A.NumRows());
-            SquareMatrix<T,Dynamic,Flags> aprime = A;
-            size_t niters = std::min(A.NumRows()-1,A.NumColumns());
+            // Perform Householder reflections. Step k only changes the trailing block starting at (k,k) of the reflected
+            // matrix and the trailing columns of Q, so both are updated through views.
+            WorkspaceScope scope(workspace, this->Q.Resource());
+            // A may be one of our own matrices (e.g. qr.Compute(qr.R)), so copy it before Q is overwritten.
+            const Matrix<T,P,Q,Flags2> input = A;
+            size_t m = A.NumRows(), n = A.NumColumns();
+            this->Q = Identity<T,Flags>(m);
+            Matrix<T,Dynamic,Dynamic,Flags> work = input;
+            size_t niters = std::min(m-1,n);
             for (size_t k = 0; k < niters; ++k) {
-                SquareMatrix<T,Dynamic,Flags> qprime = Householder(aprime.GetColumn(0), aprime.NumRows()-1);
-                SquareMatrix<T,M,Flags> qk = (k > 0 ? Diag(Identity<T,Flags>(k), qprime) : qprime);
-                aprime = RemoveRowAndColumn(qprime*aprime, 0, 0);
-                this->Q = this->Q*Transpose(qk);
+                WorkspaceScope step(workspace);
+                Vector<T,Dynamic> x = work.Block(k, k, m-k, 1);
+                SquareMatrix<T,Dynamic,Flags> qprime = Householder(x, m-k-1);
+                Gemm(1, qprime, OP_NONE, work.Block(k, k, m-k, n-k), OP_NONE, 0, work.Block(k, k, m-k, n-k));
+                Gemm(1, this->Q.Block(0, k, m, m-k), OP_NONE, qprime, OP_TRANSPOSE, 0, this->Q.Block(0, k, m, m-k));
             }
-            this->R = Transpose(this->Q)*A;
+            Gemm(1, this->Q, OP_TRANSPOSE, input, OP_NONE, 0, this->R);
         }
     };
 
@@ -166,6 +192,14 @@ namespace Linear {
             Compute(A);
         }
         /**
+        * Constructor. Evaluates the expression A (e.g. B - C) and calls Compute.
+        * @param A Matrix expression
+        */
+        template <typename E>
+        Cholesky(const MatrixExpression<E>& A) {
+            Compute(A.Eval());
+        }
+        /**
         * Computes the Cholesky decomposition. If A is not square or Q != N, then an exception is thrown. This process
         * may fail if A is not a Hermitian positive-definite matrix.
         * @param A PxQ Matrix
@@ -182,13 +216,13 @@ namespace Linear {
             this->L = Zero<T,Flags>(A.NumRows(), A.NumRows());
             this->D = Zero<T,Flags>(A.NumRows(), A.NumRows());
             for (size_t j = 0; j < A.NumRows(); ++j) {
-                this->D(j,j) = A(j,j);
+                this->D(j,j) = this->D.ToScalar(A(j,j));
                 for (size_t k = 0; k < j; ++k)
                     this->D(j,j) -= this->L(j,k)*Conjugate(this->L(j,k))*this->D(k,k);
 
                 this->L(j,j) = 1;
                 for (size_t i = j+1; i < A.NumRows(); ++i) {
-                    this->L(i,j) = A(i,j);
+                    this->L(i,j) = this->L.ToScalar(A(i,j));
                     for (size_t k = 0; k < j; ++k)
                         this->L(i,j) -= this->L(i,k)*Conjugate(this->L(j,k))*this->D(k,k);
                     this->L(i,j) /= this->D(j,j);
@@ -215,18 +249,29 @@ namespace Linear {
         /**
         * Constructor. Just calls Compute.
         * @param A M2xN2 Matrix
+        * @param workspace Workspace for the temporaries (default = NULL, the one bound to the thread if any)
         */
         template <size_t M2, size_t N2, unsigned int Flags2>
-        Eigendecomposition(const Matrix<T,M2,N2,Flags2>& A) {
-            Compute(A);
+        Eigendecomposition(const Matrix<T,M2,N2,Flags2>& A, Workspace * workspace = NULL) {
+            Compute(A, workspace);
+        }
+        /**
+        * Constructor. Evaluates the expression A (e.g. B - C) and calls Compute.
+        * @param A Matrix expression
+        * @param workspace Workspace for the temporaries (default = NULL, the one bound to the thread if any)
+        */
+        template <typename E>
+        Eigendecomposition(const MatrixExpression<E>& A, Workspace * workspace = NULL) {
+            Compute(A.Eval(), workspace);
         }
         /**
         * Computes the Eigendecomposition. If A is not square or Q != N, then an exception is thrown. If the matrix is not
         * diagonalizable, an exception will be thrown.
         * @param A M2xN2 Matrix
+        * @param workspace Workspace for the temporaries (default = NULL, the one bound to the thread if any)
         */
         template <size_t M2, size_t N2, unsigned int Flags2>
-        void Compute(const Matrix<T,M2,N2,Flags2>& A) {
+        void Compute(const Matrix<T,M2,N2,Flags2>& A, Workspace * workspace = NULL) {
             if (!IsSquare(A))
                 throw "Eigendecomposition is defined for square matrices.";
             if (A.NumColumns() != N && N != Dynamic)
@@ -234,13 +279,14 @@ namespace Linear {
             if (A.NumEntries() == 0)
                 throw "Cannot perform Eigendecomposition of a 0x0, Mx0 or 0xN matrix.";
 
+            WorkspaceScope scope(workspace, this->Q.Resource());
             std::vector<Eigenpair<T,N>> eigens = Eigen(A);
 
             this->Q = Zero<T,Flags>(A.NumRows(), A.NumRows());
             this->D = Zero<T,Flags>(A.NumRows(), A.NumRows());
             for (size_t i = 0; i < A.NumRows(); ++i) {
                 this->Q.SetColumn(i, eigens[i].vector);
-                this->D(i,i) = eigens[i].value;
+                this->D(i,i) = this->D.ToScalar(eigens[i].value);
             }
 
             if (Determinant(this->Q) == T(0))
@@ -249,6 +295,35 @@ namespace Linear {
         }
     };
 
+    /// \cond DO_NOT_DOCUMENT
+    /**
+     * Adds unit vectors of the given length to the orthonormal list q until it holds count of them. Each step adds the
+     * standard basis vector farthest from the span of q, made orthogonal to it.
+     */
+    template <typename T, size_t N>
+    void CompleteOrthonormal(std::vector<Vector<T,N>>& q, size_t length, size_t count) {
+        while (q.size() < count) {
+            Vector<T,N> best;
+            T bestNorm = T(-1);
+            for (size_t j = 0; j < length; ++j) {
+                Vector<T,N> e(length, 1, T(0));
+                e[j] = 1;
+                // Twice, so that rounding in the first pass does not leave e leaning towards q.
+                for (size_t pass = 0; pass < 2; ++pass) {
+                    for (size_t i = 0; i < q.size(); ++i)
+                        e -= Proj(e, q[i]);
+                }
+                T norm = Norm(e);
+                if (norm > bestNorm) {
+                    best = e;
+                    bestNorm = norm;
+                }
+            }
+            q.push_back(best / bestNorm);
+        }
+    }
+    /// \endcond
+
     enum SVDType {
         FULL_SVD,
         THIN_SVD
@@ -273,95 +348,85 @@ namespace Linear {
         /**
         * Constructor. Just calls Compute.
         * @param A PxQ Matrix
+        * @param workspace Workspace for the temporaries (default = NULL, the one bound to the thread if any)
         */
         template <size_t P, size_t Q, unsigned int Flags2>
-        SVD(const Matrix<T,P,Q,Flags2>& A) {
-            Compute(A);
+        SVD(const Matrix<T,P,Q,Flags2>& A, Workspace * workspace = NULL) {
+            Compute(A, workspace);
+        }
+        /**
+        * Constructor. Evaluates the expression A (e.g. B - C) and calls Compute.
+        * @param A Matrix expression
+        * @param workspace Workspace for the temporaries (default = NULL, the one bound to the thread if any)
+        */
+        template <typename E>
+        SVD(const MatrixExpression<E>& A, Workspace * workspace = NULL) {
+            Compute(A.Eval(), workspace);
         }
         /**
         * Computes the SVD decomposition. If P != M or Q != N, then an exception is thrown. If the matrix is not
         * diagonalizable, an exception will be thrown.
         * @param A PxQ Matrix
+        * @param workspace Workspace for the temporaries (default = NULL, the one bound to the thread if any)
         */
         template <size_t P, size_t Q, unsigned int Flags2>
-        void Compute(const Matrix<T,P,Q,Flags2>& A) {
+        void Compute(const Matrix<T,P,Q,Flags2>& A, Workspace * workspace = NULL) {
             if ((A.NumRows() != M && M != Dynamic) || (A.NumColumns() != N && N != Dynamic))
                 throw "Cannot perform SVD decomposition; size mismatch.";
             if (A.NumEntries() == 0)
                 throw "Cannot perform SVD decomposition of a 0x0, Mx0 or 0xN matrix.";
 
-            std::vector<Eigenpair<T,M>> left = Eigen(A*ConjugateTranspose(A));
-            std::vector<Eigenpair<T,N>> right = Eigen(ConjugateTranspose(A)*A);
-
-            size_t k = (A.NumRows() > A.NumColumns() ? A.NumColumns() : A.NumRows());
-            std::conditional_t<Type==FULL_SVD, SquareMatrix<T,N,Flags>, Matrix<T,N,(M>N?N:M),Flags>> V = Zero<T,Flags>(A.NumColumns(), (Type==FULL_SVD?A.NumColumns():k));
+            WorkspaceScope scope(workspace, this->U.Resource());
+            SquareMatrix<T,P,Flags2> AAh;
+            Herk(1, A, OP_NONE, 0, AAh);
+            // The eigenvalues of AA^* are the squares of the singular values; take the largest first.
+            std::vector<Eigenpair<T,M>> left = Eigen(AAh);
+            std::stable_sort(left.begin(), left.end(), [](const Eigenpair<T,M>& a, const Eigenpair<T,M>& b) {
+                return a.value.Re > b.value.Re;
+            });
+
+            size_t m = A.NumRows(), n = A.NumColumns();
+            size_t k = std::min(m, n);
+            std::conditional_t<Type==FULL_SVD, SquareMatrix<T,N,Flags>, Matrix<T,N,(M>N?N:M),Flags>> V = Zero<T,Flags>(n, (Type==FULL_SVD?n:k));
             if (Type == FULL_SVD) {
-                this->U = Zero<T,Flags>(A.NumRows(), A.NumRows());
-                this->S = Zero<T,Flags>(A.NumRows(), A.NumColumns());
+                this->U = Zero<T,Flags>(m, m);
+                this->S = Zero<T,Flags>(m, n);
             }
             else {
-                this->U = Zero<T,Flags>(A.NumRows(), k);
-                this->S = Zero<T,Flags>(k,k);
+                this->U = Zero<T,Flags>(m, k);
+                this->S = Zero<T,Flags>(k, k);
             }
 
-            // Sort singular values by largest.
-            size_t i = 0;
-            while (i < k && left.size() > 0 && right.size() > 0) {
-                size_t ileft = 0, iright = 0;
-                Complex<T> sval;
-                T abs = T(0);
-                for (size_t j = 0; j < std::min(left.size(), right.size()); ++j) {
-                    if (left.size() <= right.size() && Abs(left[j].value) > abs) {
-                        ileft = j;
-                        sval = left[j].value;
-                        abs = Abs(sval);
-                    }
-                    else if (left.size() > right.size() && Abs(right[j].value) > abs) {
-                        iright = j;
-                        sval = right[j].value;
-                        abs = Abs(sval);
-                        for (size_t k = 0; k < left.size(); ++k) {
-                            if (Abs(sval-left[k].value) < T(Tol)) {
-                                ileft = k;
-                                break;
-                            }
-                        }
-                    }
-                }
-                if (left.size() <= right.size()) {
-                    // Find iright by taking the closest to the value.
-                    abs = T(-1);
-                    for (size_t k = 0; k < right.size(); ++k) {
-                        T diff = Abs(sval - right[k].value);
-                        if (diff < abs || abs < 0) {
-                            iright = k;
-                            abs = diff;
-                        }
-                    }
-                }
-                else  {
-                    // Find ileft by taking the closest to the value.
-                    abs = T(-1);
-                    for (size_t k = 0; k < left.size(); ++k) {
-                        T diff = Abs(sval - left[k].value);
-                        if (diff < abs || abs < 0) {
-                            ileft = k;
-                            abs = diff;
-                        }
-                    }
-                }
-
-                // Add it.
-                U.SetColumn(i, left[ileft].vector);
-                S(i,i) = Sqrt(sval);
-                V.SetColumn(i, right[iright].vector);
-                i += 1;
-
-                // Remove entries
-                left.erase(left.begin()+ileft);
-                right.erase(right.begin()+iright);
+            // Each right singular vector is taken from its left one, v=A^*u/s, rather than from a second eigensolve, so
+            // the signs (and phases) of the pair always agree and USV^* reproduces A. Left vectors of a repeated singular
+            // value are made orthogonal first.
+            std::vector<Vector<T,M>> us;
+            std::vector<Vector<T,N>> vs;
+            T largest = (left.empty() ? T(0) : std::sqrt(std::max(left[0].value.Re, T(0))));
+            for (size_t i = 0; i < std::min(k, left.size()); ++i) {
+                T sval = std::sqrt(std::max(left[i].value.Re, T(0)));
+                if (sval == T(0) || sval <= T(Tol)*largest)
+                    break;
+                Vector<T,M> u = left[i].vector;
+                for (size_t j = 0; j < us.size(); ++j)
+                    u -= Proj(u, us[j]);
+                if (Norm(u) < T(Tol))
+                    break;
+                u = Normalize(u);
+                Vector<T,N> v = ConjugateTranspose(A)*u;
+                this->S(i,i) = this->S.ToScalar(sval);
+                us.push_back(u);
+                vs.push_back(Normalize(v));
             }
 
+            // Zero singular values: any orthonormal completion will do.
+            CompleteOrthonormal(us, m, this->U.NumColumns());
+            CompleteOrthonormal(vs, n, V.NumColumns());
+            for (size_t i = 0; i < us.size(); ++i)
+                this->U.SetColumn(i, us[i]);
+            for (size_t i = 0; i < vs.size(); ++i)
+                V.SetColumn(i, vs[i]);
+
             this->Vh = ConjugateTranspose(V);
         }
     };
@@ -382,17 +447,28 @@ namespace Linear {
         /**
         * Constructor. Just calls Compute.
         * @param A M2xN2 Matrix
+        * @param workspace Workspace for the temporaries (default = NULL, the one bound to the thread if any)
         */
         template <size_t M2, size_t N2, unsigned int Flags2>
-        Hessenberg(const Matrix<T,M2,N2,Flags2>& A) {
-            Compute(A);
+        Hessenberg(const Matrix<T,M2,N2,Flags2>& A, Workspace * workspace = NULL) {
+            Compute(A, workspace);
+        }
+        /**
+        * Constructor. Evaluates the expression A (e.g. B - C) and calls Compute.
+        * @param A Matrix expression
+        * @param workspace Workspace for the temporaries (default = NULL, the one bound to the thread if any)
+        */
+        template <typename E>
+        Hessenberg(const MatrixExpression<E>& A, Workspace * workspace = NULL) {
+            Compute(A.Eval(), workspace);
         }
         /**
         * Computes the Hessenberg decomposition. If A is not square or Q != N, then an exception is thrown.
         * @param A M2xN2 Matrix
+        * @param workspace Workspace for the temporaries (default = NULL, the one bound to the thread if any)
         */
         template <size_t M2, size_t N2, unsigned int Flags2>
-        void Compute(const Matrix<T,M2,N2,Flags2>& A) {
+        void Compute(const Matrix<T,M2,N2,Flags2>& A, Workspace * workspace = NULL) {
             if (!IsSquare(A))
                 throw "Hessenberg decomposition requires a square matrix.";
             if (A.NumColumns() != N && N != Dynamic)
@@ -400,16 +476,19 @@ namespace Linear {
             if (A.NumEntries() == 0)
                 throw "Cannot perform Hessenberg decomposition of a 0x0, Mx0 or 0xN matrix.";
 
-            this->Q = Identity<T>(A.NumRows());
+            WorkspaceScope scope(workspace, this->Q.Resource());
+            size_t n = A.NumRows();
+            this->Q = Identity<T>(n);
             this->H = A;
-            SquareMatrix<T,Dynamic,Flags> Aprime = A;
-
-            for (size_t j = 0; j < A.NumRows()-2; ++j) {
-                SquareMatrix<T,Dynamic,Flags> P = Householder(Aprime.GetColumn(0), Aprime.NumRows()-2);
-                SquareMatrix<T,N,Flags> P2 = (j > 0 ? Diag(Identity<T,Flags>(j), P) : P);
-                Aprime = RemoveRowAndColumn(ConjugateTranspose(P)*Aprime*P, 0, 0);
-                this->H = ConjugateTranspose(P2)*this->H*P2;
-                this->Q = this->Q*P2;
+
+            // Step j reflects rows and columns j.. of H, so only those are updated (through views).
+            for (size_t j = 0; j < n-2; ++j) {
+                WorkspaceScope step(workspace);
+                Vector<T,Dynamic> x = this->H.Block(j, j, n-j, 1);
+                SquareMatrix<T,Dynamic,Flags> P = Householder(x, n-j-2);
+                Gemm(1, P, OP_CONJUGATE_TRANSPOSE, this->H.Block(j, 0, n-j, n), OP_NONE, 0, this->H.Block(j, 0, n-j, n));
+                Gemm(1, this->H.Block(0, j, n, n-j), OP_NONE, P, OP_NONE, 0, this->H.Block(0, j, n, n-j));
+                Gemm(1, this->Q.Block(0, j, n, n-j), OP_NONE, P, OP_NONE, 0, this->Q.Block(0, j, n, n-j));
             }
             this->Qh = ConjugateTranspose(this->Q);
         }
@@ -432,17 +511,31 @@ namespace Linear {
         /**
         * Constructor. Just calls Compute.
         * @param A M2xN2 Matrix
+        * @param max_iterations Maximum number of QR sweeps per eigenvalue (default = 100)
+        * @param workspace Workspace for the temporaries (default = NULL, the one bound to the thread if any)
         */
         template <size_t M2, size_t N2, unsigned int Flags2>
-        Schur(const Matrix<T,M2,N2,Flags2>& A, unsigned int max_iterations = 100) {
-            Compute(A, max_iterations);
+        Schur(const Matrix<T,M2,N2,Flags2>& A, unsigned int max_iterations = 100, Workspace * workspace = NULL) {
+            Compute(A, max_iterations, workspace);
+        }
+        /**
+        * Constructor. Evaluates the expression A (e.g. B - C) and calls Compute.
+        * @param A Matrix expression
+        * @param max_iterations Maximum number of QR sweeps per eigenvalue (default = 100)
+        * @param workspace Workspace for the temporaries (default = NULL, the one bound to the thread if any)
+        */
+        template <typename E>
+        Schur(const MatrixExpression<E>& A, unsigned int max_iterations = 100, Workspace * workspace = NULL) {
+            Compute(A.Eval(), max_iterations, workspace);
         }
         /**
         * Computes the real Schur decomposition. If A is not square or Q != N, then an exception is thrown.
         * @param A M2xN2 Matrix
+        * @param max_iterations Maximum number of QR sweeps per eigenvalue (default = 100)
+        * @param workspace Workspace for the temporaries (default = NULL, the one bound to the thread if any)
         */
         template <size_t M2, size_t N2, unsigned int Flags2>
-        void Compute(const Matrix<T,M2,N2,Flags2>& A, unsigned int max_iterations = 100) {
+        void Compute(const Matrix<T,M2,N2,Flags2>& A, unsigned int max_iterations = 100, Workspace * workspace = NULL) {
             if (!IsSquare(A))
                 throw "Schur decomposition requires a square matrix.";
             if (A.NumColumns() != N && N != Dynamic)
@@ -450,8 +543,9 @@ namespace Linear {
             if (A.NumEntries() == 0)
                 throw "Cannot perform Schur decomposition of a 0x0, Mx0 or 0xN matrix.";
 
-            SquareMatrix<T,N,Flags> eye = Identity<T>(A.NumRows());
-            this->Q = Identity<T>(A.NumRows());
+            WorkspaceScope scope(workspace, this->Q.Resource());
+            size_t n = A.NumRows();
+            this->Q = Identity<T>(n);
             this->U = A;
             // if (!IsHessenberg(A)) {
             //     Hessenberg<T,N,Flags> hess(A);
@@ -462,9 +556,12 @@ namespace Linear {
             for (size_t i = A.NumRows()-1; i >= 1; i--) {
                 size_t k = 0;
                 while (k < max_iterations && Abs(this->U(i,i-1)) > T(Tol)) {
+                    // Each sweep's QR lives in the workspace and is released at the end of the sweep. U and Q are
+                    // written through views so they keep their buffers.
+                    WorkspaceScope sweep(workspace);
                     QR<T,N,N,Flags> qr(this->U);
-                    this->U = qr.R*qr.Q;
-                    this->Q = this->Q*qr.Q;
+                    this->U.Block(0, 0, n, n) = qr.R*qr.Q;
+                    this->Q.Block(0, 0, n, n) = this->Q*qr.Q;
                     k += 1;
                 }
             }
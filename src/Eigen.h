@@ -52,12 +52,13 @@ namespace Linear {
         RowVector<T,N> q2 = ConjugateTranspose(q);
         RowVector<T,N> b2 = ConjugateTranspose(b);
         T res = T(Tol+1);
+        // The products are written into b and b2 in place, and q2*A walks A in its storage order instead of transposing it.
         for (unsigned int i = 0; res >= T(Tol) && i < max_iterations; ++i) {
             q = Normalize(b);
-            b = A*q;
+            Gemv(T(1), A, OP_NONE, q, T(0), b);
             lambda = Dot(q,b);
 
-            b2 = q2*A;
+            Gemm(T(1), q2, OP_NONE, A, OP_NONE, T(0), b2);
             q2 = Normalize(b2);
             T costheta = Abs(Dot(q2,q));
             if (costheta < T(Tol)) // Eigenvalues multiplicity >1 ?
@@ -95,10 +96,11 @@ namespace Linear {
             throw "Cannot perform inverse iteration on a Mx0 or 0xN matrix.";
 
         SquareMatrix<T,N,Flags> eye = Identity<T,Flags>(A.NumRows());
-        SquareMatrix<T,N,Flags> B = Inverse(A-mu*eye);
-        Vector<T,N> b = b0;
+        SquareMatrix<T,N,Flags & ~RealStorage> B = Inverse(A-mu*eye);
+        Vector<T,N> b = b0, Bb = b0;
         for (unsigned int i = 0; i < max_iterations; ++i) {
-            b = Normalize(B*b);
+            Gemv(T(1), B, OP_NONE, b, T(0), Bb);
+            b = Normalize(Bb);
         }
         return b;
     }
@@ -147,8 +149,7 @@ namespace Linear {
             x = x / x[p];
 
         // Step 3/4: Compute Ap and remove row p and column p
-        RowVector<T,N> ap = A.GetRow(p);
-        SquareMatrix<T,Dynamic,Flags> Ap = RemoveRowAndColumn(A - x*ap, p, p);
+        SquareMatrix<T,Dynamic,Flags & ~RealStorage> Ap = RemoveRowAndColumn(A - x*A.Row(p), p, p);
 
         // Step 5: Repeat.
         Vector<T,(N==Dynamic?Dynamic:N-1)> res = WielandtDeflationAlgorithm(Ap, max_iterations);
@@ -219,7 +220,7 @@ namespace Linear {
                 if (!schurSucceeded)
                     break;
 
-                SquareMatrix<T,2,Flags> block = SubMatrix<2,2>(schur.U, i, i);
+                SquareMatrix<T,2,Flags> block = schur.U.Block(i, i, 2, 2);
                 Vector<T,2> eig = Eigenvalues(block);
                 eigenvalues[i] = eig[0];
                 eigenvalues[i+1] = eig[1];
@@ -246,6 +247,9 @@ namespace Linear {
      * eigenvectors. Second, if the matrix is 2x2, then a easy direct formula exists to calculate the eigenvalues. Namely
      * \f$(tr(A)\pm\sqrt{tr(A)^2-4det(A)})/2\f$. Third, if neither of the first two cases handles the matrix, we attempt to calculate the
      * Schur decomposition of A. If that fails, we resort to calling WielandtDeflationAlgorithm.
+     *
+     * Temporaries are taken from the workspace bound to the thread, if any (see UseWorkspace), while the eigenvectors
+     * are allocated from the default memory resource in effect at the call.
      * @param A MxN matrix
      * @return List of Eigenpairs
      */
@@ -253,17 +257,22 @@ namespace Linear {
     std::vector<Eigenpair<T,N>> Eigen(const Matrix<T,M,N,Flags>& A) {
         if (!IsSquare(A))
             throw "Eigenvalues are only defined for square matrices.";
-        if (A.NumEntries() == 0) {
-            std::vector<Eigenpair<T,N>> eigenpairs;
+        std::vector<Eigenpair<T,N>> eigenpairs;
+        if (A.NumEntries() == 0)
             return eigenpairs;
-        }
 
+        MemoryResource * results = GetDefaultMemoryResource();
+        WorkspaceScope scope(NULL, results);
+        // Copies the pair out of the workspace, which is rewound when the scope closes.
+        auto keep = [&](const Eigenpair<T,N>& pair) {
+            UseMemoryResource use(results);
+            eigenpairs.push_back(pair);
+        };
         Vector<T,N> eigenvalues = Eigenvalues(A);
 
         bool isAReal = IsReal(A);
 
         SquareMatrix<T,Dynamic,Flags> eye = Identity<T>(A.NumColumns());
-        std::vector<Eigenpair<T,N>> eigenpairs;
         std::vector<size_t> repeats;
         for (size_t i = 0; i < eigenvalues.Length(); ++i) {
             // Check if we need to skip this one.
@@ -294,7 +303,7 @@ namespace Linear {
                 for (size_t j = 0; j < multiplicity; ++j) {
                     if (j < basis.size())
                         pair.vector = Normalize(basis[j]);
-                    eigenpairs.push_back(pair);
+                    keep(pair);
                 }
             }
             else {
@@ -310,7 +319,7 @@ namespace Linear {
                     pair.vector = Zero<T>(A.NumColumns(),1);
 
                 for (size_t j = 0; j < multiplicity; ++j)
-                    eigenpairs.push_back(pair);
+                    keep(pair);
             }
         }
 
@@ -369,4 +378,11 @@ namespace Linear {
 
         return c;
     }
+
+    // Accept unevaluated expressions, e.g. PowerIteration(A - B).
+    LINEAR_EVALUATE_EXPRESSIONS(PowerIteration)
+    LINEAR_EVALUATE_EXPRESSIONS(InverseIteration)
+    LINEAR_EVALUATE_EXPRESSIONS(Eigenvalues)
+    LINEAR_EVALUATE_EXPRESSIONS(Eigen)
+    LINEAR_EVALUATE_EXPRESSIONS(CharPoly)
 }
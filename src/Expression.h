@@ -0,0 +1,472 @@
+#pragma once
+#include <type_traits>
+#include <utility>
+#include "Complex.h"
+#include "Storage.h"
+
+namespace Linear {
+    template<typename T, size_t M, size_t N, unsigned int Flags>
+    class Matrix;
+
+    /// \cond DO_NOT_DOCUMENT
+    /**
+     * Describes the matrix an expression evaluates to.
+     * Real is the type of the real and imaginary parts, Rows/Columns/Flags are the template arguments of the resulting
+     * Matrix, StoresEntries is whether entries are read from memory (rather than computed), MixedLayout is whether it reads
+     * both row-major and column-major operands, and Nested is how the expression is held inside a larger expression.
+     */
+    template <typename E>
+    struct ExpressionTraits;
+
+    template <typename T, size_t M, size_t N, unsigned int F>
+    struct ExpressionTraits<Matrix<T,M,N,F>> {
+        typedef T Real;
+        static const size_t Rows = M;
+        static const size_t Columns = N;
+        static const unsigned int Flags = F;
+        static const bool StoresEntries = true;
+        static const bool MixedLayout = false;
+        // Matrices are referenced rather than copied, so they have to outlive the expression.
+        typedef const Matrix<T,M,N,F>& Nested;
+    };
+
+    template <typename E>
+    using ExpressionScalar = typename ScalarTraits<typename ExpressionTraits<E>::Real,(ExpressionTraits<E>::Flags & RealStorage) != 0>::Scalar;
+
+    template <typename E>
+    using ExpressionMatrix = Matrix<typename ExpressionTraits<E>::Real,ExpressionTraits<E>::Rows,ExpressionTraits<E>::Columns,ExpressionTraits<E>::Flags>;
+    /// \endcond
+
+    /**
+     * Base class of everything that can be evaluated to a matrix one entry at a time: matrices themselves, and the results
+     * of +, - and scaling by a number. These operators do not compute anything. They return a small object referencing their
+     * operands, and all entries are computed in one pass, without temporaries, when the expression is assigned to a matrix.
+     *
+     * Since the operands are referenced, an expression should not be kept (e.g. with auto) past the statement creating it.
+     * Use Eval() to turn an expression into a Matrix.
+     * @param E Type of the expression.
+     */
+    template <typename E>
+    class MatrixExpression {
+    public:
+        /**
+         * @return The expression as its actual type.
+         */
+        const E& Derived() const { return static_cast<const E&>(*this); }
+        /**
+         * @return Number of rows
+         */
+        size_t NumRows() const { return Derived().NumRows(); }
+        /**
+         * @return Number of columns
+         */
+        size_t NumColumns() const { return Derived().NumColumns(); }
+        /**
+         * Computes the entry in row r and column c.
+         * @param r Row index
+         * @param c Column index
+         * @return Entry of the expression
+         */
+        ExpressionScalar<E> operator() (size_t r, size_t c) const { return Derived()(r,c); }
+        /**
+         * Same as operator()(r,c), but the indices are not checked. Used by the evaluation loops, which know the sizes.
+         * @param r Row index
+         * @param c Column index
+         * @return Entry of the expression
+         */
+        ExpressionScalar<E> At(size_t r, size_t c) const { return Derived().At(r,c); }
+        /**
+         * Evaluates the expression.
+         * @return Matrix holding the value of the expression.
+         */
+        ExpressionMatrix<E> Eval() const { return ExpressionMatrix<E>(Derived()); }
+    };
+
+    /// \cond DO_NOT_DOCUMENT
+    template <typename E>
+    struct IsMatrix : std::false_type {};
+
+    template <typename T, size_t M, size_t N, unsigned int F>
+    struct IsMatrix<Matrix<T,M,N,F>> : std::true_type {};
+
+    /**
+     * Whether E is an unevaluated expression, i.e. a MatrixExpression that is not a Matrix.
+     */
+    template <typename E>
+    struct IsLazyExpression : std::integral_constant<bool, std::is_base_of<MatrixExpression<E>,E>::value && !IsMatrix<E>::value> {};
+
+    template <typename... Es>
+    struct AnyLazyExpression : std::false_type {};
+
+    template <typename E, typename... Es>
+    struct AnyLazyExpression<E,Es...> : std::integral_constant<bool, IsLazyExpression<E>::value || AnyLazyExpression<Es...>::value> {};
+
+    /**
+     * Flags of an element-wise combination of the expressions L and R, see PromoteFlags().
+     */
+    template <typename L, typename R, typename Node>
+    struct BinaryExpressionTraits {
+        typedef typename ExpressionTraits<L>::Real Real;
+        static const size_t Rows = ExpressionTraits<L>::Rows;
+        static const size_t Columns = ExpressionTraits<L>::Columns;
+        static const unsigned int Flags = PromoteFlags(ExpressionTraits<L>::Flags, ExpressionTraits<R>::Flags);
+        static const bool StoresEntries = false;
+        static const bool MixedLayout = (ExpressionTraits<L>::MixedLayout || ExpressionTraits<R>::MixedLayout ||
+                                         ((ExpressionTraits<L>::Flags ^ ExpressionTraits<R>::Flags) & ColumnMajor) != 0);
+        typedef Node Nested;
+    };
+
+    /**
+     * Flags of the expression E scaled by a number of type S. Scaling by a complex number drops real storage.
+     */
+    template <typename E, typename S, typename Node>
+    struct ScaledExpressionTraits {
+        typedef typename ExpressionTraits<E>::Real Real;
+        static const size_t Rows = ExpressionTraits<E>::Rows;
+        static const size_t Columns = ExpressionTraits<E>::Columns;
+        static const unsigned int Flags = (std::is_same<S,Real>::value ? ExpressionTraits<E>::Flags : ExpressionTraits<E>::Flags & ~RealStorage);
+        static const bool StoresEntries = false;
+        static const bool MixedLayout = ExpressionTraits<E>::MixedLayout;
+        typedef Node Nested;
+    };
+
+    /**
+     * Whether an expression E can be read in the storage order of a matrix with the given flags without striding, i.e.
+     * every operand of E is stored in the same order as that matrix.
+     */
+    template <unsigned int Flags, typename E>
+    struct SameLayout : std::integral_constant<bool, !ExpressionTraits<E>::MixedLayout &&
+                                                     ((ExpressionTraits<E>::Flags ^ Flags) & ColumnMajor) == 0> {};
+
+    /**
+     * Calls f(r,c) once for every entry of an m-by-n matrix, in the storage order of a row-major (or, if ColMajor, column-major)
+     * destination. If Tiled, the entries are visited tile by tile (see LINEAR_TILE), so that a source stored in the other
+     * order is also read a few cache lines at a time rather than with a stride of a whole line per entry.
+     */
+    template <bool ColMajor, bool Tiled, typename F>
+    void ForEachIndex(size_t m, size_t n, F f) {
+        size_t lines = (ColMajor ? n : m), inner = (ColMajor ? m : n);
+        size_t tile = (Tiled ? LINEAR_TILE : (lines > inner ? lines : inner));
+        for (size_t i = 0; i < lines; i += tile) {
+            size_t iEnd = (lines-i < tile ? lines : i+tile);
+            for (size_t j = 0; j < inner; j += tile) {
+                size_t jEnd = (inner-j < tile ? inner : j+tile);
+                for (size_t l = i; l < iEnd; ++l) {
+                    for (size_t k = j; k < jEnd; ++k) {
+                        if (ColMajor)
+                            f(k, l);
+                        else
+                            f(l, k);
+                    }
+                }
+            }
+        }
+    }
+
+    template <typename L, typename R> class MatrixSum;
+    template <typename L, typename R> class MatrixDifference;
+    template <typename E> class MatrixNegation;
+    template <typename E, typename S> class MatrixScalarProduct;
+    template <typename E, typename S> class MatrixScalarQuotient;
+
+    template <typename L, typename R>
+    struct ExpressionTraits<MatrixSum<L,R>> : BinaryExpressionTraits<L,R,MatrixSum<L,R>> {};
+
+    template <typename L, typename R>
+    struct ExpressionTraits<MatrixDifference<L,R>> : BinaryExpressionTraits<L,R,MatrixDifference<L,R>> {};
+
+    template <typename E>
+    struct ExpressionTraits<MatrixNegation<E>> : ScaledExpressionTraits<E,typename ExpressionTraits<E>::Real,MatrixNegation<E>> {};
+
+    template <typename E, typename S>
+    struct ExpressionTraits<MatrixScalarProduct<E,S>> : ScaledExpressionTraits<E,S,MatrixScalarProduct<E,S>> {};
+
+    template <typename E, typename S>
+    struct ExpressionTraits<MatrixScalarQuotient<E,S>> : ScaledExpressionTraits<E,S,MatrixScalarQuotient<E,S>> {};
+
+    /**
+     * Lazy \f$A+B\f$.
+     */
+    template <typename L, typename R>
+    class MatrixSum : public MatrixExpression<MatrixSum<L,R>> {
+    public:
+        MatrixSum(const L& left, const R& right) : left(left), right(right) {
+            if (left.NumRows() != right.NumRows() || left.NumColumns() != right.NumColumns())
+                throw "Cannot add two matrices of differing sizes.";
+        }
+        size_t NumRows() const { return this->left.NumRows(); }
+        size_t NumColumns() const { return this->left.NumColumns(); }
+        ExpressionScalar<MatrixSum> operator() (size_t r, size_t c) const { return this->left(r,c) + this->right(r,c); }
+        ExpressionScalar<MatrixSum> At(size_t r, size_t c) const { return this->left.At(r,c) + this->right.At(r,c); }
+        template <typename D>
+        bool ConflictsWith(const D& dest, bool inPlace) const {
+            return this->left.ConflictsWith(dest, inPlace) || this->right.ConflictsWith(dest, inPlace);
+        }
+    private:
+        typename ExpressionTraits<L>::Nested left;
+        typename ExpressionTraits<R>::Nested right;
+    };
+
+    /**
+     * Lazy \f$A-B\f$.
+     */
+    template <typename L, typename R>
+    class MatrixDifference : public MatrixExpression<MatrixDifference<L,R>> {
+    public:
+        MatrixDifference(const L& left, const R& right) : left(left), right(right) {
+            if (left.NumRows() != right.NumRows() || left.NumColumns() != right.NumColumns())
+                throw "Cannot subtract two matrices of differing sizes.";
+        }
+        size_t NumRows() const { return this->left.NumRows(); }
+        size_t NumColumns() const { return this->left.NumColumns(); }
+        ExpressionScalar<MatrixDifference> operator() (size_t r, size_t c) const { return this->left(r,c) - this->right(r,c); }
+        ExpressionScalar<MatrixDifference> At(size_t r, size_t c) const { return this->left.At(r,c) - this->right.At(r,c); }
+        template <typename D>
+        bool ConflictsWith(const D& dest, bool inPlace) const {
+            return this->left.ConflictsWith(dest, inPlace) || this->right.ConflictsWith(dest, inPlace);
+        }
+    private:
+        typename ExpressionTraits<L>::Nested left;
+        typename ExpressionTraits<R>::Nested right;
+    };
+
+    /**
+     * Lazy \f$-A\f$.
+     */
+    template <typename E>
+    class MatrixNegation : public MatrixExpression<MatrixNegation<E>> {
+    public:
+        MatrixNegation(const E& operand) : operand(operand) {}
+        size_t NumRows() const { return this->operand.NumRows(); }
+        size_t NumColumns() const { return this->operand.NumColumns(); }
+        ExpressionScalar<MatrixNegation> operator() (size_t r, size_t c) const { return -this->operand(r,c); }
+        ExpressionScalar<MatrixNegation> At(size_t r, size_t c) const { return -this->operand.At(r,c); }
+        template <typename D>
+        bool ConflictsWith(const D& dest, bool inPlace) const { return this->operand.ConflictsWith(dest, inPlace); }
+    private:
+        typename ExpressionTraits<E>::Nested operand;
+    };
+
+    /**
+     * Lazy \f$sA\f$, where s is a real (S = T) or complex (S = Complex<T>) number.
+     */
+    template <typename E, typename S>
+    class MatrixScalarProduct : public MatrixExpression<MatrixScalarProduct<E,S>> {
+    public:
+        MatrixScalarProduct(const E& operand, const S& s) : operand(operand), s(s) {}
+        size_t NumRows() const { return this->operand.NumRows(); }
+        size_t NumColumns() const { return this->operand.NumColumns(); }
+        ExpressionScalar<MatrixScalarProduct> operator() (size_t r, size_t c) const { return this->operand(r,c) * this->s; }
+        ExpressionScalar<MatrixScalarProduct> At(size_t r, size_t c) const { return this->operand.At(r,c) * this->s; }
+        template <typename D>
+        bool ConflictsWith(const D& dest, bool inPlace) const { return this->operand.ConflictsWith(dest, inPlace); }
+    private:
+        typename ExpressionTraits<E>::Nested operand;
+        S s;
+    };
+
+    /**
+     * Lazy \f$A/s\f$, where s is a real (S = T) or complex (S = Complex<T>) number.
+     */
+    template <typename E, typename S>
+    class MatrixScalarQuotient : public MatrixExpression<MatrixScalarQuotient<E,S>> {
+    public:
+        MatrixScalarQuotient(const E& operand, const S& s) : operand(operand), s(s) {}
+        size_t NumRows() const { return this->operand.NumRows(); }
+        size_t NumColumns() const { return this->operand.NumColumns(); }
+        ExpressionScalar<MatrixScalarQuotient> operator() (size_t r, size_t c) const { return this->operand(r,c) / this->s; }
+        ExpressionScalar<MatrixScalarQuotient> At(size_t r, size_t c) const { return this->operand.At(r,c) / this->s; }
+        template <typename D>
+        bool ConflictsWith(const D& dest, bool inPlace) const { return this->operand.ConflictsWith(dest, inPlace); }
+    private:
+        typename ExpressionTraits<E>::Nested operand;
+        S s;
+    };
+
+    template <typename L, typename R>
+    using EnableIfSameReal = typename std::enable_if<std::is_same<typename ExpressionTraits<L>::Real,typename ExpressionTraits<R>::Real>::value>::type;
+
+    /**
+     * Passes matrices and other arguments through unchanged.
+     */
+    template <typename A>
+    typename std::enable_if<!IsLazyExpression<typename std::decay<A>::type>::value, A&&>::type EvalArgument(A&& a) {
+        return std::forward<A>(a);
+    }
+
+    /**
+     * Evaluates an expression argument to a Matrix.
+     */
+    template <typename A>
+    typename std::enable_if<IsLazyExpression<typename std::decay<A>::type>::value, ExpressionMatrix<typename std::decay<A>::type>>::type EvalArgument(A&& a) {
+        return a.Eval();
+    }
+
+    /**
+     * Expressions whose entries live in memory (matrices and views) can be read repeatedly as they are.
+     */
+    template <typename E>
+    typename std::enable_if<ExpressionTraits<E>::StoresEntries, const E&>::type Materialize(const E& e) {
+        return e;
+    }
+
+    /**
+     * Computed expressions are evaluated once, so that reading an entry repeatedly does not recompute it.
+     */
+    template <typename E>
+    typename std::enable_if<!ExpressionTraits<E>::StoresEntries, ExpressionMatrix<E>>::type Materialize(const E& e) {
+        return e.Eval();
+    }
+
+    /**
+     * Checks whether the memory read through operand overlaps the memory written through dest. Both need Data(),
+     * RowStride() and ColumnStride(). If inPlace is true, entry (r,c) of dest is written right after entry (r,c) of the
+     * expression is computed, so an operand addressing exactly the same entries as dest is harmless.
+     * @param operand Matrix or view read by an expression
+     * @param dest Matrix or view being written to
+     * @param inPlace Whether dest keeps its storage
+     * @return true if the expression has to be evaluated into a temporary first
+     */
+    template <typename A, typename D>
+    bool StorageConflicts(const A& operand, const D& dest, bool inPlace) {
+        if (operand.NumRows() == 0 || operand.NumColumns() == 0 || dest.NumRows() == 0 || dest.NumColumns() == 0)
+            return false;
+        const char * begin = reinterpret_cast<const char*>(operand.Data());
+        const char * end = reinterpret_cast<const char*>(operand.Data() + (operand.NumRows()-1)*operand.RowStride()
+                                                                         + (operand.NumColumns()-1)*operand.ColumnStride() + 1);
+        const char * destBegin = reinterpret_cast<const char*>(dest.Data());
+        const char * destEnd = reinterpret_cast<const char*>(dest.Data() + (dest.NumRows()-1)*dest.RowStride()
+                                                                         + (dest.NumColumns()-1)*dest.ColumnStride() + 1);
+        if (end <= destBegin || destEnd <= begin)
+            return false;
+        bool same = (begin == destBegin && sizeof(*operand.Data()) == sizeof(*dest.Data())
+                     && operand.NumRows() == dest.NumRows() && operand.NumColumns() == dest.NumColumns()
+                     && operand.RowStride() == dest.RowStride() && operand.ColumnStride() == dest.ColumnStride());
+        return !(inPlace && same);
+    }
+    /// \endcond
+
+    /**
+     * Lets the function Name (taking matrices) be called with unevaluated expressions, e.g. Inverse(A - B). Every
+     * expression argument is evaluated to a Matrix before calling Name. Functions that share a name with an entrywise
+     * function of Complex.h (Abs, Exp, ...) cannot be forwarded this way; call Eval() on their argument instead.
+     */
+    #define LINEAR_EVALUATE_EXPRESSIONS(Name) \
+    template <typename... Args, typename std::enable_if<AnyLazyExpression<typename std::decay<Args>::type...>::value>::type* = nullptr> \
+    auto Name(Args&&... args) -> decltype(Name(EvalArgument(std::forward<Args>(args))...)) { \
+        return Name(EvalArgument(std::forward<Args>(args))...); \
+    }
+
+    /**
+     * Computes \f$C=A+B\f$ defined by \f$c_{ij}=a_{ij}+b_{ij}\f$. Evaluation is deferred until the result is assigned.
+     * If the sizes of A and B differ an exception is raised. The result only uses real storage if both A and B do.
+     * @param A MxN Matrix expression
+     * @param B MxN Matrix expression
+     * @return Expression for A+B
+     */
+    template <typename L, typename R, typename = EnableIfSameReal<L,R>>
+    MatrixSum<L,R> operator+(const MatrixExpression<L>& A, const MatrixExpression<R>& B) {
+        return MatrixSum<L,R>(A.Derived(), B.Derived());
+    }
+    /**
+     * Computes \f$C=A-B\f$ defined by \f$c_{ij}=a_{ij}-b_{ij}\f$. Evaluation is deferred until the result is assigned.
+     * If the sizes of A and B differ an exception is raised. The result only uses real storage if both A and B do.
+     * @param A MxN Matrix expression
+     * @param B MxN Matrix expression
+     * @return Expression for A-B
+     */
+    template <typename L, typename R, typename = EnableIfSameReal<L,R>>
+    MatrixDifference<L,R> operator-(const MatrixExpression<L>& A, const MatrixExpression<R>& B) {
+        return MatrixDifference<L,R>(A.Derived(), B.Derived());
+    }
+    /**
+     * Computes \f$B=-A\f$. Evaluation is deferred until the result is assigned.
+     * @param A MxN Matrix expression
+     * @return Expression for -A
+     */
+    template <typename E>
+    MatrixNegation<E> operator-(const MatrixExpression<E>& A) {
+        return MatrixNegation<E>(A.Derived());
+    }
+    /**
+     * Computes \f$B=xA\f$ defined by \f$b_{ij}=xa_{ij}\f$. Evaluation is deferred until the result is assigned.
+     * @param A MxN Matrix expression
+     * @param x Real number
+     * @return Expression for xA
+     */
+    template <typename E>
+    MatrixScalarProduct<E,typename ExpressionTraits<E>::Real> operator*(const MatrixExpression<E>& A, const typename ExpressionTraits<E>::Real& x) {
+        return MatrixScalarProduct<E,typename ExpressionTraits<E>::Real>(A.Derived(), x);
+    }
+    /**
+     * Computes \f$B=xA\f$ defined by \f$b_{ij}=xa_{ij}\f$. Evaluation is deferred until the result is assigned.
+     * @param x Real number
+     * @param A MxN Matrix expression
+     * @return Expression for xA
+     */
+    template <typename E>
+    MatrixScalarProduct<E,typename ExpressionTraits<E>::Real> operator*(const typename ExpressionTraits<E>::Real& x, const MatrixExpression<E>& A) {
+        return MatrixScalarProduct<E,typename ExpressionTraits<E>::Real>(A.Derived(), x);
+    }
+    /**
+     * Computes \f$B=A/x\f$ defined by \f$b_{ij}=a_{ij}/x\f$. Evaluation is deferred until the result is assigned.
+     * @param A MxN Matrix expression
+     * @param x Real number
+     * @return Expression for A/x
+     */
+    template <typename E>
+    MatrixScalarQuotient<E,typename ExpressionTraits<E>::Real> operator/(const MatrixExpression<E>& A, const typename ExpressionTraits<E>::Real& x) {
+        return MatrixScalarQuotient<E,typename ExpressionTraits<E>::Real>(A.Derived(), x);
+    }
+    /**
+     * Computes \f$B=sA\f$ defined by \f$b_{ij}=sa_{ij}\f$. Evaluation is deferred until the result is assigned.
+     * The result never uses real storage, as s may not be real.
+     * @param A MxN Matrix expression
+     * @param s Complex number
+     * @return Expression for sA
+     */
+    template <typename E>
+    MatrixScalarProduct<E,Complex<typename ExpressionTraits<E>::Real>> operator*(const MatrixExpression<E>& A, const Complex<typename ExpressionTraits<E>::Real>& s) {
+        return MatrixScalarProduct<E,Complex<typename ExpressionTraits<E>::Real>>(A.Derived(), s);
+    }
+    /**
+     * Computes \f$B=sA\f$ defined by \f$b_{ij}=sa_{ij}\f$. Evaluation is deferred until the result is assigned.
+     * The result never uses real storage, as s may not be real.
+     * @param s Complex number
+     * @param A MxN Matrix expression
+     * @return Expression for sA
+     */
+    template <typename E>
+    MatrixScalarProduct<E,Complex<typename ExpressionTraits<E>::Real>> operator*(const Complex<typename ExpressionTraits<E>::Real>& s, const MatrixExpression<E>& A) {
+        return MatrixScalarProduct<E,Complex<typename ExpressionTraits<E>::Real>>(A.Derived(), s);
+    }
+    /**
+     * Computes \f$B=A/s\f$ defined by \f$b_{ij}=a_{ij}/s\f$. Evaluation is deferred until the result is assigned.
+     * The result never uses real storage, as s may not be real.
+     * @param A MxN Matrix expression
+     * @param s Complex number
+     * @return Expression for A/s
+     */
+    template <typename E>
+    MatrixScalarQuotient<E,Complex<typename ExpressionTraits<E>::Real>> operator/(const MatrixExpression<E>& A, const Complex<typename ExpressionTraits<E>::Real>& s) {
+        return MatrixScalarQuotient<E,Complex<typename ExpressionTraits<E>::Real>>(A.Derived(), s);
+    }
+    /**
+     * Compares two expressions entrywise after evaluating them.
+     */
+    template <typename L, typename R, typename = typename std::enable_if<IsLazyExpression<L>::value || IsLazyExpression<R>::value>::type>
+    bool operator==(const MatrixExpression<L>& a, const MatrixExpression<R>& b) {
+        return EvalArgument(a.Derived()) == EvalArgument(b.Derived());
+    }
+    template <typename L, typename R, typename = typename std::enable_if<IsLazyExpression<L>::value || IsLazyExpression<R>::value>::type>
+    bool operator!=(const MatrixExpression<L>& a, const MatrixExpression<R>& b) {
+        return !(a == b);
+    }
+    /**
+     * Evaluates an expression and writes it to out, see the Matrix output operator.
+     */
+    template <typename E, typename = typename std::enable_if<IsLazyExpression<E>::value>::type>
+    std::ostream& operator<<(std::ostream& out, const MatrixExpression<E>& e) {
+        return out << e.Eval();
+    }
+}
@@ -18,10 +18,9 @@ namespace Linear {
             throw "Cannot perform entrywise product when matrices have varying sizes.";
 
         Matrix<T,M,N,Flags> ret(A.NumRows(),A.NumColumns(),T(0));
-        for (size_t i = 0; i < A.NumRows(); ++i) {
-            for (size_t j = 0; j < A.NumColumns(); ++j)
-                ret(i,j) = A(i,j)*B(i,j);
-        }
+        ForEachIndex<(Flags & ColumnMajor) != 0, ((Flags ^ Flags2) & ColumnMajor) != 0>(A.NumRows(), A.NumColumns(), [&](size_t i, size_t j) {
+            ret.At(i,j) = A.At(i,j)*B.At(i,j);
+        });
         return ret;
     }
     /**
@@ -36,10 +35,9 @@ namespace Linear {
             throw "Cannot perform entrywise division when matrices have varying sizes.";
 
         Matrix<T,M,N,Flags> ret(A.NumRows(),A.NumColumns(),T(0));
-        for (size_t i = 0; i < A.NumRows(); ++i) {
-            for (size_t j = 0; j < A.NumColumns(); ++j)
-                ret(i,j) = A(i,j)/B(i,j);
-        }
+        ForEachIndex<(Flags & ColumnMajor) != 0, ((Flags ^ Flags2) & ColumnMajor) != 0>(A.NumRows(), A.NumColumns(), [&](size_t i, size_t j) {
+            ret.At(i,j) = A.At(i,j)/B.At(i,j);
+        });
         return ret;
     }
 
@@ -74,8 +72,10 @@ namespace Linear {
             return ret;
         }
         else if (p == 2) {
-            Vector<T,N> b = Random<T>(A.NumRows(),1);
-            Eigenpair<T,N> pair = PowerIteration(ConjugateTranspose(A)*A, b, 25);
+            Vector<T,N> b = Random<T>(A.NumColumns(),1);
+            SquareMatrix<T,N,Flags> AhA;
+            Herk(1, A, OP_CONJUGATE_TRANSPOSE, 0, AhA);
+            Eigenpair<T,N> pair = PowerIteration(AhA, b, 25);
             return Sqrt(pair.value).Re;
         }
         else
@@ -148,11 +148,9 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     bool IsReal(const Matrix<T,M,N,Flags>& A) {
-        for (size_t r = 0; r < A.NumRows(); ++r) {
-            for (size_t c = 0; c < A.NumColumns(); ++c) {
-                if (!IsReal(A(r,c)))
-                    return false;
-            }
+        for (auto a : A) {
+            if (!IsReal(a))
+                return false;
         }
         return true;
     }
@@ -164,11 +162,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> Abs(Matrix<T,M,N,Flags> A) {
-        for (size_t r = 0; r < A.NumRows(); ++r) {
-            for (size_t c = 0; c < A.NumColumns(); ++c) {
-                A(r,c) = Abs(A(r,c));
-            }
-        }
+        for (auto& a : A)
+            a = Abs(a);
         return A;
     }
     /**
@@ -178,11 +173,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> Sign(Matrix<T,M,N,Flags> A) {
-        for (size_t r = 0; r < A.NumRows(); ++r) {
-            for (size_t c = 0; c < A.NumColumns(); ++c) {
-                A(r,c) = Sign(A(r,c));
-            }
-        }
+        for (auto& a : A)
+            a = Sign(a);
         return A;
     }
     /**
@@ -192,11 +184,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> Arg(Matrix<T,M,N,Flags> A) {
-        for (size_t r = 0; r < A.NumRows(); ++r) {
-            for (size_t c = 0; c < A.NumColumns(); ++c) {
-                A(r,c) = Arg(A(r,c));
-            }
-        }
+        for (auto& a : A)
+            a = Arg(a);
         return A;
     }
     /**
@@ -206,26 +195,23 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> Conjugate(Matrix<T,M,N,Flags> A) {
-        for (size_t r = 0; r < A.NumRows(); ++r) {
-            for (size_t c = 0; c < A.NumColumns(); ++c) {
-                A(r,c) = Conjugate(A(r,c));
-            }
-        }
+        for (auto& a : A)
+            a = Conjugate(a);
         return A;
     }
     /**
      * Computes the MxN Matrix \f$B\f$ defined by \f$b_{ij}=\sqrt{a_{ij}}\f$.
+     * The result never uses real storage, as the square root of a negative entry is not real.
      * @param A MxN Matrix
      * @return MxN Matrix
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
-    Matrix<T,M,N,Flags> Sqrt(Matrix<T,M,N,Flags> A) {
-        for (size_t r = 0; r < A.NumRows(); ++r) {
-            for (size_t c = 0; c < A.NumColumns(); ++c) {
-                A(r,c) = Sqrt(A(r,c));
-            }
-        }
-        return A;
+    Matrix<T,M,N,Flags & ~RealStorage> Sqrt(const Matrix<T,M,N,Flags>& A) {
+        Matrix<T,M,N,Flags & ~RealStorage> ret(A.NumRows(), A.NumColumns(), T(0));
+        ForEachIndex<(Flags & ColumnMajor) != 0, false>(A.NumRows(), A.NumColumns(), [&](size_t r, size_t c) {
+            ret.At(r,c) = Sqrt(A.At(r,c));
+        });
+        return ret;
     }
     /**
      * If \f$A\f$ is not square, it computes the MxN Matrix \f$B\f$ defined by \f$b_{ij}=e^{a_{ij}}\f$. Otherwise it computes the matrix
@@ -238,11 +224,8 @@ namespace Linear {
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> Exp(Matrix<T,M,N,Flags> A) {
         if (!IsSquare(A)) {
-            for (size_t r = 0; r < A.NumRows(); ++r) {
-                for (size_t c = 0; c < A.NumColumns(); ++c) {
-                    A(r,c) = Exp(A(r,c));
-                }
-            }
+            for (auto& a : A)
+                a = Exp(a);
             return A;
         }
         if (IsDiagonal(A)) {
@@ -253,7 +236,8 @@ namespace Linear {
         }
 
         try {
-            Eigendecomposition<T,N,Flags> eigen(A);
+            // A real matrix may still have complex eigenvalues, so decompose with complex storage.
+            Eigendecomposition<T,N,Flags & ~RealStorage> eigen(A);
             for (size_t i = 0; i < eigen.D.NumRows(); ++i) {
                 eigen.D(i,i) = Exp(eigen.D(i,i));
             }
@@ -276,11 +260,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> Log(Matrix<T,M,N,Flags> A) {
-        for (size_t r = 0; r < A.NumRows(); ++r) {
-            for (size_t c = 0; c < A.NumColumns(); ++c) {
-                A(r,c) = Log(A(r,c));
-            }
-        }
+        for (auto& a : A)
+            a = Log(a);
         return A;
     }
     /**
@@ -291,49 +272,46 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> Log(Matrix<T,M,N,Flags> A, T base) {
-        for (size_t r = 0; r < A.NumRows(); ++r) {
-            for (size_t c = 0; c < A.NumColumns(); ++c) {
-                A(r,c) = Log(A(r,c), base);
-            }
-        }
+        for (auto& a : A)
+            a = Log(a, base);
         return A;
     }
     /**
      * Computes the MxN Matrix \f$B\f$ defined by \f$b_{ij}=\log_{base} a_{ij}\f$.
+     * The result never uses real storage, as base may not be real.
      * @param A MxN Matrix
      * @param base Complex number
      * @return MxN Matrix
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
-    Matrix<T,M,N,Flags> Log(Matrix<T,M,N,Flags> A, Complex<T> base) {
-        for (size_t r = 0; r < A.NumRows(); ++r) {
-            for (size_t c = 0; c < A.NumColumns(); ++c) {
-                A(r,c) = Log(A(r,c), base);
-            }
-        }
-        return A;
+    Matrix<T,M,N,Flags & ~RealStorage> Log(const Matrix<T,M,N,Flags>& A, Complex<T> base) {
+        Matrix<T,M,N,Flags & ~RealStorage> ret(A.NumRows(), A.NumColumns(), T(0));
+        ForEachIndex<(Flags & ColumnMajor) != 0, false>(A.NumRows(), A.NumColumns(), [&](size_t r, size_t c) {
+            ret.At(r,c) = Log(A.At(r,c), base);
+        });
+        return ret;
     }
     /**
      * If \f$A\f$ is not square, it computes the MxN Matrix \f$B\f$ defined by \f$b_{ij}=a_{ij}^{power}\f$. Otherwise it attempts to computes the matrix
      * power \f$A^{power}\f$. If \f$A=VDV^{-1}\f$ with \f$D=diag(d_1,\dots,d_N)\f$ a diagonal matrix,
      * then \f$A^{power}=VD^{power}V^{-1}\f$ and \f$D^{power}=diag(d_1^{power},\dots,d_N^{power})\f$.
      * If no such decomposition can be found and power is an integer, it multiplies A by itself |power|-times then taking the inverse if power<0.
-     * Otherwise it gives up and throws an exception.
+     * Otherwise it gives up and throws an exception. The result never uses real storage, as power may not be real.
      * @param A MxN Matrix
+     * @param power Complex number
      * @return MxN Matrix
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
-    Matrix<T,M,N,Flags> Pow(Matrix<T,M,N,Flags> A, Complex<T> power) {
+    Matrix<T,M,N,Flags & ~RealStorage> Pow(const Matrix<T,M,N,Flags>& A0, Complex<T> power) {
+        // Even a real matrix can have a complex power, so always work with complex storage.
+        Matrix<T,M,N,Flags & ~RealStorage> A(A0);
         if (!IsSquare(A)) {
-            for (size_t r = 0; r < A.NumRows(); ++r) {
-                for (size_t c = 0; c < A.NumColumns(); ++c) {
-                    A(r,c) = Pow(A(r,c), power);
-                }
-            }
+            for (auto& a : A)
+                a = Pow(a, power);
             return A;
         }
         if (power == T(0))
-            return Identity<T,Flags>(A.NumRows());
+            return Identity<T,Flags & ~RealStorage>(A.NumRows());
         if (power == T(1))
             return A;
 
@@ -345,7 +323,7 @@ namespace Linear {
         }
 
         try {
-            Eigendecomposition<T,N,Flags> eigen(A);
+            Eigendecomposition<T,N,Flags & ~RealStorage> eigen(A);
             for (size_t i = 0; i < eigen.D.NumRows(); ++i) {
                 eigen.D(i,i) = Pow(eigen.D(i,i), power);
             }
@@ -354,7 +332,7 @@ namespace Linear {
         catch (...) {}
 
         if (IsReal(power) && Floor(power.Re) == power.Re) {
-            SquareMatrix<T,N,Flags> B = A;
+            SquareMatrix<T,N,Flags & ~RealStorage> B = A;
             for (size_t k = 0; k < Abs(power.Re)-1; ++k) {
                 B = B*A;
             }
@@ -366,25 +344,55 @@ namespace Linear {
 
         throw "Couldn't perform matrix power.";
     }
+    /**
+     * Computes \f$A^{power}\f$ for a real power, see Pow(Matrix,Complex). If A uses RealStorage the result does too, and it is
+     * computed in real arithmetic unless A is square, not diagonal, and power is not an integer. In that case an exception is
+     * thrown if the result turns out not to be real.
+     * @param A MxN Matrix
+     * @param power Real number
+     * @return MxN Matrix
+     */
     template <typename T, size_t M, size_t N, unsigned int Flags, typename U>
-    Matrix<T,M,N,Flags> Pow(const Matrix<T,M,N,Flags>& A, U power) {
-        return Pow(A, Complex<T>(T(power), 0));
+    Matrix<T,M,N,Flags> Pow(Matrix<T,M,N,Flags> A, U power) {
+        T p = T(power);
+        if (!(Flags & RealStorage) || (IsSquare(A) && !IsDiagonal(A) && Floor(p) != p))
+            return Pow(A, Complex<T>(p, 0));
+
+        if (!IsSquare(A) || IsDiagonal(A)) {
+            for (size_t r = 0; r < A.NumRows(); ++r) {
+                for (size_t c = 0; c < A.NumColumns(); ++c) {
+                    if (IsSquare(A) && r != c)
+                        continue;
+                    A(r,c) = Pow(A(r,c), A.ToScalar(p));
+                }
+            }
+            return A;
+        }
+        if (p == T(0))
+            return Identity<T,Flags>(A.NumRows());
+
+        SquareMatrix<T,N,Flags> B = A;
+        for (size_t k = 0; k < Abs(p)-1; ++k) {
+            B = B*A;
+        }
+        if (p < T(0))
+            return Inverse(B);
+        return B;
     }
 
     /**
      * Computes the MxN Matrix \f$B\f$ defined by \f$b_{ij}=a_{ij}\bmod z\f$.
+     * The result never uses real storage, as z may not be real.
      * @param A MxN Matrix
      * @param z Complex number
      * @return MxN Matrix
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
-    Matrix<T,M,N,Flags> Mod(Matrix<T,M,N,Flags> A, Complex<T> z) {
-        for (size_t r = 0; r < A.NumRows(); ++r) {
-            for (size_t c = 0; c < A.NumColumns(); ++c) {
-                A(r,c) = Mod(A(r,c), z);
-            }
-        }
-        return A;
+    Matrix<T,M,N,Flags & ~RealStorage> Mod(const Matrix<T,M,N,Flags>& A, Complex<T> z) {
+        Matrix<T,M,N,Flags & ~RealStorage> ret(A);
+        for (auto& a : ret)
+            a = Mod(a, z);
+        return ret;
     }
     /**
      * Computes the MxN Matrix \f$B\f$ defined by \f$b_{ij}=a_{ij}\bmod y\f$.
@@ -394,7 +402,9 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags, typename U>
     Matrix<T,M,N,Flags> Mod(Matrix<T,M,N,Flags> A, U y) {
-        return Mod(A, Complex<T>(T(y), 0));
+        for (auto& a : A)
+            a = Mod(a, T(y));
+        return A;
     }
 
     /**
@@ -404,11 +414,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> Sin(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = Sin(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = Sin(a);
          return A;
     }
     /**
@@ -418,11 +425,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> Cos(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = Cos(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = Cos(a);
          return A;
     }
     /**
@@ -432,11 +436,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> Tan(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = Tan(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = Tan(a);
          return A;
     }
     /**
@@ -446,11 +447,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> Csc(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = Csc(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = Csc(a);
          return A;
     }
     /**
@@ -460,11 +458,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> Sec(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = Sec(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = Sec(a);
          return A;
     }
     /**
@@ -474,11 +469,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> Cot(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = Cot(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = Cot(a);
          return A;
     }
     /**
@@ -488,11 +480,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> ASin(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = ASin(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = ASin(a);
          return A;
     }
     /**
@@ -502,11 +491,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> ACos(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = ACos(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = ACos(a);
          return A;
     }
     /**
@@ -516,11 +502,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> ATan(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = ATan(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = ATan(a);
          return A;
     }
     /**
@@ -530,11 +513,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> ACsc(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = ACsc(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = ACsc(a);
          return A;
     }
     /**
@@ -544,11 +524,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> ASec(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = ASec(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = ASec(a);
          return A;
     }
     /**
@@ -558,11 +535,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> ACot(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = ACot(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = ACot(a);
          return A;
     }
     /**
@@ -572,11 +546,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> Sinh(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = Sinh(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = Sinh(a);
          return A;
     }
     /**
@@ -586,11 +557,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> Cosh(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = Cosh(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = Cosh(a);
          return A;
     }
     /**
@@ -600,11 +568,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> Tanh(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = Tanh(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = Tanh(a);
          return A;
     }
     /**
@@ -614,11 +579,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> Csch(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = Csch(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = Csch(a);
          return A;
     }
     /**
@@ -628,11 +590,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> Sech(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = Sech(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = Sech(a);
          return A;
     }
     /**
@@ -642,11 +601,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> Coth(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = Coth(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = Coth(a);
          return A;
     }
     /**
@@ -656,11 +612,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> ASinh(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = ASinh(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = ASinh(a);
          return A;
     }
     /**
@@ -670,11 +623,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> ACosh(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = ACosh(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = ACosh(a);
          return A;
     }
     /**
@@ -684,11 +634,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> ATanh(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = ATanh(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = ATanh(a);
          return A;
     }
     /**
@@ -698,11 +645,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> ACsch(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = ACsch(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = ACsch(a);
          return A;
     }
     /**
@@ -712,11 +656,8 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> ASech(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = ASech(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = ASech(a);
          return A;
     }
     /**
@@ -726,11 +667,17 @@ namespace Linear {
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
     Matrix<T,M,N,Flags> ACoth(Matrix<T,M,N,Flags> A) {
-         for (size_t r = 0; r < A.NumRows(); ++r) {
-              for (size_t c = 0; c < A.NumColumns(); ++c) {
-                   A(r,c) = ACoth(A(r,c));
-              }
-         }
+         for (auto& a : A)
+              a = ACoth(a);
          return A;
     }
+
+    // Accept unevaluated expressions, e.g. EntrywiseProduct(A - B).
+    LINEAR_EVALUATE_EXPRESSIONS(EntrywiseProduct)
+    LINEAR_EVALUATE_EXPRESSIONS(EntrywiseDivision)
+    LINEAR_EVALUATE_EXPRESSIONS(Norm)
+    LINEAR_EVALUATE_EXPRESSIONS(EntrywiseNorm)
+    LINEAR_EVALUATE_EXPRESSIONS(FrobeniusNorm)
+    LINEAR_EVALUATE_EXPRESSIONS(MaxNorm)
+    LINEAR_EVALUATE_EXPRESSIONS(InfinityNorm)
 }
@@ -0,0 +1,469 @@
+#pragma once
+#include <cstddef> // For size_t
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <type_traits>
+#include "Complex.h"
+#include "Memory.h"
+#include "Simd.h"
+#include "Parallel.h"
+
+/**
+ * Bytes of the L1 data cache, L2 cache and L3 cache (per core) the matrix product blocks for. A product is split into
+ * blocks of A that stay in L2 and panels of B that stay in L3, and the innermost loop reads slivers of both that fit in
+ * L1. Define LINEAR_L1_BYTES, LINEAR_L2_BYTES or LINEAR_L3_BYTES before including Linear to override.
+ */
+#ifndef LINEAR_L1_BYTES
+#define LINEAR_L1_BYTES 32768
+#endif
+#ifndef LINEAR_L2_BYTES
+#define LINEAR_L2_BYTES 262144
+#endif
+#ifndef LINEAR_L3_BYTES
+#define LINEAR_L3_BYTES 8388608
+#endif
+
+/**
+ * Matrix products with at least this many multiply-adds (rows*columns*inner size) use the packed product, smaller ones a
+ * plain loop. Define LINEAR_GEMM_THRESHOLD before including Linear to override.
+ */
+#ifndef LINEAR_GEMM_THRESHOLD
+#define LINEAR_GEMM_THRESHOLD 4096
+#endif
+
+namespace Linear {
+    /// \cond DO_NOT_DOCUMENT
+    /**
+     * Shape of the portable micro-kernel for entries of type S, used when there is no vector kernel for S (long double)
+     * or the processor lacks the instruction sets of Simd.h. The kernel keeps an MRxNR block of C in registers.
+     */
+    template <typename S>
+    struct GemmBlocking {
+        typedef S Real;
+        static const bool IsComplex = false;
+        // Accumulators fill about half of the 16 vector registers of SSE2/NEON.
+        static const size_t MR = 4;
+        static const size_t NR = (sizeof(S) <= 4 ? 8 : (sizeof(S) <= 8 ? 4 : 2));
+    };
+
+    template <typename T>
+    struct GemmBlocking<Complex<T>> {
+        typedef T Real;
+        static const bool IsComplex = true;
+        // Real and imaginary parts each take an accumulator, so the block has half as many rows.
+        static const size_t MR = 2;
+        static const size_t NR = 2*GemmBlocking<T>::NR;
+    };
+
+    template <typename T>
+    T GemmRe(const T& x) { return x; }
+    template <typename T>
+    T GemmIm(const T&) { return T(0); }
+    template <typename T>
+    T GemmRe(const Complex<T>& z) { return z.Re; }
+    template <typename T>
+    T GemmIm(const Complex<T>& z) { return z.Im; }
+
+    template <typename T>
+    void GemmAdd(T& c, const T& re, const T&) { c += re; }
+    template <typename T>
+    void GemmAdd(Complex<T>& c, const T& re, const T& im) { c.Re += re; c.Im += im; }
+
+    template <typename T>
+    T GemmConjugate(const T& x) { return x; }
+    template <typename T>
+    Complex<T> GemmConjugate(const Complex<T>& z) { return Complex<T>(z.Re, -z.Im); }
+
+    /**
+     * Factor re+i*im an operand of the packed product is multiplied by as it is packed, after conjugating it if
+     * conjugate is true. The default leaves the operand unchanged.
+     */
+    template <typename T>
+    struct GemmScale {
+        GemmScale(T re = T(1), T im = T(0), bool conjugate = false) : re(re), im(im), conjugate(conjugate) {}
+
+        bool IsIdentity() const {
+            return this->re == T(1) && this->im == T(0) && !this->conjugate;
+        }
+        template <typename S>
+        T Re(const S& x) const {
+            if (IsIdentity())
+                return GemmRe(x);
+            return this->re*GemmRe(x) - this->im*Imaginary(x);
+        }
+        template <typename S>
+        T Im(const S& x) const {
+            if (IsIdentity())
+                return GemmIm(x);
+            return this->re*Imaginary(x) + this->im*GemmRe(x);
+        }
+
+        T re, im;
+        bool conjugate;
+    private:
+        template <typename S>
+        T Imaginary(const S& x) const {
+            return (this->conjugate ? -GemmIm(x) : GemmIm(x));
+        }
+    };
+
+    /**
+     * Copies the width-by-depth block starting at src, whose entry (i,p) is at src[i*is+p*ps], into panels of W
+     * lines each. Within a panel the W entries of each p are consecutive, followed by their W imaginary parts if complex.
+     * The last panel is padded with zeros, so the micro-kernel never checks bounds. Entries are scaled by scale.
+     */
+    template <bool IsComplex, typename T, typename S>
+    void PackPanels(const S * src, size_t width, size_t depth, size_t is, size_t ps, size_t W, T * dst,
+                    const GemmScale<T>& scale = GemmScale<T>()) {
+        const size_t step = (IsComplex ? 2*W : W);
+        for (size_t i0 = 0; i0 < width; i0 += W, dst += depth*step) {
+            size_t w = std::min(W, width-i0);
+            const S * panel = src + i0*is;
+            if (is < ps) {
+                // Entries of the same p are closest in memory, copy p by p.
+                for (size_t p = 0; p < depth; ++p) {
+                    T * d = dst + p*step;
+                    for (size_t i = 0; i < w; ++i) {
+                        d[i] = scale.Re(panel[i*is+p*ps]);
+                        if (IsComplex)
+                            d[W+i] = scale.Im(panel[i*is+p*ps]);
+                    }
+                }
+            }
+            else {
+                for (size_t i = 0; i < w; ++i) {
+                    const S * line = panel + i*is;
+                    for (size_t p = 0; p < depth; ++p) {
+                        dst[p*step+i] = scale.Re(line[p*ps]);
+                        if (IsComplex)
+                            dst[p*step+W+i] = scale.Im(line[p*ps]);
+                    }
+                }
+            }
+            if (w < W) {
+                for (size_t p = 0; p < depth; ++p) {
+                    for (size_t i = w; i < W; ++i) {
+                        dst[p*step+i] = T(0);
+                        if (IsComplex)
+                            dst[p*step+W+i] = T(0);
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * Multiplies an MRxkc panel of A by a kcxNR panel of B (see PackPanels) into the MRxNR block acc, kept in registers.
+     */
+    template <size_t MR, size_t NR, typename T>
+    void GemmMicroKernel(size_t kc, const T * a, const T * b, T * acc) {
+        T c[MR][NR] = {};
+        for (size_t p = 0; p < kc; ++p, a += MR, b += NR) {
+            for (size_t i = 0; i < MR; ++i) {
+                for (size_t j = 0; j < NR; ++j)
+                    c[i][j] += a[i]*b[j];
+            }
+        }
+        for (size_t i = 0; i < MR; ++i) {
+            for (size_t j = 0; j < NR; ++j)
+                acc[i*NR+j] = c[i][j];
+        }
+    }
+
+    /**
+     * Complex version of GemmMicroKernel. The panels hold the real parts of each p followed by the imaginary parts, and
+     * acc receives the real parts of the block followed by its imaginary parts.
+     */
+    template <size_t MR, size_t NR, typename T>
+    void GemmMicroKernelComplex(size_t kc, const T * a, const T * b, T * acc) {
+        T re[MR][NR] = {}, im[MR][NR] = {};
+        for (size_t p = 0; p < kc; ++p, a += 2*MR, b += 2*NR) {
+            for (size_t i = 0; i < MR; ++i) {
+                for (size_t j = 0; j < NR; ++j) {
+                    re[i][j] += a[i]*b[j] - a[MR+i]*b[NR+j];
+                    im[i][j] += a[i]*b[NR+j] + a[MR+i]*b[j];
+                }
+            }
+        }
+        for (size_t i = 0; i < MR; ++i) {
+            for (size_t j = 0; j < NR; ++j) {
+                acc[i*NR+j] = re[i][j];
+                acc[MR*NR+i*NR+j] = im[i][j];
+            }
+        }
+    }
+
+    /**
+     * Micro-kernel of the packed product for entries of type S, with the block sizes derived from its shape: KC is the
+     * depth of the panels, chosen so that an MRxKC panel of A and a KCxNR panel of B fill L1, MC the number of
+     * rows of A packed at once (half of L2) and NC the number of columns of B (half of L3).
+     */
+    template <typename S>
+    struct GemmKernel {
+        typedef typename GemmBlocking<S>::Real Real;
+        typedef void (*Function)(size_t kc, const Real * a, const Real * b, Real * acc);
+
+        GemmKernel(size_t mr, size_t nr, Function run) {
+            this->mr = mr;
+            this->nr = nr;
+            this->kc = std::max<size_t>(1, LINEAR_L1_BYTES/((mr+nr)*sizeof(S)));
+            this->mc = std::max(mr, LINEAR_L2_BYTES/2/(this->kc*sizeof(S))/mr*mr);
+            this->nc = std::max(nr, LINEAR_L3_BYTES/2/(this->kc*sizeof(S))/nr*nr);
+            this->run = run;
+        }
+
+        size_t mr, nr, kc, mc, nc;
+        Function run;
+    };
+
+    /**
+     * Kernels for entries of type S. Only float and double (real or complex) have vector kernels.
+     */
+    template <typename S, typename = void>
+    struct GemmKernels {
+        typedef GemmBlocking<S> Blocking;
+        typedef typename Blocking::Real T;
+
+        static GemmKernel<S> Portable() {
+            if (Blocking::IsComplex)
+                return GemmKernel<S>(Blocking::MR, Blocking::NR, &GemmMicroKernelComplex<Blocking::MR,Blocking::NR,T>);
+            return GemmKernel<S>(Blocking::MR, Blocking::NR, &GemmMicroKernel<Blocking::MR,Blocking::NR,T>);
+        }
+        static GemmKernel<S> Select(SimdLevel) {
+            return Portable();
+        }
+    };
+
+    template <typename S>
+    struct GemmKernels<S, typename std::enable_if<std::is_same<typename GemmBlocking<S>::Real,float>::value ||
+                                                  std::is_same<typename GemmBlocking<S>::Real,double>::value>::type>
+        : GemmKernels<S,bool> {
+        typedef GemmBlocking<S> Blocking;
+        typedef typename Blocking::Real T;
+
+        // Every vector kernel is two vectors wide, with as many rows as keep about half the vector registers busy
+        // accumulating (complex blocks take twice the registers).
+        static GemmKernel<S> Select(SimdLevel level) {
+            const bool C = Blocking::IsComplex;
+            switch (level) {
+#if defined(LINEAR_SIMD_X86)
+            case SimdAVX512:
+                return (C ? GemmKernel<S>(4, 2*64/sizeof(T), &GemmKernelAVX512Complex<4,2,T>)
+                          : GemmKernel<S>(8, 2*64/sizeof(T), &GemmKernelAVX512<8,2,T>));
+            case SimdAVX2:
+                return (C ? GemmKernel<S>(3, 2*32/sizeof(T), &GemmKernelAVX2Complex<3,2,T>)
+                          : GemmKernel<S>(6, 2*32/sizeof(T), &GemmKernelAVX2<6,2,T>));
+            case SimdSSE2:
+                return (C ? GemmKernel<S>(2, 2*16/sizeof(T), &GemmKernelSSE2Complex<2,2,T>)
+                          : GemmKernel<S>(4, 2*16/sizeof(T), &GemmKernelSSE2<4,2,T>));
+#elif defined(LINEAR_SIMD_NEON)
+            case SimdNEON:
+                return (C ? GemmKernel<S>(4, 2*16/sizeof(T), &GemmKernelNEONComplex<4,2,T>)
+                          : GemmKernel<S>(8, 2*16/sizeof(T), &GemmKernelNEON<8,2,T>));
+#endif
+            default:
+                return GemmKernels<S,bool>::Portable();
+            }
+        }
+    };
+
+    /**
+     * @return Kernel for entries of type S on this processor, selected on first use.
+     */
+    template <typename S>
+    const GemmKernel<S>& GetGemmKernel() {
+        static const GemmKernel<S> kernel = GemmKernels<S>::Select(DetectSimdLevel());
+        return kernel;
+    }
+
+    /**
+     * Buffer for packed panels, taken from the current default memory resource (a workspace, inside a WorkspaceScope).
+     * The default resource belongs to the thread, so loops on the thread pool take their buffers before they start
+     * (see PackLayout). An empty buffer allocates nothing.
+     */
+    template <typename T>
+    class PackBuffer {
+    public:
+        explicit PackBuffer(size_t count) {
+            this->resource = GetDefaultMemoryResource();
+            this->bytes = count*sizeof(T);
+            this->data = (count == 0 ? NULL : static_cast<T*>(this->resource->Allocate(this->bytes, LINEAR_HEAP_ALIGNMENT)));
+        }
+        ~PackBuffer() {
+            if (this->data != NULL)
+                this->resource->Deallocate(this->data, this->bytes, LINEAR_HEAP_ALIGNMENT);
+        }
+        PackBuffer(const PackBuffer&) = delete;
+        PackBuffer& operator=(const PackBuffer&) = delete;
+        T * Data() const { return this->data; }
+    private:
+        MemoryResource * resource;
+        size_t bytes;
+        T * data;
+    };
+
+    /**
+     * Sizes (in reals) of the buffers PackedMultiplyAdd() packs an mxk times kxn product into: the panels of B, the
+     * panels of A and the micro-tile accumulator. Each is rounded up so that buffers laid out one after the other all
+     * start LINEAR_HEAP_ALIGNMENT-aligned.
+     */
+    template <typename SC>
+    struct PackLayout {
+        typedef typename GemmBlocking<SC>::Real T;
+
+        PackLayout(size_t m, size_t n, size_t k, const GemmKernel<SC>& kernel) {
+            const size_t parts = (GemmBlocking<SC>::IsComplex ? 2 : 1);
+            const size_t kc = std::min(kernel.kc, k);
+            this->b = Round(parts*kc*std::min(kernel.nc, (n+kernel.nr-1)/kernel.nr*kernel.nr));
+            this->a = Round(parts*kc*std::min(kernel.mc, (m+kernel.mr-1)/kernel.mr*kernel.mr));
+            this->acc = Round(parts*kernel.mr*kernel.nr);
+        }
+        size_t Size() const { return this->b + this->a + this->acc; }
+
+        size_t b, a, acc;
+    private:
+        static size_t Round(size_t count) {
+            const size_t step = std::max<size_t>(1, LINEAR_HEAP_ALIGNMENT/sizeof(T));
+            return (count+step-1)/step*step;
+        }
+    };
+
+    /**
+     * Computes C += A*B for the mxk matrix A and kxn matrix B, both converted to the entry type of C. Entry (r,c) of each
+     * operand is at data[r*rowStride+c*columnStride], so any storage order, view or leading dimension works. B is packed
+     * NC columns and KC rows at a time, then A MC rows at a time, and the micro-kernel runs over every pair of panels.
+     * A and B are scaled by scaleA and scaleB as they are packed, which computes C += alpha*A*B or conjugates them.
+     * If lower is true, only the entries of C on or below its diagonal are updated, and micro-tiles above it are skipped.
+     * The panels are packed into space, which must hold PackLayout(m, n, k, kernel).Size() reals, or into a PackBuffer
+     * if space is NULL.
+     */
+    template <typename SA, typename SB, typename SC>
+    void PackedMultiplyAdd(size_t m, size_t n, size_t k,
+                           const SA * a, size_t ars, size_t acs,
+                           const SB * b, size_t brs, size_t bcs,
+                           SC * c, size_t crs, size_t ccs,
+                           const GemmKernel<SC>& kernel = GetGemmKernel<SC>(),
+                           const GemmScale<typename GemmBlocking<SC>::Real>& scaleA = GemmScale<typename GemmBlocking<SC>::Real>(),
+                           const GemmScale<typename GemmBlocking<SC>::Real>& scaleB = GemmScale<typename GemmBlocking<SC>::Real>(),
+                           bool lower = false, typename GemmBlocking<SC>::Real * space = NULL) {
+        typedef GemmBlocking<SC> Blocking;
+        typedef typename Blocking::Real T;
+        const size_t MR = kernel.mr, NR = kernel.nr, KC = kernel.kc, MC = kernel.mc, NC = kernel.nc;
+        const size_t parts = (Blocking::IsComplex ? 2 : 1);
+        if (m == 0 || n == 0 || k == 0)
+            return;
+
+        const PackLayout<SC> layout(m, n, k, kernel);
+        PackBuffer<T> buffer(space == NULL ? layout.Size() : 0);
+        T * const packedB = (space == NULL ? buffer.Data() : space);
+        T * const packedA = packedB + layout.b;
+        T * const acc = packedA + layout.a;
+
+        for (size_t jc = 0; jc < n; jc += NC) {
+            size_t nc = std::min(NC, n-jc);
+            for (size_t pc = 0; pc < k; pc += KC) {
+                size_t kc = std::min(KC, k-pc);
+                PackPanels<Blocking::IsComplex>(b + pc*brs + jc*bcs, nc, kc, bcs, brs, NR, packedB, scaleB);
+                for (size_t ic = 0; ic < m; ic += MC) {
+                    size_t mc = std::min(MC, m-ic);
+                    PackPanels<Blocking::IsComplex>(a + ic*ars + pc*acs, mc, kc, ars, acs, MR, packedA, scaleA);
+                    for (size_t jr = 0; jr < nc; jr += NR) {
+                        size_t nr = std::min(NR, nc-jr);
+                        const T * bPanel = packedB + jr*parts*kc;
+                        for (size_t ir = 0; ir < mc; ir += MR) {
+                            size_t mr = std::min(MR, mc-ir);
+                            if (lower && ic+ir+mr <= jc+jr)
+                                continue;
+                            kernel.run(kc, packedA + ir*parts*kc, bPanel, acc);
+                            const T * re = acc, * im = acc + (parts-1)*MR*NR;
+                            SC * block = c + (ic+ir)*crs + (jc+jr)*ccs;
+                            for (size_t i = 0; i < mr; ++i) {
+                                // Columns past the diagonal are left alone, if only the lower triangle is wanted.
+                                size_t end = (lower ? std::min(nr, std::max(ic+ir+i+1, jc+jr)-(jc+jr)) : nr);
+                                for (size_t j = 0; j < end; ++j)
+                                    GemmAdd(block[i*crs+j*ccs], re[i*NR+j], im[i*NR+j]);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * PackedMultiplyAdd() split across the shared thread pool. C is cut into a grid of about one block per thread, as
+     * close to square as the shape of C allows, and each thread computes its blocks on its own. Every entry of C is
+     * computed by one thread in the same order as without threads, so the result does not depend on the number of threads.
+     */
+    template <typename SA, typename SB, typename SC>
+    void ParallelMultiplyAdd(size_t m, size_t n, size_t k,
+                             const SA * a, size_t ars, size_t acs,
+                             const SB * b, size_t brs, size_t bcs,
+                             SC * c, size_t crs, size_t ccs,
+                             const GemmScale<typename GemmBlocking<SC>::Real>& scaleA = GemmScale<typename GemmBlocking<SC>::Real>(),
+                             const GemmScale<typename GemmBlocking<SC>::Real>& scaleB = GemmScale<typename GemmBlocking<SC>::Real>()) {
+        const GemmKernel<SC>& kernel = GetGemmKernel<SC>();
+        std::shared_ptr<ThreadPool> pool = GetThreadPool();
+        const size_t threads = pool->NumThreads();
+        size_t rows = static_cast<size_t>(std::sqrt(double(threads)*double(m)/double(std::max<size_t>(n, 1)))+0.5);
+        rows = std::min(std::max<size_t>(rows, 1), threads);
+        size_t columns = std::max<size_t>(threads/rows, 1);
+        // Blocks are whole micro-tiles, except at the edges of C.
+        const size_t mb = ((m+rows-1)/rows+kernel.mr-1)/kernel.mr*kernel.mr;
+        const size_t nb = ((n+columns-1)/columns+kernel.nr-1)/kernel.nr*kernel.nr;
+        rows = (m+mb-1)/mb;
+        columns = (n+nb-1)/nb;
+        // Each block packs into its own slice, taken here from the caller's resource.
+        const size_t slice = PackLayout<SC>(mb, nb, k, kernel).Size();
+        PackBuffer<typename GemmBlocking<SC>::Real> space(rows*columns*slice);
+        pool->ParallelFor(rows*columns, [&](size_t t) {
+            size_t i = (t/columns)*mb, j = (t%columns)*nb;
+            PackedMultiplyAdd(std::min(mb, m-i), std::min(nb, n-j), k,
+                              a + i*ars, ars, acs,
+                              b + j*bcs, brs, bcs,
+                              c + i*crs + j*ccs, crs, ccs, kernel, scaleA, scaleB, false, space.Data() + t*slice);
+        });
+    }
+
+    /**
+     * Adds alpha*X*X^H to the lower triangle (diagonal included) of the nxn matrix C, where X is the nxk matrix with
+     * entry (i,p) at x[i*xrs+p*xcs], conjugated first if conjugate is true, and X^H is its conjugate transpose. Only
+     * micro-tiles on or below the diagonal are computed, so this takes about half the multiply-adds of the full product.
+     * Large updates are cut into bands of columns, each computed from its diagonal down by one packed product, and spread
+     * over the shared thread pool; as with ParallelMultiplyAdd(), the result does not depend on the number of threads.
+     * Entries above the diagonal are untouched.
+     */
+    template <typename SX, typename SC>
+    void HermitianMultiplyAdd(size_t n, size_t k, const SX * x, size_t xrs, size_t xcs, bool conjugate,
+                              typename GemmBlocking<SC>::Real alpha, SC * c, size_t crs, size_t ccs) {
+        typedef typename GemmBlocking<SC>::Real T;
+        if (n == 0 || k == 0)
+            return;
+        const GemmKernel<SC>& kernel = GetGemmKernel<SC>();
+        // Conjugating real entries is a no-op; leaving it out keeps the packing on its unscaled path.
+        const GemmScale<T> scaleX(alpha, T(0), GemmBlocking<SC>::IsComplex && conjugate);
+        const GemmScale<T> scaleXh(T(1), T(0), GemmBlocking<SC>::IsComplex && !conjugate);
+        const bool parallel = (n*n*k/2 >= LINEAR_PARALLEL_THRESHOLD && GetNumThreads() > 1);
+        // Two bands per thread even out their different heights.
+        size_t band = (parallel ? (n+2*GetNumThreads()-1)/(2*GetNumThreads()) : n);
+        band = std::max<size_t>(1, (band+kernel.nr-1)/kernel.nr)*kernel.nr;
+        const size_t bands = (n+band-1)/band;
+        // Each band packs into its own slice, sized for the tallest one and taken here from the caller's resource.
+        const size_t slice = PackLayout<SC>(n, band, k, kernel).Size();
+        PackBuffer<T> space((parallel ? bands : 1)*slice);
+        // The first bands have the most rows below the diagonal, so they are handed out first.
+        auto run = [&](size_t t) {
+            size_t j0 = t*band;
+            PackedMultiplyAdd(n-j0, std::min(band, n-j0), k, x + j0*xrs, xrs, xcs, x + j0*xrs, xcs, xrs, c + j0*crs + j0*ccs,
+                              crs, ccs, kernel, scaleX, scaleXh, true, space.Data() + (parallel ? t*slice : 0));
+        };
+        if (parallel)
+            GetThreadPool()->ParallelFor(bands, run);
+        else {
+            for (size_t t = 0; t < bands; ++t)
+                run(t);
+        }
+    }
+    /// \endcond
+}
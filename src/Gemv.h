@@ -0,0 +1,249 @@
+#pragma once
+#include <cstddef> // For size_t
+#include <algorithm>
+#include <type_traits>
+#include "Complex.h"
+#include "Simd.h"
+#include "Parallel.h"
+#include "Gemm.h"
+
+namespace Linear {
+    /// \cond DO_NOT_DOCUMENT
+    /**
+     * Portable versions of the matrix-vector kernels of Simd.h (see LINEAR_SIMD_GEMV_KERNELS), for entries without vector
+     * kernels (long double) or processors lacking the instruction sets of Simd.h.
+     */
+    template <typename T>
+    void GemvColumnsPortable(size_t rows, size_t n, const T * a, size_t lda, const T * xr, const T * xi, T * acc1, T * acc2) {
+        std::fill(acc1, acc1 + rows, T(0));
+        if (xi != NULL)
+            std::fill(acc2, acc2 + rows, T(0));
+        for (size_t j = 0; j < n; ++j, a += lda) {
+            for (size_t i = 0; i < rows; ++i)
+                acc1[i] += a[i]*xr[j];
+            if (xi != NULL) {
+                for (size_t i = 0; i < rows; ++i)
+                    acc2[i] += a[i]*xi[j];
+            }
+        }
+    }
+
+    template <typename T>
+    void GemvRowsPortable(size_t count, size_t k, const T * a, size_t lda, const T * v, const T * w, T * sums) {
+        for (size_t r = 0; r < count; ++r, a += lda) {
+            T s[4] = {};
+            for (size_t j = 0; j < k; ++j) {
+                s[j%2] += a[j]*v[j];
+                if (w != NULL)
+                    s[2+j%2] += a[j]*w[j];
+            }
+            std::copy(s, s + 4, sums + 4*r);
+        }
+    }
+
+    /**
+     * Matrix-vector kernels for reals of type T: columns walks a matrix stored by columns, rows one stored by rows.
+     */
+    template <typename T>
+    struct GemvKernel {
+        typedef void (*Columns)(size_t, size_t, const T *, size_t, const T *, const T *, T *, T *);
+        typedef void (*Rows)(size_t, size_t, const T *, size_t, const T *, const T *, T *);
+
+        GemvKernel(Columns columns, Rows rows) : columns(columns), rows(rows) {}
+
+        Columns columns;
+        Rows rows;
+    };
+
+    template <typename T, typename = void>
+    struct GemvKernels {
+        static GemvKernel<T> Select(SimdLevel) {
+            return GemvKernel<T>(&GemvColumnsPortable<T>, &GemvRowsPortable<T>);
+        }
+    };
+
+    template <typename T>
+    struct GemvKernels<T, typename std::enable_if<std::is_same<T,float>::value || std::is_same<T,double>::value>::type> {
+        static GemvKernel<T> Select(SimdLevel level) {
+            switch (level) {
+#if defined(LINEAR_SIMD_X86)
+            case SimdAVX512:
+                return GemvKernel<T>(&GemvKernelAVX512Columns<T>, &GemvKernelAVX512Rows<T>);
+            case SimdAVX2:
+                return GemvKernel<T>(&GemvKernelAVX2Columns<T>, &GemvKernelAVX2Rows<T>);
+            case SimdSSE2:
+                return GemvKernel<T>(&GemvKernelSSE2Columns<T>, &GemvKernelSSE2Rows<T>);
+#elif defined(LINEAR_SIMD_NEON)
+            case SimdNEON:
+                return GemvKernel<T>(&GemvKernelNEONColumns<T>, &GemvKernelNEONRows<T>);
+#endif
+            default:
+                return GemvKernels<T,bool>::Select(level);
+            }
+        }
+    };
+
+    /**
+     * @return Matrix-vector kernels for reals of type T on this processor, selected on first use.
+     */
+    template <typename T>
+    const GemvKernel<T>& GetGemvKernel() {
+        static const GemvKernel<T> kernel = GemvKernels<T>::Select(DetectSimdLevel());
+        return kernel;
+    }
+
+    /**
+     * Entries as an array of reals of type T: complex entries are their real part followed by their imaginary part, which
+     * is how Complex is laid out. Entries of another real type give NULL, and are never handed to the kernels.
+     */
+    template <typename T, typename S>
+    const T * GemvReals(const S * p) {
+        static_assert(sizeof(Complex<T>) == 2*sizeof(T), "Complex entries must be two reals.");
+        return (std::is_same<typename GemmBlocking<S>::Real,T>::value ? reinterpret_cast<const T*>(p) : NULL);
+    }
+
+    /**
+     * Adds alpha*op(A)*x to y one entry at a time, for operands whose entries are not adjacent in memory.
+     */
+    template <typename SA, typename SX, typename SC, typename T>
+    void StridedGemv(size_t begin, size_t end, size_t n, const SA * a, size_t ars, size_t acs, bool conjA,
+                     const SX * x, size_t xs, bool conjX, T alphaRe, T alphaIm, SC * y, size_t ys) {
+        for (size_t i = begin; i < end; ++i) {
+            SC sum = SC(0);
+            for (size_t j = 0; j < n; ++j) {
+                const SA& u = a[i*ars+j*acs];
+                const SX& v = x[j*xs];
+                sum += (conjA ? GemmConjugate(u) : u)*(conjX ? GemmConjugate(v) : v);
+            }
+            GemmAdd(y[i*ys], alphaRe*GemmRe(sum) - alphaIm*GemmIm(sum), alphaRe*GemmIm(sum) + alphaIm*GemmRe(sum));
+        }
+    }
+
+    /**
+     * Computes y += A*x for the mxn matrix A with entry (i,j) at a[i*ars+j*acs] and the vector x with entry j at x[j*xs],
+     * each scaled and conjugated by its GemmScale as in PackedMultiplyAdd(). This is the product of a matrix and a single
+     * column, so unlike the packed product it reads every entry of A once and is bound by memory bandwidth, not
+     * arithmetic: nothing is packed, and transposed operands are walked through their strides.
+     *
+     * If A is stored by columns (ars = 1), the columns are added up into a block of y held in vector registers; if it is
+     * stored by rows (acs = 1), each row is reduced against x, four rows at a time. Complex entries are treated as pairs
+     * of reals, with x laid out to match so that the kernels are the same for real and complex matrices. Large products
+     * are split into bands of rows across the shared thread pool; every entry of y is summed in the same order either way.
+     * The buffers are all taken by the calling thread before the bands start, see PackBuffer.
+     */
+    template <typename SA, typename SX, typename SC>
+    void GemvMultiplyAdd(size_t m, size_t n, const SA * a, size_t ars, size_t acs,
+                         const GemmScale<typename GemmBlocking<SC>::Real>& scaleA,
+                         const SX * x, size_t xs, const GemmScale<typename GemmBlocking<SC>::Real>& scaleX,
+                         SC * y, size_t ys) {
+        typedef typename GemmBlocking<SC>::Real T;
+        const bool CA = GemmBlocking<SA>::IsComplex, CX = GemmBlocking<SX>::IsComplex, CC = GemmBlocking<SC>::IsComplex;
+        if (m == 0 || n == 0)
+            return;
+        // The factors of both operands combine into one; conjugating real entries changes nothing.
+        const bool conjA = CA && scaleA.conjugate, conjX = CX && scaleX.conjugate;
+        const T alphaRe = scaleA.re*scaleX.re - scaleA.im*scaleX.im;
+        const T alphaIm = (CC ? scaleA.re*scaleX.im + scaleA.im*scaleX.re : T(0));
+
+        const bool parallel = (m*n >= LINEAR_PARALLEL_THRESHOLD && GetNumThreads() > 1);
+        const size_t band = (parallel ? std::max<size_t>((m+GetNumThreads()-1)/GetNumThreads(), 64) : m);
+        auto forBands = [&](const auto& run) {
+            if (parallel) {
+                GetThreadPool()->ParallelFor((m+band-1)/band, [&](size_t t) {
+                    run(t*band, std::min(m, (t+1)*band));
+                });
+            }
+            else
+                run(0, m);
+        };
+
+        const bool vectorizable = std::is_same<typename GemmBlocking<SA>::Real,T>::value &&
+                                  std::is_same<typename GemmBlocking<SX>::Real,T>::value;
+        if (!vectorizable || (ars != 1 && acs != 1)) {
+            forBands([&](size_t begin, size_t end) {
+                StridedGemv(begin, end, n, a, ars, acs, conjA, x, xs, conjX, alphaRe, alphaIm, y, ys);
+            });
+            return;
+        }
+        const GemvKernel<T>& kernel = GetGemvKernel<T>();
+        const size_t parts = (CA ? 2 : 1);
+        const T * reals = GemvReals<T>(a);
+
+        if (acs != 1) {
+            // By columns: alpha*x goes into the kernel as real and imaginary parts, and the sums of each real of A
+            // against both are combined into y. The imaginary part is only needed if y is complex and x or alpha is.
+            const bool two = CC && (CX || alphaIm != T(0));
+            PackBuffer<T> xr(n), xi(two ? n : 1), acc1(parts*m), acc2(two ? parts*m : 1);
+            for (size_t j = 0; j < n; ++j) {
+                const T re = GemmRe(x[j*xs]), im = (conjX ? -GemmIm(x[j*xs]) : GemmIm(x[j*xs]));
+                xr.Data()[j] = alphaRe*re - alphaIm*im;
+                if (two)
+                    xi.Data()[j] = alphaRe*im + alphaIm*re;
+            }
+            forBands([&](size_t begin, size_t end) {
+                T * s1 = acc1.Data() + parts*begin, * s2 = acc2.Data() + (two ? parts*begin : 0);
+                kernel.columns(parts*(end-begin), n, reals + parts*begin, parts*acs, xr.Data(), (two ? xi.Data() : NULL), s1, s2);
+                for (size_t i = 0; i < end-begin; ++i) {
+                    T re, im;
+                    if (CA) {
+                        const T r1 = s1[2*i], i1 = s1[2*i+1], r2 = (two ? s2[2*i] : T(0)), i2 = (two ? s2[2*i+1] : T(0));
+                        re = (conjA ? r1 + i2 : r1 - i2);
+                        im = (conjA ? r2 - i1 : r2 + i1);
+                    }
+                    else {
+                        re = s1[i];
+                        im = (two ? s2[i] : T(0));
+                    }
+                    GemmAdd(y[(begin+i)*ys], re, im);
+                }
+            });
+            return;
+        }
+
+        // By rows: each row of reals is reduced against v (and w), whose layout makes the even and odd sums the parts
+        // of the product:
+        //   complex A, complex x: v = (xr0, xi0, xr1, xi1, ...), w = (xi0, xr0, xi1, xr1, ...)
+        //   complex A, real x:    v = (x0, x0, x1, x1, ...)
+        //   real A, complex x:    v = xr, w = xi
+        //   real A, real x:       v = x
+        const size_t k = parts*n;
+        PackBuffer<T> v(k), w(CX ? k : 1), sums(4*m);
+        for (size_t j = 0; j < n; ++j) {
+            const T re = GemmRe(x[j*xs]), im = (conjX ? -GemmIm(x[j*xs]) : GemmIm(x[j*xs]));
+            if (CA) {
+                v.Data()[2*j] = re;
+                v.Data()[2*j+1] = (CX ? im : re);
+                if (CX) {
+                    w.Data()[2*j] = im;
+                    w.Data()[2*j+1] = re;
+                }
+            }
+            else {
+                v.Data()[j] = re;
+                if (CX)
+                    w.Data()[j] = im;
+            }
+        }
+        forBands([&](size_t begin, size_t end) {
+            T * s = sums.Data() + 4*begin;
+            kernel.rows(end-begin, k, reals + parts*begin*ars, parts*ars, v.Data(), (CX ? w.Data() : NULL), s);
+            for (size_t i = 0; i < end-begin; ++i, s += 4) {
+                T re, im;
+                if (CA && CX) {
+                    re = (conjA ? s[0] + s[1] : s[0] - s[1]);
+                    im = (conjA ? s[2] - s[3] : s[2] + s[3]);
+                }
+                else if (CA) {
+                    re = s[0];
+                    im = (conjA ? -s[1] : s[1]);
+                }
+                else {
+                    re = s[0] + s[1];
+                    im = s[2] + s[3];
+                }
+                GemmAdd(y[(begin+i)*ys], alphaRe*re - alphaIm*im, alphaRe*im + alphaIm*re);
+            }
+        });
+    }
+    /// \endcond
+}
@@ -2,6 +2,19 @@
 #include <cstddef> // For size_t
 #include "Complex.h"
 
+/**
+ * Whether operator() and operator[] of matrices and views check their indices and throw when they are out of range.
+ * Defaults to on, unless NDEBUG is defined (release builds). Define LINEAR_BOUNDS_CHECK to 0 or 1 before including
+ * Linear to override. The At() accessors never check.
+ */
+#ifndef LINEAR_BOUNDS_CHECK
+#ifdef NDEBUG
+#define LINEAR_BOUNDS_CHECK 0
+#else
+#define LINEAR_BOUNDS_CHECK 1
+#endif
+#endif
+
 namespace Linear {
     double Tol = 0.00001;
 }
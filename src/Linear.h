@@ -9,6 +9,8 @@
 #include "Functions.h"
 #include "Misc.h"
 #include "Types.h"
+#include "Split.h"
+#include "Batch.h"
 
 /*! \mainpage Overview
  *
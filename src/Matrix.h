@@ -1,40 +1,62 @@
 #pragma once
 #include <sstream>
+#include <algorithm>
 #include "Complex.h"
+#include "Storage.h"
+#include "Expression.h"
+#include "View.h"
+#include "Gemm.h"
+#include "Strassen.h"
+#include "Small.h"
 #include "Global.h"
 
 namespace Linear {
-    const unsigned int Dynamic = 0;
-    const unsigned int RowMajor = 0x0000;
-    const unsigned int ColumnMajor = 0x0001;
-
     /**
      * Class for matrices.
      * @param T Type to store the real and imaginary part of each entry as.
      * @param M Number of rows. Use Dynamic to allow this value to change over time.
      * @param N Number of column. Use Dynamic to allow this value to change over time.
-     * @param Flags Whether to use row major storage or column major storage. (default = row major).
+     * @param Flags Whether to use row major storage or column major storage. (default = row major). Add RealStorage to
+     * store each entry as a single T instead of a Complex<T>; such a matrix can only hold real numbers. Add CopyOnWrite to
+     * let copies of a dynamically sized matrix share their entries until one of them is written to.
      */
     template<typename T, size_t M, size_t N, unsigned int Flags = 0>
-    class Matrix {
+    class Matrix : public MatrixExpression<Matrix<T,M,N,Flags>> {
     public:
+        /**
+         * Type used to store each entry: T if Flags contains RealStorage, Complex<T> otherwise.
+         */
+        typedef typename ScalarTraits<T,(Flags & RealStorage) != 0>::Scalar Scalar;
+
+        /**
+         * Converts a number to the type used to store each entry.
+         * @param x Real number
+         * @return x
+         */
+        static Scalar ToScalar(T x) {
+            return x;
+        }
+        /**
+         * Converts a number to the type used to store each entry. If the matrix uses RealStorage, the imaginary part of z is
+         * dropped when it is within Tol (relative to the real part), otherwise an exception is thrown.
+         * @param z Complex number
+         * @return z
+         */
+        static Scalar ToScalar(const Complex<T>& z) {
+            return ScalarTraits<T,(Flags & RealStorage) != 0>::FromComplex(z);
+        }
+
         /**
          * Constructor.
          * Creates the M-by-N matrix \f$A\f$ where \f$a_{ij}=x\f$ for all \f$i,j\f$. If M or N are set to Dynamic, a 0x0 matrix will be created.
          * @param x Real number (default = 0)
          */
         Matrix(T x = T(0)) {
-            if (M == Dynamic || N == Dynamic) {
-                this->m = M;
-                this->n = N;
-                this->data = NULL;
+            if (M == Dynamic || N == Dynamic)
                 return;
-            }
-            this->m = M;
-            this->n = N;
-            this->data = new Complex<T>[this->m*this->n];
-            for (size_t i = 0; i < this->m*this->n; ++i) {
-                this->data[i] = x;
+            Scalar * data = WritableData();
+            for (size_t i = 0; i < NumEntries(); ++i) {
+                data[i] = x;
             }
         }
         /**
@@ -43,17 +65,12 @@ namespace Linear {
          * @param val Complex number
          */
         Matrix(Complex<T> z) {
-            if (M == Dynamic || N == Dynamic) {
-                this->m = M;
-                this->n = N;
-                this->data = NULL;
+            if (M == Dynamic || N == Dynamic)
                 return;
-            }
-            this->m = M;
-            this->n = N;
-            this->data = new Complex<T>[this->m*this->n];
-            for (size_t i = 0; i < this->m*this->n; ++i) {
-                this->data[i] = z;
+            Scalar * data = WritableData();
+            Scalar value = ToScalar(z);
+            for (size_t i = 0; i < NumEntries(); ++i) {
+                data[i] = value;
             }
         }
         /**
@@ -64,17 +81,10 @@ namespace Linear {
          * @param x Real number (default = 0)
          */
         Matrix(size_t size, T x) {
-            this->m = M;
-            this->n = N;
-            if (M == Dynamic) { this->m = size; }
-            if (N == Dynamic) { this->n = size; }
-            if (this->m == 0 || this->n == 0) {
-                this->data = NULL;
-                return;
-            }
-            this->data = new Complex<T>[this->m*this->n];
-            for (size_t i = 0; i < this->m*this->n; ++i) {
-                this->data[i] = x;
+            this->storage.Allocate((M == Dynamic ? size : M), (N == Dynamic ? size : N));
+            Scalar * data = WritableData();
+            for (size_t i = 0; i < NumEntries(); ++i) {
+                data[i] = x;
             }
         }
         /**
@@ -85,17 +95,11 @@ namespace Linear {
          * @param z Complex number
          */
         Matrix(size_t size, Complex<T> z) {
-            this->m = M;
-            this->n = N;
-            if (M == Dynamic) { this->m = size; }
-            if (N == Dynamic) { this->n = size; }
-            if (this->m == 0 || this->n == 0) {
-                this->data = NULL;
-                return;
-            }
-            this->data = new Complex<T>[this->m*this->n];
-            for (size_t i = 0; i < this->m*this->n; ++i) {
-                this->data[i] = z;
+            this->storage.Allocate((M == Dynamic ? size : M), (N == Dynamic ? size : N));
+            Scalar * data = WritableData();
+            Scalar value = ToScalar(z);
+            for (size_t i = 0; i < NumEntries(); ++i) {
+                data[i] = value;
             }
         }
         /**
@@ -107,17 +111,10 @@ namespace Linear {
          * @param x Real number (default = 0)
          */
         Matrix(size_t nrows, size_t ncols, T x) {
-            this->m = M;
-            this->n = N;
-            if (M == Dynamic) { this->m = nrows; }
-            if (N == Dynamic) { this->n = ncols; }
-            if (this->m == 0 || this->n == 0) {
-                this->data = NULL;
-                return;
-            }
-            this->data = new Complex<T>[this->m*this->n];
-            for (size_t i = 0; i < this->m*this->n; ++i) {
-                this->data[i] = x;
+            this->storage.Allocate((M == Dynamic ? nrows : M), (N == Dynamic ? ncols : N));
+            Scalar * data = WritableData();
+            for (size_t i = 0; i < NumEntries(); ++i) {
+                data[i] = x;
             }
         }
         /**
@@ -129,17 +126,11 @@ namespace Linear {
          * @param z Complex number
          */
         Matrix(size_t nrows, size_t ncols, Complex<T> z) {
-            this->m = M;
-            this->n = N;
-            if (M == Dynamic) { this->m = nrows; }
-            if (N == Dynamic) { this->n = ncols; }
-            if (this->m == 0 || this->n == 0) {
-                this->data = NULL;
-                return;
-            }
-            this->data = new Complex<T>[this->m*this->n];
-            for (size_t i = 0; i < this->m*this->n; ++i) {
-                this->data[i] = z;
+            this->storage.Allocate((M == Dynamic ? nrows : M), (N == Dynamic ? ncols : N));
+            Scalar * data = WritableData();
+            Scalar value = ToScalar(z);
+            for (size_t i = 0; i < NumEntries(); ++i) {
+                data[i] = value;
             }
         }
         /**
@@ -154,27 +145,25 @@ namespace Linear {
          * @param list Initializer list of real numbers
          */
         Matrix(std::initializer_list<T> list) {
-            this->m = M;
-            this->n = N;
-            if (M == Dynamic && N == Dynamic) { this->m = 1; this->n = list.size(); }
-            if (M != Dynamic && N == Dynamic) { this->n = (list.size() >= this->m ? list.size() / this->m : 1); }
-            if (M == Dynamic && N != Dynamic) { this->m = (list.size() >= this->n ? list.size() / this->n : 1); }
-            if (this->m == 0 || this->n == 0) {
-                this->data = NULL;
+            size_t m = M, n = N;
+            if (M == Dynamic && N == Dynamic) { m = 1; n = list.size(); }
+            if (M != Dynamic && N == Dynamic) { n = (list.size() >= m ? list.size() / m : 1); }
+            if (M == Dynamic && N != Dynamic) { m = (list.size() >= n ? list.size() / n : 1); }
+            this->storage.Allocate(m, n);
+            if (NumEntries() == 0)
                 return;
-            }
-            this->data = new Complex<T>[this->m*this->n];
+            Scalar * data = WritableData();
             size_t i = 0;
             for (auto it = std::begin(list); it != std::end(list); ++it) {
-                this->data[i] = *it;
+                data[i] = *it;
                 i += 1;
-                if (i == this->m*this->n)
+                if (i == NumEntries())
                     break;
             }
 
             // Fill the remaining entries with zero.
-            for (; i < this->m*this->n; ++i)
-                this->data[i] = T(0);
+            for (; i < NumEntries(); ++i)
+                data[i] = T(0);
         }
         /**
          * Constructor.
@@ -188,27 +177,25 @@ namespace Linear {
          * @param list Initializer list of Complex numbers
          */
         Matrix(std::initializer_list<Complex<T>> list) {
-            this->m = M;
-            this->n = N;
-            if (M == Dynamic && N == Dynamic) { this->m = 1; this->n = list.size(); }
-            if (M != Dynamic && N == Dynamic) { this->n = (list.size() >= this->m ? list.size() / this->m : 1); }
-            if (M == Dynamic && N != Dynamic) { this->m = (list.size() >= this->n ? list.size() / this->n : 1); }
-            if (this->m == 0 || this->n == 0) {
-                this->data = NULL;
+            size_t m = M, n = N;
+            if (M == Dynamic && N == Dynamic) { m = 1; n = list.size(); }
+            if (M != Dynamic && N == Dynamic) { n = (list.size() >= m ? list.size() / m : 1); }
+            if (M == Dynamic && N != Dynamic) { m = (list.size() >= n ? list.size() / n : 1); }
+            this->storage.Allocate(m, n);
+            if (NumEntries() == 0)
                 return;
-            }
-            this->data = new Complex<T>[this->m*this->n];
+            Scalar * data = WritableData();
             size_t i = 0;
             for (auto it = std::begin(list); it != std::end(list); ++it) {
-                this->data[i] = *it;
+                data[i] = ToScalar(*it);
                 i += 1;
-                if (i == this->m*this->n)
+                if (i == NumEntries())
                     break;
             }
 
             // Fill the remaining entries with zero.
-            for (; i < this->m*this->n; ++i)
-                this->data[i] = T(0);
+            for (; i < NumEntries(); ++i)
+                data[i] = T(0);
         }
         /**
          * Constructor.
@@ -221,30 +208,28 @@ namespace Linear {
          * @param list Initializer list of initializer lists of real numbers.
          */
         Matrix(std::initializer_list<std::initializer_list<T>> list) {
-            this->m = M;
-            this->n = N;
-            if (M == Dynamic) { this->m = list.size(); }
+            size_t m = M, n = N;
+            if (M == Dynamic) { m = list.size(); }
             if (N == Dynamic) {
                 for (auto it = std::begin(list); it != std::end(list); ++it) {
-                    if ((*it).size() > this->n)
-                        this->n = (*it).size();
+                    if ((*it).size() > n)
+                        n = (*it).size();
                 }
             }
-            if (this->m == 0 || this->n == 0) {
-                this->data = NULL;
+            this->storage.Allocate(m, n);
+            if (NumEntries() == 0)
                 return;
-            }
-            this->data = new Complex<T>[this->m*this->n];
+            Scalar * data = WritableData();
             size_t r = 0;
             for (auto it = std::begin(list); it != std::end(list); ++it) {
                 size_t c = 0;
                 for (auto it2 = std::begin(*it); it2 != std::end(*it); ++it2) {
-                    (*this)(r,c) = *it2;
+                    data[Offset(r,c)] = *it2;
                     c += 1;
                 }
                 // Fill the remaining entries with zero.
                 for (; c < NumColumns(); ++c)
-                    (*this)(r,c) = T(0);
+                    data[Offset(r,c)] = T(0);
 
                 r += 1;
                 if (r == NumRows())
@@ -254,7 +239,7 @@ namespace Linear {
             // Fill the remaining entries with zero.
             for (; r < NumRows(); ++r) {
                 for (size_t c = 0; c < NumColumns(); ++c) {
-                    (*this)(r,c) = T(0);
+                    data[Offset(r,c)] = T(0);
                 }
             }
         }
@@ -269,30 +254,28 @@ namespace Linear {
          * @param list Initializer list of initializer lists of complex numbers.
          */
         Matrix(std::initializer_list<std::initializer_list<Complex<T>>> list) {
-            this->m = M;
-            this->n = N;
-            if (M == Dynamic) { this->m = list.size(); }
+            size_t m = M, n = N;
+            if (M == Dynamic) { m = list.size(); }
             if (N == Dynamic) {
                 for (auto it = std::begin(list); it != std::end(list); ++it) {
-                    if ((*it).size() > this->n)
-                        this->n = (*it).size();
+                    if ((*it).size() > n)
+                        n = (*it).size();
                 }
             }
-            if (this->m == 0 || this->n == 0) {
-                this->data = NULL;
+            this->storage.Allocate(m, n);
+            if (NumEntries() == 0)
                 return;
-            }
-            this->data = new Complex<T>[this->m*this->n];
+            Scalar * data = WritableData();
             size_t r = 0;
             for (auto it = std::begin(list); it != std::end(list); ++it) {
                 size_t c = 0;
                 for (auto it2 = std::begin(*it); it2 != std::end(*it); ++it2) {
-                    (*this)(r,c) = *it2;
+                    data[Offset(r,c)] = ToScalar(*it2);
                     c += 1;
                 }
                 // Fill the remaining entries with zero.
                 for (; c < NumColumns(); ++c)
-                    (*this)(r,c) = T(0);
+                    data[Offset(r,c)] = T(0);
 
                 r += 1;
                 if (r == NumRows())
@@ -302,34 +285,35 @@ namespace Linear {
             // Fill the remaining entries with zero.
             for (; r < NumRows(); ++r) {
                 for (size_t c = 0; c < NumColumns(); ++c) {
-                    (*this)(r,c) = T(0);
+                    data[Offset(r,c)] = T(0);
                 }
             }
         }
         /**
          * Constructor.
-         * Copies the MxN matrix other.
+         * Copies the MxN matrix other. With CopyOnWrite, the copy shares the entries of other until either is written to.
          *
          * @param other MxN Matrix
          */
-        Matrix(const Matrix<T,M,N,Flags>& copy) {
-            this->m = M;
-            this->n = N;
-            if (M == Dynamic) { this->m = copy.NumRows(); }
-            if (N == Dynamic) { this->n = copy.NumColumns(); }
-            if (this->m == 0 || this->n == 0) {
-                this->data = NULL;
-                return;
-            }
-            this->data = new Complex<T>[this->m*this->n];
-            if (NumRows() != copy.NumRows() || NumColumns() != copy.NumColumns())
-                throw "Cannot assign matrix to a matrix of different size.";
-
-            for (size_t r = 0; r < NumRows(); ++r) {
-                for (size_t c = 0; c < NumColumns(); ++c) {
-                    (*this)(r,c) = copy(r,c);
-                }
-            }
+        Matrix(const Matrix<T,M,N,Flags>& copy) : storage(copy.storage) {}
+        /**
+         * Constructor.
+         * Takes over the entries of other. If the matrix is dynamically sized no entries are copied, and other is left as an
+         * empty matrix.
+         *
+         * @param other MxN Matrix
+         */
+        Matrix(Matrix<T,M,N,Flags>&& other) noexcept : storage(std::move(other.storage)) {}
+        /**
+         * Constructor.
+         * Takes over the entries of a matrix stored in the other order (row major instead of column major or vice versa),
+         * rearranging them in place. If the matrix is dynamically sized, no second array is allocated and other is left as
+         * an empty matrix.
+         *
+         * @param other MxN Matrix stored in the other order
+         */
+        Matrix(Matrix<T,M,N,(Flags ^ ColumnMajor)>&& other) {
+            this->storage.AdoptTransposed(other.storage);
         }
         /**
          * Constructor.
@@ -343,23 +327,29 @@ namespace Linear {
          */
         template<typename U,size_t P, size_t Q, unsigned int Flags2>
         Matrix(const Matrix<U,P,Q,Flags2>& other) {
-            this->m = M;
-            this->n = N;
-            if (M == Dynamic) { this->m = other.NumRows(); }
-            if (N == Dynamic) { this->n = other.NumColumns(); }
-            if (this->m == 0 || this->n == 0) {
-                this->data = NULL;
+            this->storage.Allocate((M == Dynamic ? other.NumRows() : M), (N == Dynamic ? other.NumColumns() : N));
+            if (NumEntries() == 0)
                 return;
-            }
-            this->data = new Complex<T>[this->m*this->n];
             if (NumRows() != other.NumRows() || NumColumns() != other.NumColumns())
                 throw "Cannot assign matrix to a matrix of different size.";
 
-            for (size_t r = 0; r < NumRows(); ++r) {
-                for (size_t c = 0; c < NumColumns(); ++c) {
-                    (*this)(r,c) = (Complex<T>)other(r,c);
-                }
-            }
+            Scalar * data = WritableData();
+            ForEachIndex<(Flags & ColumnMajor) != 0, ((Flags ^ Flags2) & ColumnMajor) != 0>(NumRows(), NumColumns(), [&](size_t r, size_t c) {
+                data[Offset(r,c)] = ToScalar(Complex<T>(other.At(r,c)));
+            });
+        }
+        /**
+         * Constructor.
+         * Evaluates the expression e (e.g. A+2*B) into a new matrix, computing each entry once. If M or N is Dynamic it is
+         * taken from e. Otherwise, if the sizes differ, an exception is raised.
+         * @param e Matrix expression
+         */
+        template <typename E>
+        Matrix(const MatrixExpression<E>& e) {
+            this->storage.Allocate((M == Dynamic ? e.NumRows() : M), (N == Dynamic ? e.NumColumns() : N));
+            if (NumRows() != e.NumRows() || NumColumns() != e.NumColumns())
+                throw "Cannot assign matrix to a matrix of different size.";
+            Assign(e.Derived());
         }
 
         /**
@@ -370,50 +360,14 @@ namespace Linear {
          * @param newSize New number of rows/columns
          */
         void Resize(size_t newSize) {
-            if (M != Dynamic && N != Dynamic)
-                throw "Cannot resize statically sized matrices.";
-
-            size_t oldM = this->m, oldN = this->n;
-            if (M == Dynamic) { this->m = newSize; }
-            else { this->m = M; }
-            if (N == Dynamic) { this->n = newSize; }
-            else { this->n = N; }
-
-            if (this->m == oldM && this->n == oldN)
-                return;
-            if (this->m == 0 || this->n == 0) {
-                if (this->data != NULL)
-                    delete this->data;
-                this->data = NULL;
-                return;
-            }
-
-            Complex<T> * oldData = this->data;
-            this->data = new Complex<T>[this->m*this->n];
-            for (size_t r = 0; r < this->m; ++r) {
-                for (size_t c = 0; c < this->n; ++c) {
-                    if (r >= oldM || c >= oldN) {
-                        if (Flags & ColumnMajor)
-                            this->data[c*this->m+r] = T(0);
-                        else
-                            this->data[r*this->n+c] = T(0);
-                    }
-                    else if (oldData != NULL) {
-                        if (Flags & ColumnMajor)
-                            this->data[c*this->m+r] = oldData[c*oldM+r];
-                        else
-                            this->data[r*this->n+c] = oldData[r*oldN+c];
-                    }
-                }
-            }
-            if (oldData != NULL)
-                delete oldData;
+            Resize(newSize, newSize);
         }
         /**
          * Resizes a dynamic matrix.
          * If M or N are dynamic, this function becomes available. If both M and N are dynamic, it resizes the matrix to newMxnewN.
          * Otherwise it resizes the matrix to newMxN or MxnewN depending if M or N is dynamic. If neither M nor N are dynamic, this
-         * function throws an exception.
+         * function throws an exception. A resized matrix is not padded, see SetLeadingDimension(). If only the number of rows
+         * (columns if column major) of an unpadded matrix changes and the new ones fit in Capacity(), the entries are not moved.
          * @param newM New number of rows. Ignored if M is not dynamic
          * @param newN New number of columns. Ignored if N is not dynamic
          */
@@ -421,51 +375,54 @@ namespace Linear {
             if (M != Dynamic && N != Dynamic)
                 throw "Cannot resize statically sized matrices.";
 
-            size_t oldM = this->m, oldN = this->n;
-            if (M == Dynamic) { this->m = newM; }
-            else { this->m = M; }
-            if (N == Dynamic) { this->n = newN; }
-            else { this->n = N; }
-
-            if (this->m == oldM && this->n == oldN)
+            size_t oldM = NumRows(), oldN = NumColumns();
+            size_t m = (M == Dynamic ? newM : M);
+            size_t n = (N == Dynamic ? newN : N);
+            if (m == oldM && n == oldN)
                 return;
-            if (this->m == 0 || this->n == 0) {
-                if (this->data != NULL)
-                    delete this->data;
-                this->data = NULL;
+
+            size_t lines = ((Flags & ColumnMajor) ? n : m);
+            if (IsContiguous() && ((Flags & ColumnMajor) ? m == oldM : n == oldN) && lines*LeadingDimension() <= Capacity()) {
+                size_t oldLines = NumLines();
+                Scalar * data = WritableData();
+                this->storage.SetLayout(m, n, LeadingDimension());
+                for (size_t i = oldLines*LeadingDimension(); i < lines*LeadingDimension(); ++i)
+                    data[i] = T(0);
                 return;
             }
 
-            Complex<T> * oldData = this->data;
-            this->data = new Complex<T>[this->m*this->n];
-            for (size_t r = 0; r < this->m; ++r) {
-                for (size_t c = 0; c < this->n; ++c) {
+            Storage resized(this->storage.Resource());
+            resized.Allocate(m, n);
+            const Scalar * oldData = static_cast<const Storage&>(this->storage).Data();
+            Scalar * data = resized.WritableData();
+            size_t oldLd = LeadingDimension(), ld = resized.LeadingDimension();
+            for (size_t r = 0; r < m && data != NULL; ++r) {
+                for (size_t c = 0; c < n; ++c) {
                     if (r >= oldM || c >= oldN) {
                         if (Flags & ColumnMajor)
-                            this->data[c*this->m+r] = T(0);
+                            data[c*ld+r] = T(0);
                         else
-                            this->data[r*this->n+c] = T(0);
+                            data[r*ld+c] = T(0);
                     }
                     else if (oldData != NULL) {
                         if (Flags & ColumnMajor)
-                            this->data[c*this->m+r] = oldData[c*oldM+r];
+                            data[c*ld+r] = oldData[c*oldLd+r];
                         else
-                            this->data[r*this->n+c] = oldData[r*oldN+c];
+                            data[r*ld+c] = oldData[r*oldLd+c];
                     }
                 }
             }
-            if (oldData != NULL)
-                delete oldData;
+            // The old entries are released when resized goes out of scope.
+            this->storage.Swap(resized);
         }
-
         /**
          * @return Number of rows
          */
-        size_t NumRows() const { return this->m; }
+        size_t NumRows() const { return this->storage.NumRows(); }
         /**
          * @return Number of columns
          */
-        size_t NumColumns() const { return this->n; }
+        size_t NumColumns() const { return this->storage.NumColumns(); }
         /**
          * @return Number of entries (Identical to NumRows()*NumColumns())
          */
@@ -491,12 +448,244 @@ namespace Linear {
             return NumColumns();
         }
         /**
-         * @return Pointer to matrix data.
+         * @return Pointer to matrix data. See LeadingDimension() for where each entry is stored. With CopyOnWrite, the
+         * non-const version first gives the matrix its own copy of shared entries, and later copies of the matrix copy its
+         * entries instead of sharing them, so that writes through the pointer never reach them. The same holds for every
+         * non-const accessor that hands out a reference to an entry: operator(), operator[], At(), begin(), end(),
+         * RowSpan(), ColumnSpan(), Block(), Row() and Column().
+         */
+        Scalar * Data() {
+            return this->storage.Data();
+        }
+        const Scalar * Data() const {
+            return this->storage.Data();
+        }
+        /**
+         * @return Memory resource the entries are allocated from, or NULL if they are stored inline (statically sized
+         * matrices). See MemoryResource.
+         */
+        MemoryResource * Resource() const {
+            return this->storage.Resource();
+        }
+        /**
+         * A matrix is already evaluated, see MatrixExpression::Eval().
+         * @return The matrix itself.
          */
-        Complex<T> * Data() {
-            return this->data;
+        const Matrix<T,M,N,Flags>& Eval() const {
+            return *this;
         }
 
+        /**
+         * @return Distance in memory (in entries) between consecutive rows.
+         */
+        size_t RowStride() const {
+            return ((Flags & ColumnMajor) ? 1 : LeadingDimension());
+        }
+        /**
+         * @return Distance in memory (in entries) between consecutive columns.
+         */
+        size_t ColumnStride() const {
+            return ((Flags & ColumnMajor) ? LeadingDimension() : 1);
+        }
+        /**
+         * Entry (r,c) is stored at Data()[r*LeadingDimension()+c], or Data()[c*LeadingDimension()+r] if the matrix is column
+         * major. Unless SetLeadingDimension() was called, this is NumColumns() (NumRows() if column major).
+         * @return Distance in memory (in entries) between consecutive rows (columns if column major).
+         */
+        size_t LeadingDimension() const {
+            return this->storage.LeadingDimension();
+        }
+        /**
+         * @return Whether the entries are stored without padding, i.e., Data() holds exactly NumEntries() entries.
+         */
+        bool IsContiguous() const {
+            return LeadingDimension() == LineLength();
+        }
+        /**
+         * Moves the entries of a dynamic matrix into an array whose rows (columns if column major) start ld entries apart.
+         * The entries in between are padding, which Linear never reads. Padding each line to a whole number of cache lines,
+         * and away from a power-of-two number of bytes, keeps walks down a column from evicting themselves; Pad() picks such
+         * an ld. The leading dimension is kept as long as the size of the matrix does not change. If ld is less than
+         * the length of a line or the matrix is statically sized, an exception is thrown.
+         * @param ld Leading dimension
+         */
+        void SetLeadingDimension(size_t ld) {
+            if (M != Dynamic && N != Dynamic)
+                throw "Cannot pad statically sized matrices.";
+            if (ld < LineLength())
+                throw "Cannot pad matrix. Leading dimension is shorter than a row or column.";
+            if (ld == LeadingDimension())
+                return;
+            Reallocate(ld, 0);
+        }
+        /**
+         * Pads a dynamic matrix with SetLeadingDimension(PaddedLeadingDimension<Scalar>(n)), where n is the number of columns
+         * (rows if column major).
+         */
+        void Pad() {
+            SetLeadingDimension(PaddedLeadingDimension<Scalar>(LineLength()));
+        }
+        /**
+         * Transposes the matrix without a second matrix. Square matrices swap their entries across the diagonal, a tile at
+         * a time. Other matrices (which must have both M and N Dynamic) become NxM by following the cycles of the
+         * permutation, which drops any padding. If the matrix is not square and M or N is not dynamic, an exception is thrown.
+         */
+        void TransposeInPlace() {
+            size_t m = NumRows(), n = NumColumns();
+            if (m == n) {
+                if (NumEntries() != 0)
+                    TransposeSquareEntries(WritableData(), m, LeadingDimension());
+                return;
+            }
+            if (M != Dynamic || N != Dynamic)
+                throw "Cannot transpose a non-square matrix in place unless its number of rows and columns are dynamic.";
+            Scalar * data = WritableData();
+            if (data != NULL)
+                TransposeEntriesInPlace(data, NumLines(), LineLength(), LeadingDimension());
+            this->storage.SetLayout(n, m, NumLines());
+        }
+        /**
+         * @return Number of entries (padding included) the matrix has room for before it has to move its entries.
+         */
+        size_t Capacity() const {
+            return this->storage.Capacity();
+        }
+        /**
+         * Makes room for a rows-by-cols dynamic matrix, so that AppendRow(), AppendColumn() and Resize() up to that size
+         * do not move the entries again. The size of the matrix does not change. If neither M nor N are dynamic, an
+         * exception is thrown.
+         * @param rows Number of rows to make room for. Ignored if M is not dynamic
+         * @param cols Number of columns to make room for. Ignored if N is not dynamic
+         */
+        void Reserve(size_t rows, size_t cols) {
+            if (M != Dynamic && N != Dynamic)
+                throw "Cannot reserve space for statically sized matrices.";
+            size_t m = (M == Dynamic ? rows : M);
+            size_t n = (N == Dynamic ? cols : N);
+            size_t lines = ((Flags & ColumnMajor) ? n : m);
+            size_t ld = std::max(LeadingDimension(), (Flags & ColumnMajor) ? m : n);
+            if (ld != LeadingDimension() || lines*ld > Capacity())
+                Reallocate(ld, std::max(lines, NumLines()));
+        }
+        /**
+         * Adds a row to the bottom of a matrix with a dynamic number of rows. The room for further rows grows geometrically,
+         * so building a matrix with n calls moves its entries O(log n) times. A matrix without rows takes the length of the
+         * row if N is dynamic. If M is not dynamic or the row has a different number of columns, an exception is thrown.
+         * @param row Row vector (or expression) to append
+         */
+        template <typename E>
+        void AppendRow(const MatrixExpression<E>& row) {
+            if (M != Dynamic)
+                throw "Cannot append a row to a matrix with a static number of rows.";
+            if (row.NumRows() != 1 || (row.NumColumns() != NumColumns() && (N != Dynamic || NumRows() != 0)))
+                throw "Cannot append a row of a different length.";
+            if (row.Derived().ConflictsWith(*this, false)) {
+                // The row reads this matrix, which may be about to move.
+                AppendRow(Matrix<T,1,Dynamic,(Flags & RealStorage)>(row));
+                return;
+            }
+            size_t m = NumRows();
+            Grow(m+1, row.NumColumns());
+            Scalar * data = WritableData();
+            for (size_t c = 0; c < NumColumns(); ++c)
+                data[Offset(m,c)] = ToScalar(row.Derived().At(0,c));
+        }
+        /**
+         * Adds a column to the right of a matrix with a dynamic number of columns, see AppendRow().
+         * @param col Column vector (or expression) to append
+         */
+        template <typename E>
+        void AppendColumn(const MatrixExpression<E>& col) {
+            if (N != Dynamic)
+                throw "Cannot append a column to a matrix with a static number of columns.";
+            if (col.NumColumns() != 1 || (col.NumRows() != NumRows() && (M != Dynamic || NumColumns() != 0)))
+                throw "Cannot append a column of a different length.";
+            if (col.Derived().ConflictsWith(*this, false)) {
+                AppendColumn(Matrix<T,Dynamic,1,(Flags & RealStorage)>(col));
+                return;
+            }
+            size_t n = NumColumns();
+            Grow(col.NumRows(), n+1);
+            Scalar * data = WritableData();
+            for (size_t r = 0; r < NumRows(); ++r)
+                data[Offset(r,n)] = ToScalar(col.Derived().At(r,0));
+        }
+        /**
+         * Releases the room kept by Reserve(), AppendRow(), AppendColumn() and Resize(), as well as any padding, so that a
+         * dynamic matrix holds exactly NumEntries() entries. Statically sized matrices are left as they are.
+         */
+        void ShrinkToFit() {
+            if (M != Dynamic && N != Dynamic)
+                return;
+            if (IsContiguous() && Capacity() <= std::max(NumEntries(), size_t(LINEAR_INLINE_ENTRIES)))
+                return;
+            Reallocate(LineLength(), 0);
+        }
+
+        /// \cond DO_NOT_DOCUMENT
+        /**
+         * Returns Data() for a write that does not keep the pointer, as done by the library. With CopyOnWrite, shared entries
+         * are still copied first, but later copies of the matrix may share its entries again.
+         */
+        Scalar * WritableData() {
+            return this->storage.WritableData();
+        }
+        /**
+         * Checks whether writing an expression containing this matrix into dest could overwrite entries before they are read,
+         * see StorageConflicts().
+         */
+        template <typename D>
+        bool ConflictsWith(const D& dest, bool inPlace) const {
+            return StorageConflicts(*this, dest, inPlace);
+        }
+        /// \endcond
+
+        /**
+         * Creates a view of part of the matrix: nrows rows starting at row i, taking every rowStep-th row, and ncols columns
+         * starting at column j, taking every colStep-th column. Nothing is copied; writing to the view writes to the matrix.
+         * If the window does not fit in the matrix an exception is thrown.
+         *
+         * Example: A becomes {{1,2,3},{4,2,4},{7,8,10}}
+         *
+         *     Matrix3d A = { {1,2,3}, {4,5,6}, {7,8,9} };
+         *     A.Block(1, 1, 2, 2) = 2.0*A.Block(0, 0, 2, 2);
+         *
+         * @param i Row offset
+         * @param j Column offset
+         * @param nrows Number of rows
+         * @param ncols Number of columns
+         * @param rowStep Step between rows (default = 1)
+         * @param colStep Step between columns (default = 1)
+         * @return nrowsxncols view
+         */
+        MatrixView<T,Flags> Block(size_t i, size_t j, size_t nrows, size_t ncols, size_t rowStep = 1, size_t colStep = 1) {
+            return MatrixView<T,Flags>(Data(), NumRows(), NumColumns(), RowStride(), ColumnStride()).Block(i, j, nrows, ncols, rowStep, colStep);
+        }
+        ConstMatrixView<T,Flags> Block(size_t i, size_t j, size_t nrows, size_t ncols, size_t rowStep = 1, size_t colStep = 1) const {
+            return ConstMatrixView<T,Flags>(Data(), NumRows(), NumColumns(), RowStride(), ColumnStride()).Block(i, j, nrows, ncols, rowStep, colStep);
+        }
+        /**
+         * Creates a view of row r. Unlike GetRow(), nothing is copied. If \f$r\ge M\f$, an exception is thrown.
+         * @param r Row index
+         * @return 1xN view
+         */
+        MatrixView<T,Flags> Row(size_t r) {
+            return Block(r, 0, 1, NumColumns());
+        }
+        ConstMatrixView<T,Flags> Row(size_t r) const {
+            return Block(r, 0, 1, NumColumns());
+        }
+        /**
+         * Creates a view of column c. Unlike GetColumn(), nothing is copied. If \f$c\ge N\f$, an exception is thrown.
+         * @param c Column index
+         * @return Mx1 view
+         */
+        MatrixView<T,Flags> Column(size_t c) {
+            return Block(0, c, NumRows(), 1);
+        }
+        ConstMatrixView<T,Flags> Column(size_t c) const {
+            return Block(0, c, NumRows(), 1);
+        }
         /**
          * Takes row r of the matrix and returns it. If \f$r\ge M\f$, an exception is thrown.
          * @param r Row index
@@ -536,8 +725,9 @@ namespace Linear {
                 throw "Expected a row vector in Matrix::SetRow()";
             if (row.NumColumns() != NumColumns())
                 throw "Cannot set row in matrix. Size mismatch.";
+            Scalar * data = WritableData();
             for (size_t c = 0; c < NumColumns(); ++c)
-                (*this)(r,c) = row(0,c);
+                data[Offset(r,c)] = ToScalar(row(0,c));
         }
         /**
          * Sets column c of the matrix to row. If \f$c\ge N\f$, an exception is thrown. If \f$P\ne M\f$ or \f$Q\ne 1\f$, an exception is thrown.
@@ -552,8 +742,16 @@ namespace Linear {
                 throw "Expected a column vector in Matrix::SetColumn()";
             if (column.NumRows() != NumRows())
                 throw "Cannot set column in matrix. Size mismatch.";
+            Scalar * data = WritableData();
             for (size_t r = 0; r < NumRows(); ++r)
-                (*this)(r,c) = column(r,0);
+                data[Offset(r,c)] = ToScalar(column(r,0));
+        }
+        /**
+         * Exchanges the contents of the matrix with other. Dynamically sized matrices just exchange their storage.
+         * @param other MxN Matrix
+         */
+        void Swap(Matrix<T,M,N,Flags>& other) noexcept {
+            this->storage.Swap(other.storage);
         }
         /**
          * Swaps rows r1 and r2. If \f$r1\ge M\f$ or \f$r2\ge M\f$ an exception is thrown.
@@ -563,11 +761,9 @@ namespace Linear {
         void SwapRows(size_t r1, size_t r2) {
             if (r1 >= NumRows() || r2 >= NumRows())
                 throw "Cannot swap rows. Index out of bounds.";
-            for (size_t c = 0; c < NumColumns(); ++c) {
-                Complex<T> temp = (*this)(r1,c);
-                (*this)(r1,c) = (*this)(r2,c);
-                (*this)(r2,c) = temp;
-            }
+            Scalar * data = WritableData();
+            for (size_t c = 0; c < NumColumns(); ++c)
+                std::swap(data[Offset(r1,c)], data[Offset(r2,c)]);
         }
         /**
          * Scales row r by s, i.e., \f$a_{ri}=sa_{ri}\f$ for \f$0\le i<N\f$. If \f$r\ge M\f$ an exception is thrown.
@@ -577,8 +773,10 @@ namespace Linear {
         void ScaleRow(size_t r, Complex<T> s) {
             if (r >= NumRows())
                 throw "Cannot scale row. Index out of bounds.";
+            Scalar scale = ToScalar(s);
+            Scalar * data = WritableData();
             for (size_t c = 0; c < NumColumns(); ++c)
-                (*this)(r,c) *= s;
+                data[Offset(r,c)] *= scale;
         }
         /**
          * Scales row r2 by s then adds it to r1, i.e., \f$a_{r1,i}=a_{r1,i}+sa_{r2,i}\f$ for \f$0\le i<N\f$. If \f$r1\ge M\f$ or \f$r2\ge M\f$ an exception is thrown.
@@ -589,26 +787,28 @@ namespace Linear {
         void AddRows(size_t r1, size_t r2, Complex<T> s) {
             if (r1 >= NumRows() || r2 >= NumRows())
                 throw "Cannot add rows. Index out of bounds.";
+            Scalar scale = ToScalar(s);
+            Scalar * data = WritableData();
             for (size_t c = 0; c < NumColumns(); ++c)
-                (*this)(r1,c) += s*(*this)(r2,c);
+                data[Offset(r1,c)] += scale*data[Offset(r2,c)];
         }
 
         /// Operators.
         // Access operators
         /**
-         * Returns the ith entry of the data. This accesses the data directly, the result will depend on if the matrix is row major or column major.
+         * Returns the ith entry of the data, counting in storage order. The result will depend on if the matrix is row major or column major.
          * @param i Index
          * @return Complex number
          */
-        Complex<T> operator[] (size_t i) const {
-            if (i >= NumEntries())
+        Scalar operator[] (size_t i) const {
+            if (LINEAR_BOUNDS_CHECK && i >= NumEntries())
                 throw "Cannot access matrix. Index out of bounds.";
-            return this->data[i];
+            return At(i);
         }
-        Complex<T> & operator[] (size_t i) {
-            if (i >= NumEntries())
+        Scalar & operator[] (size_t i) {
+            if (LINEAR_BOUNDS_CHECK && i >= NumEntries())
                 throw "Cannot access matrix. Index out of bounds.";
-            return this->data[i];
+            return At(i);
         }
         /**
          * Returns the the data located in row r and column c. If the matrix is column major, r still represents the row and c
@@ -617,19 +817,91 @@ namespace Linear {
          * @param c Column index
          * @return Complex number
          */
-        Complex<T> operator() (size_t r, size_t c) const {
-            if (r >= NumRows() || c >= NumColumns())
+        Scalar operator() (size_t r, size_t c) const {
+            if (LINEAR_BOUNDS_CHECK && (r >= NumRows() || c >= NumColumns()))
                 throw "Cannot access matrix. Row and column out of range.";
-            if (Flags & ColumnMajor)
-                return this->data[c*this->m+r];
-            return this->data[r*this->n+c];
+            return At(r, c);
         }
-        Complex<T> & operator() (size_t r, size_t c) {
-            if (r >= NumRows() || c >= NumColumns())
+        Scalar & operator() (size_t r, size_t c) {
+            if (LINEAR_BOUNDS_CHECK && (r >= NumRows() || c >= NumColumns()))
                 throw "Cannot access matrix. Row and column out of range.";
+            return At(r, c);
+        }
+        /**
+         * Same as operator()(r,c), but the indices are never checked. For inner loops whose bounds are already known.
+         * @param r Row index
+         * @param c Column index
+         * @return Complex number
+         */
+        const Scalar & At(size_t r, size_t c) const {
+            if (Flags & ColumnMajor)
+                return Data()[c*LeadingDimension()+r];
+            return Data()[r*LeadingDimension()+c];
+        }
+        Scalar & At(size_t r, size_t c) {
             if (Flags & ColumnMajor)
-                return this->data[c*this->m+r];
-            return this->data[r*this->n+c];
+                return Data()[c*LeadingDimension()+r];
+            return Data()[r*LeadingDimension()+c];
+        }
+        /**
+         * Same as operator[](i), but the index is never checked.
+         * @param i Index
+         * @return Complex number
+         */
+        const Scalar & At(size_t i) const {
+            return Data()[Offset(i)];
+        }
+        Scalar & At(size_t i) {
+            return Data()[Offset(i)];
+        }
+
+        // Iterators
+        /**
+         * Iterates over every entry in storage order (row by row, or column by column if the matrix is column major):
+         *
+         *     for (auto& a : A)
+         *         a = Sin(a);
+         *
+         * @return Iterator to the first entry
+         */
+        EntryIterator<Scalar> begin() { return Begin<Scalar>(Data()); }
+        EntryIterator<const Scalar> begin() const { return Begin<const Scalar>(Data()); }
+        /**
+         * @return Iterator past the last entry
+         */
+        EntryIterator<Scalar> end() { return End<Scalar>(Data()); }
+        EntryIterator<const Scalar> end() const { return End<const Scalar>(Data()); }
+        /**
+         * Returns row r as an unchecked span. The span is contiguous (Stride() == 1) when the matrix is row major. If r is
+         * out of range an exception is thrown.
+         * @param r Row index
+         * @return Span of NumColumns() entries
+         */
+        StridedSpan<Scalar> RowSpan(size_t r) {
+            if (r >= NumRows())
+                throw "Cannot access matrix. Row and column out of range.";
+            return StridedSpan<Scalar>(Data() + r*RowStride(), NumColumns(), ColumnStride());
+        }
+        StridedSpan<const Scalar> RowSpan(size_t r) const {
+            if (r >= NumRows())
+                throw "Cannot access matrix. Row and column out of range.";
+            return StridedSpan<const Scalar>(Data() + r*RowStride(), NumColumns(), ColumnStride());
+        }
+        /**
+         * Returns column c as an unchecked span. The span is contiguous (Stride() == 1) when the matrix is column major.
+         * If c is out of range an exception is thrown.
+         * @param c Column index
+         * @return Span of NumRows() entries
+         */
+        StridedSpan<Scalar> ColumnSpan(size_t c) {
+            if (c >= NumColumns())
+                throw "Cannot access matrix. Row and column out of range.";
+            return StridedSpan<Scalar>(Data() + c*ColumnStride(), NumRows(), RowStride());
+        }
+        StridedSpan<const Scalar> ColumnSpan(size_t c) const {
+            if (c >= NumColumns())
+                throw "Cannot access matrix. Row and column out of range.";
+            return StridedSpan<const Scalar>(Data() + c*ColumnStride(), NumRows(), RowStride());
         }
         // Type conversion.
         template<typename U, typename std::enable_if<std::is_convertible<T,U>::value>::type* = nullptr>
@@ -637,6 +909,33 @@ namespace Linear {
             return Matrix<U,M,N,Flags>(*this);
         }
         // Assignments
+        /**
+         * Set the matrix to other. The matrix keeps its memory resource, and its entries if the size does not change.
+         * @param other MxN Matrix
+         * @return MxN Matrix
+         */
+        Matrix<T,M,N,Flags> & operator=(const Matrix<T,M,N,Flags>& other) {
+            this->storage = other.storage;
+            return *this;
+        }
+        /**
+         * Set the matrix to other. If both use the same memory resource the entries are taken over, otherwise they are copied.
+         * @param other MxN Matrix
+         * @return MxN Matrix
+         */
+        Matrix<T,M,N,Flags> & operator=(Matrix<T,M,N,Flags>&& other) {
+            this->storage = std::move(other.storage);
+            return *this;
+        }
+        /**
+         * Set the matrix to other, which is stored in the other order. Its entries are rearranged in place and then taken
+         * over as with a matrix stored in the same order.
+         * @param other MxN Matrix stored in the other order
+         * @return MxN Matrix
+         */
+        Matrix<T,M,N,Flags> & operator=(Matrix<T,M,N,(Flags ^ ColumnMajor)>&& other) {
+            return *this = Matrix<T,M,N,Flags>(std::move(other));
+        }
         /**
          * Set the matrix to other. If M or N are Dynamic, they are set to P and Q respectively. Otherwise, if
          * \f$M\ne P\f$ or \f$N\ne Q\f$ an exception is raised.
@@ -648,33 +947,58 @@ namespace Linear {
             if (M == Dynamic || N == Dynamic) { Resize(other.NumRows(), other.NumColumns()); }
             if (NumRows() != other.NumRows() || NumColumns() != other.NumColumns())
                 throw "Cannot assign matrix to a matrix of different size.";
-            for (size_t r = 0; r < NumRows(); ++r) {
-                for (size_t c = 0; c < NumColumns(); ++c) {
-                    (*this)(r,c) = other(r,c);
-                }
+            Scalar * data = WritableData();
+            ForEachIndex<(Flags & ColumnMajor) != 0, ((Flags ^ Flags2) & ColumnMajor) != 0>(NumRows(), NumColumns(), [&](size_t r, size_t c) {
+                data[Offset(r,c)] = ToScalar(other.At(r,c));
+            });
+            return *this;
+        }
+        /**
+         * Set the matrix to the expression e (e.g. A+2*B) in a single pass, without temporaries. If M or N are Dynamic, they
+         * are set to the size of e. Otherwise, if the sizes differ an exception is raised. When e reads this matrix in a way
+         * that a single pass would corrupt (e.g. when the matrix has to be resized), e is evaluated into a temporary first.
+         * @param e Matrix expression
+         * @return MxN Matrix
+         */
+        template <typename E>
+        Matrix<T,M,N,Flags> & operator=(const MatrixExpression<E>& e) {
+            bool resize = (NumRows() != e.NumRows() || NumColumns() != e.NumColumns());
+            if (e.Derived().ConflictsWith(*this, !resize)) {
+                Matrix<T,M,N,Flags> result(e);
+                return *this = std::move(result);
+            }
+            if (resize) {
+                if (M != Dynamic && N != Dynamic)
+                    throw "Cannot assign matrix to a matrix of different size.";
+                this->storage.Allocate((M == Dynamic ? e.NumRows() : M), (N == Dynamic ? e.NumColumns() : N));
+                if (NumRows() != e.NumRows() || NumColumns() != e.NumColumns())
+                    throw "Cannot assign matrix to a matrix of different size.";
             }
+            Assign(e.Derived());
             return *this;
         }
-        template <size_t P, size_t Q, unsigned int Flags2>
-        Matrix<T,M,N,Flags> & operator+=(const Matrix<T,P,Q,Flags2>& other) {
-            if (NumRows() != other.NumRows() || NumColumns() != other.NumColumns())
+        template <typename E>
+        Matrix<T,M,N,Flags> & operator+=(const MatrixExpression<E>& e) {
+            if (NumRows() != e.NumRows() || NumColumns() != e.NumColumns())
                 throw "Cannot add two matrices of differing sizes.";
-            for (size_t r = 0; r < NumRows(); ++r) {
-                for (size_t c = 0; c < NumColumns(); ++c) {
-                    (*this)(r,c) += other(r,c);
-                }
-            }
+            if (e.Derived().ConflictsWith(*this, true))
+                return *this += e.Eval();
+            Scalar * data = WritableData();
+            ForEachIndex<(Flags & ColumnMajor) != 0, !SameLayout<Flags,E>::value>(NumRows(), NumColumns(), [&](size_t r, size_t c) {
+                data[Offset(r,c)] += ToScalar(e.Derived().At(r,c));
+            });
             return *this;
         }
-        template <size_t P, size_t Q, unsigned int Flags2>
-        Matrix<T,M,N,Flags> & operator-=(const Matrix<T,P,Q,Flags2>& other) {
-            if (NumRows() != other.NumRows() || NumColumns() != other.NumColumns())
+        template <typename E>
+        Matrix<T,M,N,Flags> & operator-=(const MatrixExpression<E>& e) {
+            if (NumRows() != e.NumRows() || NumColumns() != e.NumColumns())
                 throw "Cannot subtract two matrices of differing sizes.";
-            for (size_t r = 0; r < NumRows(); ++r) {
-                for (size_t c = 0; c < NumColumns(); ++c) {
-                    (*this)(r,c) -= other(r,c);
-                }
-            }
+            if (e.Derived().ConflictsWith(*this, true))
+                return *this -= e.Eval();
+            Scalar * data = WritableData();
+            ForEachIndex<(Flags & ColumnMajor) != 0, !SameLayout<Flags,E>::value>(NumRows(), NumColumns(), [&](size_t r, size_t c) {
+                data[Offset(r,c)] -= ToScalar(e.Derived().At(r,c));
+            });
             return *this;
         }
         template <size_t P, size_t Q, unsigned int Flags2>
@@ -684,93 +1008,33 @@ namespace Linear {
             *this = (*this) * other;
             return *this;
         }
-        Matrix<T,M,N,Flags> & operator*=(Complex<T> other) {
-            for (size_t r = 0; r < NumRows(); ++r) {
-                for (size_t c = 0; c < NumColumns(); ++c) {
-                    (*this)(r,c) *= other;
-                }
-            }
+        Matrix<T,M,N,Flags> & operator*=(T other) {
+            Scalar * data = WritableData();
+            for (auto it = Begin(data); it != End(data); ++it)
+                *it *= other;
             return *this;
         }
-        Matrix<T,M,N,Flags> & operator/=(Complex<T> other) {
-            for (size_t r = 0; r < NumRows(); ++r) {
-                for (size_t c = 0; c < NumColumns(); ++c) {
-                    (*this)(r,c) /= other;
-                }
-            }
+        Matrix<T,M,N,Flags> & operator/=(T other) {
+            Scalar * data = WritableData();
+            for (auto it = Begin(data); it != End(data); ++it)
+                *it /= other;
             return *this;
         }
-        // Binary operators.
-        /**
-         * Computes the MxN matrix \f$C=A+B\f$ defined by \f$c_{ij}=a_{ij}+b_{ij}\f$.
-         * If \f$M\ne P\f$ or \f$N\ne Q\f$ an exception is raised.
-         * @param A MxN Matrix
-         * @param B PxQ Matrix
-         * @return MxN Matrix
-         */
-        template <size_t P, size_t Q, unsigned int Flags2>
-        friend Matrix<T,M,N,Flags> operator+(Matrix<T,M,N,Flags> A, const Matrix<T,P,Q,Flags2>& B) { return A += B; }
-        /**
-         * Computes the MxN matrix \f$C=A-B\f$ defined by \f$c_{ij}=a_{ij}-b_{ij}\f$.
-         * If \f$M\ne P\f$ or \f$N\ne Q\f$ an exception is raised.
-         * @param A MxN Matrix
-         * @param B PxQ Matrix
-         * @return MxN Matrix
-         */
-        template <size_t P, size_t Q, unsigned int Flags2>
-        friend Matrix<T,M,N,Flags> operator-(Matrix<T,M,N,Flags> A, const Matrix<T,P,Q,Flags2>& B) { return A -= B; }
-        /**
-         * Computes the MxN matrix \f$B=sA\f$ defined by \f$b_{ij}=sa_{ij}\f$.
-         * @param A MxN Matrix
-         * @param s Complex number
-         * @return MxN Matrix
-         */
-        friend Matrix<T,M,N,Flags> operator*(Matrix<T,M,N,Flags> A, const Complex<T>& s) { return A *= s; }
-        /**
-         * Computes the MxN matrix \f$B=sA\f$ defined by \f$b_{ij}=sa_{ij}\f$.
-         * @param s Complex number
-         * @param A MxN Matrix
-         * @return MxN Matrix
-         */
-        friend Matrix<T,M,N,Flags> operator*(const Complex<T>& s, Matrix<T,M,N,Flags> A) { return A *= s; }
-        /**
-         * Computes the MxN matrix \f$B=A/s\f$ defined by \f$b_{ij}=a_{ij}/s\f$.
-         * @param A MxN Matrix
-         * @param s Complex number
-         * @return MxN Matrix
-         */
-        friend Matrix<T,M,N,Flags> operator/(Matrix<T,M,N,Flags> A, const Complex<T>& s) { return A /= s; }
-        /**
-         * Computes the MxQ matrix \f$C=AB\f$ defined by \f$c_{ij}=\sum_{k=0}^{N-1}a_{ik}b_{kj}\f$.
-         * If \f$N\ne P\f$ an exception is raised.
-         * @param A MxN Matrix
-         * @param B PxQ Matrix
-         * @return MxQ Matrix
-         */
-        template <size_t P, size_t Q, unsigned int Flags2>
-        friend Matrix<T,M,Q,Flags> operator*(const Matrix<T,M,N,Flags>& A, const Matrix<T,P,Q,Flags2>& B) {
-            if (A.NumColumns() != B.NumRows())
-                throw "Cannot muliply two matrices due to size mismatch.";
-            Matrix<T,M,Q,Flags> ret(A.NumRows(), B.NumColumns(), T(0));
-            for (size_t r = 0; r < A.NumRows(); ++r) {
-                for (size_t c = 0; c < B.NumColumns(); ++c) {
-                    for (size_t i = 0; i < A.NumColumns(); ++i) {
-                        ret(r,c) += A(r,i)*B(i,c);
-                    }
-                }
-            }
-            return ret;
+        Matrix<T,M,N,Flags> & operator*=(Complex<T> other) {
+            Scalar s = ToScalar(other);
+            Scalar * data = WritableData();
+            for (auto it = Begin(data); it != End(data); ++it)
+                *it *= s;
+            return *this;
         }
-        // Unary operators.
-        Matrix<T,M,N,Flags> operator-() {
-            Matrix<T,M,N,Flags> ret(NumRows(),NumColumns(),T(0));
-            for (size_t r = 0; r < NumRows(); ++r) {
-                for (size_t c = 0; c < NumColumns(); ++c) {
-                    ret(r,c) = -(*this)(r,c);
-                }
-            }
-            return ret;
+        Matrix<T,M,N,Flags> & operator/=(Complex<T> other) {
+            Scalar s = ToScalar(other);
+            Scalar * data = WritableData();
+            for (auto it = Begin(data); it != End(data); ++it)
+                *it /= s;
+            return *this;
         }
+        // Binary operators. Element-wise operators and scaling are lazy, see MatrixExpression. The matrix product follows the class.
         // Output operator
         /**
          * Takes a matrix and writes to out in a formatted manner.
@@ -785,7 +1049,7 @@ namespace Linear {
             if (m.NumRows() == 1) {
                 out << "(1x"<<m.NumColumns()<<")[";
                 for (size_t i = 0; i < m.Length(); ++i)
-                    out << (i > 0 ? ", " : "") << m[i];
+                    out << (i > 0 ? ", " : "") << Complex<T>(m[i]);
                 out << "]";
                 return out;
             }
@@ -795,7 +1059,7 @@ namespace Linear {
             for (size_t r = 0; r < m.NumRows(); ++r) {
                 for (size_t c = 0; c < m.NumColumns(); ++c) {
                     std::stringstream stream;
-                    stream << m(r,c);
+                    stream << Complex<T>(m(r,c));
                     std::string asstring = stream.str();
                     if (asstring.length() > longest) {
                         longest = asstring.length();
@@ -811,7 +1075,7 @@ namespace Linear {
             for (size_t r = 0; r < m.NumRows(); ++r) {
                 for (size_t c = 0; c < m.NumColumns(); ++c) {
                     std::stringstream stream;
-                    stream << m(r,c);
+                    stream << Complex<T>(m(r,c));
                     std::string asstring = stream.str();
                     out << padding.substr(0,longest-asstring.length()) << asstring.c_str();
                 }
@@ -830,13 +1094,11 @@ namespace Linear {
         friend bool operator==(const Matrix<T,M,N,Flags>& a, const Matrix<T,P,Q,Flags2>& b) {
             if (a.NumRows() != b.NumRows() || a.NumColumns() != b.NumColumns())
                 return false;
-            for (size_t r = 0; r < a.NumRows(); ++r) {
-                for (size_t c = 0; c < a.NumColumns(); ++c) {
-                    if (a(r,c) != b(r,c))
-                        return false;
-                }
-            }
-            return true;
+            bool equal = true;
+            ForEachIndex<(Flags & ColumnMajor) != 0, ((Flags ^ Flags2) & ColumnMajor) != 0>(a.NumRows(), a.NumColumns(), [&](size_t r, size_t c) {
+                equal = equal && a.At(r,c) == b.At(r,c);
+            });
+            return equal;
         }
         /**
          * Compares two matrices entrywise.
@@ -847,10 +1109,426 @@ namespace Linear {
         template <size_t P, size_t Q, unsigned int Flags2>
         friend bool operator!=(const Matrix<T,M,N,Flags>& a, const Matrix<T,P,Q,Flags2>& b) { return !(a==b); }
     private:
-        Complex<T> * data;
-        size_t m, n;
+        template <typename U, size_t P, size_t Q, unsigned int Flags2> friend class Matrix;
+
+        typedef typename std::conditional<(Flags & CopyOnWrite) && (M == Dynamic || N == Dynamic),
+                                          SharedStorage<Scalar,M,N,(Flags & ColumnMajor) != 0>,
+                                          DenseStorage<Scalar,M,N,(Flags & ColumnMajor) != 0>>::type Storage;
+
+        /**
+         * @return Number of rows (columns if column major).
+         */
+        size_t NumLines() const {
+            return ((Flags & ColumnMajor) ? NumColumns() : NumRows());
+        }
+        /**
+         * @return Number of entries in each row (column if column major).
+         */
+        size_t LineLength() const {
+            return ((Flags & ColumnMajor) ? NumRows() : NumColumns());
+        }
+        /**
+         * @return Position in Data() of the ith entry in storage order.
+         */
+        size_t Offset(size_t i) const {
+            if (IsContiguous())
+                return i;
+            return i/LineLength()*LeadingDimension() + i%LineLength();
+        }
+        /**
+         * @return Position in Data() of entry (r,c).
+         */
+        size_t Offset(size_t r, size_t c) const {
+            return ((Flags & ColumnMajor) ? c*LeadingDimension()+r : r*LeadingDimension()+c);
+        }
+        /**
+         * Moves the entries into a fresh array whose lines start ld entries apart, with room for the given number of lines.
+         */
+        void Reallocate(size_t ld, size_t lines) {
+            Storage moved(this->storage.Resource());
+            moved.Allocate(NumRows(), NumColumns(), ld, lines);
+            const Scalar * data = static_cast<const Storage&>(this->storage).Data();
+            for (size_t l = 0; l < NumLines(); ++l)
+                std::copy(data+l*LeadingDimension(), data+l*LeadingDimension()+LineLength(), moved.WritableData()+l*ld);
+            this->storage.Swap(moved);
+        }
+        /**
+         * Changes the size to m-by-n without touching the existing entries, moving them first if they do not fit. Both the
+         * leading dimension and the number of lines there is room for at least double when they have to grow.
+         */
+        void Grow(size_t m, size_t n) {
+            size_t lines = ((Flags & ColumnMajor) ? n : m);
+            size_t inner = ((Flags & ColumnMajor) ? m : n);
+            size_t ld = LeadingDimension();
+            if (inner > ld)
+                ld = std::max(inner, 2*ld);
+            size_t room = (LeadingDimension() == 0 ? 0 : Capacity()/LeadingDimension());
+            if (lines > room)
+                room = std::max(lines, 2*NumLines());
+            if (ld != LeadingDimension() || room*ld > Capacity())
+                Reallocate(ld, room);
+            else
+                WritableData(); // Gives CopyOnWrite matrices their own entries before they change size.
+            this->storage.SetLayout(m, n, ld);
+        }
+        template <typename S>
+        EntryIterator<S> Begin(S * data) const {
+            if (IsContiguous() || NumEntries() == 0)
+                return EntryIterator<S>(data, NumEntries(), NumEntries());
+            return EntryIterator<S>(data, LineLength(), LeadingDimension());
+        }
+        template <typename S>
+        EntryIterator<S> End(S * data) const {
+            if (NumEntries() == 0)
+                return EntryIterator<S>(data, 0, 0);
+            return EntryIterator<S>(data + NumLines()*LeadingDimension(), 0, 0);
+        }
+        /**
+         * Writes every entry of the expression e into the matrix, which must already have the size of e. Entries are visited
+         * in storage order, tile by tile if e reads matrices stored in the other order.
+         */
+        template <typename E>
+        void Assign(const E& e) {
+            Scalar * data = WritableData();
+            size_t ld = LeadingDimension();
+            ForEachIndex<(Flags & ColumnMajor) != 0, !SameLayout<Flags,E>::value>(NumRows(), NumColumns(), [&](size_t r, size_t c) {
+                data[(Flags & ColumnMajor) ? c*ld+r : r*ld+c] = ToScalar(e.At(r,c));
+            });
+        }
+
+        Storage storage;
     };
 
+    /// \cond DO_NOT_DOCUMENT
+    /**
+     * Whether the entries of E can be addressed through Data(), RowStride() and ColumnStride() (matrices and views).
+     */
+    template <typename E, typename = void>
+    struct HasStrides : std::false_type {};
+
+    template <typename E>
+    struct HasStrides<E, decltype(void(std::declval<const E&>().Data()), void(std::declval<const E&>().RowStride()),
+                                  void(std::declval<const E&>().ColumnStride()))> : std::true_type {};
+
+    /**
+     * Adds A*B to C entry by entry.
+     */
+    template <typename Result, typename L, typename R>
+    void MultiplyAdd(Result& C, const L& A, const R& B, std::false_type) {
+        typename Result::Scalar * data = C.WritableData();
+        for (size_t r = 0; r < A.NumRows(); ++r) {
+            for (size_t c = 0; c < B.NumColumns(); ++c) {
+                typename Result::Scalar& entry = data[r*C.RowStride()+c*C.ColumnStride()];
+                typename Result::Scalar sum = entry;
+                for (size_t i = 0; i < A.NumColumns(); ++i) {
+                    sum += A.At(r,i)*B.At(i,c);
+                }
+                entry = sum;
+            }
+        }
+    }
+
+    /**
+     * Adds A*B to C with the packed product (see StridedMultiplyAdd) unless it is small.
+     */
+    template <typename Result, typename L, typename R>
+    void MultiplyAdd(Result& C, const L& A, const R& B, std::true_type) {
+        if (A.NumRows()*B.NumColumns()*A.NumColumns() < LINEAR_GEMM_THRESHOLD) {
+            MultiplyAdd(C, A, B, std::false_type());
+            return;
+        }
+        StridedMultiplyAdd(A.NumRows(), B.NumColumns(), A.NumColumns(),
+                           A.Data(), A.RowStride(), A.ColumnStride(),
+                           B.Data(), B.RowStride(), B.ColumnStride(),
+                           C.WritableData(), C.RowStride(), C.ColumnStride());
+    }
+
+    /**
+     * Computes A*B into a Result. A and B are read entry by entry, so they have to be matrices or views.
+     */
+    template <typename Result, typename L, typename R>
+    Result MultiplyMatrices(const L& A, const R& B) {
+        if (A.NumColumns() != B.NumRows())
+            throw "Cannot muliply two matrices due to size mismatch.";
+        Result ret(A.NumRows(), B.NumColumns(), typename ExpressionTraits<Result>::Real(0));
+        MultiplyAdd(ret, A, B, std::integral_constant<bool, HasStrides<L>::value && HasStrides<R>::value>());
+        return ret;
+    }
+    /**
+     * Computes A*B into a Result with a straight-line kernel when all three sizes are fixed and at most 4.
+     */
+    template <typename Result, typename T, size_t M, size_t K, unsigned int Flags, size_t P, size_t N, unsigned int Flags2>
+    typename std::enable_if<IsSmallSize<M,K>::value && IsSmallSize<P,N>::value && K == P, Result>::type
+    MultiplyMatrices(const Matrix<T,M,K,Flags>& A, const Matrix<T,P,N,Flags2>& B) {
+        Result ret;
+        SmallMultiply<M,K,N,(Flags & ColumnMajor) != 0,(Flags2 & ColumnMajor) != 0,(ExpressionTraits<Result>::Flags & ColumnMajor) != 0>(
+            A.Data(), B.Data(), ret.Data());
+        return ret;
+    }
+    /// \endcond
+
+    /**
+     * Computes the MxQ matrix \f$C=AB\f$ defined by \f$c_{ij}=\sum_{k=0}^{N-1}a_{ik}b_{kj}\f$.
+     * If \f$N\ne P\f$ an exception is raised.
+     * The result only uses real storage if both A and B do, in which case it is computed in real arithmetic.
+     * Matrices and views are read in place, other expressions (e.g. A+B) are evaluated first.
+     * @param A MxN Matrix expression
+     * @param B PxQ Matrix expression
+     * @return MxQ Matrix
+     */
+    template <typename L, typename R, typename = EnableIfSameReal<L,R>>
+    Matrix<typename ExpressionTraits<L>::Real,ExpressionTraits<L>::Rows,ExpressionTraits<R>::Columns,PromoteFlags(ExpressionTraits<L>::Flags,ExpressionTraits<R>::Flags)>
+    operator*(const MatrixExpression<L>& A, const MatrixExpression<R>& B) {
+        typedef Matrix<typename ExpressionTraits<L>::Real,ExpressionTraits<L>::Rows,ExpressionTraits<R>::Columns,PromoteFlags(ExpressionTraits<L>::Flags,ExpressionTraits<R>::Flags)> Result;
+        return MultiplyMatrices<Result>(Materialize(A.Derived()), Materialize(B.Derived()));
+    }
+
+    /**
+     * Operation Gemm() applies to an operand before multiplying.
+     */
+    enum MatrixOp {
+        OP_NONE,                /*!< The operand as it is */
+        OP_TRANSPOSE,           /*!< Transpose of the operand */
+        OP_CONJUGATE_TRANSPOSE  /*!< Conjugate transpose of the operand */
+    };
+
+    /// \cond DO_NOT_DOCUMENT
+    /**
+     * Computes C = alpha*op(A)*op(B) + beta*C for matrices or views A, B and C of the right sizes. Transposed operands are
+     * read through swapped strides and conjugated ones while they are packed, so neither is formed.
+     */
+    template <typename D, typename L, typename R>
+    void GemmInto(const typename D::Scalar& alpha, const L& A, MatrixOp opA, const R& B, MatrixOp opB,
+                  const typename D::Scalar& beta, D& C) {
+        typedef typename D::Scalar SC;
+        if (StorageConflicts(A, C, false)) {
+            GemmInto(alpha, ExpressionMatrix<L>(A), opA, B, opB, beta, C);
+            return;
+        }
+        if (StorageConflicts(B, C, false)) {
+            GemmInto(alpha, A, opA, ExpressionMatrix<R>(B), opB, beta, C);
+            return;
+        }
+        const size_t m = C.NumRows(), n = C.NumColumns(), k = (opA == OP_NONE ? A.NumColumns() : A.NumRows());
+        const size_t ars = (opA == OP_NONE ? A.RowStride() : A.ColumnStride()), acs = (opA == OP_NONE ? A.ColumnStride() : A.RowStride());
+        const size_t brs = (opB == OP_NONE ? B.RowStride() : B.ColumnStride()), bcs = (opB == OP_NONE ? B.ColumnStride() : B.RowStride());
+        SC * c = C.WritableData();
+        const size_t crs = C.RowStride(), ccs = C.ColumnStride();
+        if (beta != SC(1)) {
+            // Walk C in storage order. beta = 0 overwrites C, even if it holds NaN or infinity.
+            const bool byRow = (crs >= ccs);
+            for (size_t u = 0; u < (byRow ? m : n); ++u) {
+                for (size_t v = 0; v < (byRow ? n : m); ++v) {
+                    SC& entry = (byRow ? c[u*crs+v*ccs] : c[v*crs+u*ccs]);
+                    entry = (beta == SC(0) ? SC(0) : entry*beta);
+                }
+            }
+        }
+        if (alpha == SC(0) || m*n*k == 0)
+            return;
+
+        const bool conjA = (opA == OP_CONJUGATE_TRANSPOSE), conjB = (opB == OP_CONJUGATE_TRANSPOSE);
+        if (m*n*k < LINEAR_GEMM_THRESHOLD) {
+            for (size_t r = 0; r < m; ++r) {
+                for (size_t j = 0; j < n; ++j) {
+                    SC sum = SC(0);
+                    for (size_t i = 0; i < k; ++i) {
+                        const auto& x = A.Data()[r*ars+i*acs];
+                        const auto& y = B.Data()[i*brs+j*bcs];
+                        sum += (conjA ? GemmConjugate(x) : x)*(conjB ? GemmConjugate(y) : y);
+                    }
+                    c[r*crs+j*ccs] += (alpha == SC(1) ? sum : alpha*sum);
+                }
+            }
+            return;
+        }
+        typedef typename GemmBlocking<SC>::Real Real;
+        StridedMultiplyAdd(m, n, k, A.Data(), ars, acs, B.Data(), brs, bcs, c, crs, ccs,
+                           GemmScale<Real>(GemmRe(alpha), GemmIm(alpha), conjA), GemmScale<Real>(Real(1), Real(0), conjB));
+    }
+
+    /**
+     * Checks the sizes of a Gemm() call.
+     */
+    template <typename L, typename R>
+    void GemmSize(const L& A, MatrixOp opA, const R& B, MatrixOp opB, size_t& m, size_t& n) {
+        size_t k = (opA == OP_NONE ? A.NumColumns() : A.NumRows());
+        if (k != (opB == OP_NONE ? B.NumRows() : B.NumColumns()))
+            throw "Cannot muliply two matrices due to size mismatch.";
+        m = (opA == OP_NONE ? A.NumRows() : A.NumColumns());
+        n = (opB == OP_NONE ? B.NumColumns() : B.NumRows());
+    }
+    /// \endcond
+
+    /**
+     * Computes \f$C=\alpha\,op(A)\,op(B)+\beta C\f$ in place, where op is one of OP_NONE, OP_TRANSPOSE or
+     * OP_CONJUGATE_TRANSPOSE. Unlike A*B, no transposed operand and no result matrix is formed: C keeps its entries, so
+     * repeated products reuse the same memory. If beta is 0, C is overwritten without being read. If C is dynamic and
+     * beta is 0 it is resized to op(A)*op(B) if needed; otherwise sizes that do not match raise an exception. A or B
+     * may share entries with C, in which case they are copied first.
+     *
+     *     Gemm(1.0, Q, OP_TRANSPOSE, A, OP_NONE, 0.0, R); // R = Transpose(Q)*A
+     *     Gemm(-1.0, A, OP_NONE, B, OP_NONE, 1.0, C);     // C -= A*B
+     *
+     * @param alpha Factor for the product
+     * @param A Matrix expression
+     * @param opA Operation applied to A
+     * @param B Matrix expression
+     * @param opB Operation applied to B
+     * @param beta Factor for C
+     * @param C Matrix receiving the result. Needs complex storage unless both A and B use real storage.
+     */
+    template <typename L, typename R, typename T, size_t M, size_t N, unsigned int Flags, typename = EnableIfSameReal<L,Matrix<T,M,N,Flags>>,
+              typename = EnableIfSameReal<R,Matrix<T,M,N,Flags>>>
+    void Gemm(typename Matrix<T,M,N,Flags>::Scalar alpha, const MatrixExpression<L>& A, MatrixOp opA,
+              const MatrixExpression<R>& B, MatrixOp opB, typename Matrix<T,M,N,Flags>::Scalar beta, Matrix<T,M,N,Flags>& C) {
+        static_assert(!(Flags & RealStorage) || ((ExpressionTraits<L>::Flags & RealStorage) && (ExpressionTraits<R>::Flags & RealStorage)),
+                      "Cannot store a product of complex matrices in a real matrix.");
+        size_t m, n;
+        GemmSize(A.Derived(), opA, B.Derived(), opB, m, n);
+        if (C.NumRows() != m || C.NumColumns() != n) {
+            if ((M != Dynamic && N != Dynamic) || beta != typename Matrix<T,M,N,Flags>::Scalar(0))
+                throw "Cannot muliply two matrices due to size mismatch.";
+            C.Resize(m, n);
+            if (C.NumRows() != m || C.NumColumns() != n)
+                throw "Cannot muliply two matrices due to size mismatch.";
+        }
+        GemmInto(alpha, Materialize(A.Derived()), opA, Materialize(B.Derived()), opB, beta, C);
+    }
+    /**
+     * Computes \f$C=\alpha\,op(A)\,op(B)+\beta C\f$ into the writable view C, see Gemm() for matrices.
+     * @param alpha Factor for the product
+     * @param A Matrix expression
+     * @param opA Operation applied to A
+     * @param B Matrix expression
+     * @param opB Operation applied to B
+     * @param beta Factor for C
+     * @param C View receiving the result
+     */
+    template <typename L, typename R, typename T, unsigned int Flags, typename = EnableIfSameReal<L,MatrixView<T,Flags,false>>,
+              typename = EnableIfSameReal<R,MatrixView<T,Flags,false>>>
+    void Gemm(typename MatrixView<T,Flags,false>::Scalar alpha, const MatrixExpression<L>& A, MatrixOp opA,
+              const MatrixExpression<R>& B, MatrixOp opB, typename MatrixView<T,Flags,false>::Scalar beta, MatrixView<T,Flags,false> C) {
+        static_assert(!(Flags & RealStorage) || ((ExpressionTraits<L>::Flags & RealStorage) && (ExpressionTraits<R>::Flags & RealStorage)),
+                      "Cannot store a product of complex matrices in a real matrix.");
+        size_t m, n;
+        GemmSize(A.Derived(), opA, B.Derived(), opB, m, n);
+        if (C.NumRows() != m || C.NumColumns() != n)
+            throw "Cannot muliply two matrices due to size mismatch.";
+        GemmInto(alpha, Materialize(A.Derived()), opA, Materialize(B.Derived()), opB, beta, C);
+    }
+
+    /**
+     * Computes the matrix-vector product \f$y=\alpha\,op(A)\,x+\beta y\f$ in place, like the BLAS routine GEMV, with the
+     * same rules as Gemm() for op, beta and the size of y. Products with a single row or column, whether through Gemv(),
+     * Gemm() or A*x, read A once in its storage order with vector kernels; a transposed A is read through its strides, so
+     * \f$A^Tx\f$ costs the same as \f$Ax\f$.
+     *
+     *     Gemv(1.0, A, OP_NONE, x, 0.0, y);              // y = A*x
+     *     Gemv(1.0, A, OP_CONJUGATE_TRANSPOSE, x, 1.0, y); // y += ConjugateTranspose(A)*x
+     *
+     * @param alpha Factor for the product
+     * @param A Matrix expression
+     * @param opA Operation applied to A
+     * @param x Column vector expression
+     * @param beta Factor for y
+     * @param y Column vector receiving the result. Needs complex storage unless both A and x use real storage.
+     */
+    template <typename L, typename R, typename T, size_t M, unsigned int Flags, typename = EnableIfSameReal<L,Matrix<T,M,1,Flags>>,
+              typename = EnableIfSameReal<R,Matrix<T,M,1,Flags>>>
+    void Gemv(typename Matrix<T,M,1,Flags>::Scalar alpha, const MatrixExpression<L>& A, MatrixOp opA,
+              const MatrixExpression<R>& x, typename Matrix<T,M,1,Flags>::Scalar beta, Matrix<T,M,1,Flags>& y) {
+        if (x.Derived().NumColumns() != 1)
+            throw "Cannot muliply two matrices due to size mismatch.";
+        Gemm(alpha, A, opA, x, OP_NONE, beta, y);
+    }
+
+    /**
+     * Computes the Hermitian matrix \f$C=\alpha AA^*+\beta C\f$ (op = OP_NONE) or \f$C=\alpha A^*A+\beta C\f$
+     * (op = OP_CONJUGATE_TRANSPOSE) in place, like the BLAS routines SYRK and HERK. Only the lower triangle is computed,
+     * about half the work of the same product through Gemm(), and then mirrored into the upper one; likewise only the lower
+     * triangle of C is read when beta is not 0. OP_TRANSPOSE is accepted for real matrices, where it means the same as
+     * OP_CONJUGATE_TRANSPOSE. If C is dynamic and beta is 0 it is resized if needed; otherwise a size that does not match
+     * raises an exception.
+     *
+     *     Herk(1.0, A, OP_CONJUGATE_TRANSPOSE, 0.0, G); // G = ConjugateTranspose(A)*A
+     *
+     * @param alpha Real factor for the product
+     * @param A Matrix expression
+     * @param op Operation applied to the left factor
+     * @param beta Real factor for C
+     * @param C Square matrix receiving the result. Needs complex storage unless A uses real storage.
+     */
+    template <typename E, typename T, size_t M, size_t N, unsigned int Flags, typename = EnableIfSameReal<E,Matrix<T,M,N,Flags>>>
+    void Herk(typename ExpressionTraits<Matrix<T,M,N,Flags>>::Real alpha, const MatrixExpression<E>& A, MatrixOp op,
+              typename ExpressionTraits<Matrix<T,M,N,Flags>>::Real beta, Matrix<T,M,N,Flags>& C) {
+        static_assert(!(Flags & RealStorage) || (ExpressionTraits<E>::Flags & RealStorage),
+                      "Cannot store a product of complex matrices in a real matrix.");
+        typedef typename Matrix<T,M,N,Flags>::Scalar SC;
+        if (op == OP_TRANSPOSE) {
+            if (!(ExpressionTraits<E>::Flags & RealStorage))
+                throw "Herk needs OP_NONE or OP_CONJUGATE_TRANSPOSE for complex matrices.";
+            op = OP_CONJUGATE_TRANSPOSE;
+        }
+        const auto& a = Materialize(A.Derived());
+        if (StorageConflicts(a, C, false)) {
+            Herk(alpha, ExpressionMatrix<E>(A.Derived()), op, beta, C);
+            return;
+        }
+        // C is X*X^H with X = A or X = A^H, read through the strides of A.
+        const bool conjugate = (op != OP_NONE);
+        const size_t n = (conjugate ? a.NumColumns() : a.NumRows()), k = (conjugate ? a.NumRows() : a.NumColumns());
+        const size_t xrs = (conjugate ? a.ColumnStride() : a.RowStride()), xcs = (conjugate ? a.RowStride() : a.ColumnStride());
+        if (C.NumRows() != n || C.NumColumns() != n) {
+            if ((M != Dynamic && N != Dynamic) || beta != T(0))
+                throw "Cannot muliply two matrices due to size mismatch.";
+            C.Resize(n, n);
+            if (C.NumRows() != n || C.NumColumns() != n)
+                throw "Cannot muliply two matrices due to size mismatch.";
+        }
+
+        SC * c = C.WritableData();
+        const size_t crs = C.RowStride(), ccs = C.ColumnStride();
+        if (beta != T(1)) {
+            // Walk the lower triangle in storage order, by rows from the left or by columns from the diagonal.
+            const bool byRow = (crs >= ccs);
+            for (size_t u = 0; u < n; ++u) {
+                for (size_t v = (byRow ? 0 : u); v < (byRow ? u+1 : n); ++v) {
+                    SC& entry = (byRow ? c[u*crs+v*ccs] : c[v*crs+u*ccs]);
+                    entry = (beta == T(0) ? SC(0) : entry*beta);
+                }
+            }
+        }
+        if (alpha != T(0) && n*n*k < 2*LINEAR_GEMM_THRESHOLD) {
+            const auto * x = a.Data();
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j = 0; j <= i; ++j) {
+                    SC sum = SC(0);
+                    for (size_t p = 0; p < k; ++p) {
+                        SC xi = x[i*xrs+p*xcs], xj = x[j*xrs+p*xcs];
+                        sum += (conjugate ? GemmConjugate(xi) : xi)*(conjugate ? xj : GemmConjugate(xj));
+                    }
+                    c[i*crs+j*ccs] += (alpha == T(1) ? sum : alpha*sum);
+                }
+            }
+        }
+        else if (alpha != T(0))
+            HermitianMultiplyAdd(n, k, a.Data(), xrs, xcs, conjugate, alpha, c, crs, ccs);
+
+        // Mirror the lower triangle a tile at a time (see TransposeEntries()). The diagonal of a Hermitian matrix is real.
+        for (size_t i0 = 0; i0 < n; i0 += LINEAR_TILE) {
+            size_t iEnd = std::min(n, i0+LINEAR_TILE);
+            for (size_t j0 = 0; j0 <= i0; j0 += LINEAR_TILE) {
+                for (size_t i = i0; i < iEnd; ++i) {
+                    for (size_t j = j0; j < std::min(i, j0+LINEAR_TILE); ++j)
+                        c[j*crs+i*ccs] = GemmConjugate(c[i*crs+j*ccs]);
+                }
+            }
+            for (size_t i = i0; i < iEnd; ++i)
+                c[i*crs+i*ccs] = GemmRe(c[i*crs+i*ccs]);
+        }
+    }
+
     template <typename T,size_t N, unsigned int Flags = 0>
     using SquareMatrix = Matrix<T,N,N,Flags>;
 
@@ -895,4 +1573,22 @@ namespace Linear {
     using Matrix4x3ld = Matrix<long double,4,3>;
     using Matrix4x4ld = Matrix<long double,4,4>;
     using MatrixXld = Matrix<long double,Dynamic,Dynamic>;
+
+    template <typename T, size_t M, size_t N, unsigned int Flags = 0>
+    using RealMatrix = Matrix<T,M,N,Flags | RealStorage>;
+
+    using RealMatrix2f = RealMatrix<float,2,2>;
+    using RealMatrix3f = RealMatrix<float,3,3>;
+    using RealMatrix4f = RealMatrix<float,4,4>;
+    using RealMatrixXf = RealMatrix<float,Dynamic,Dynamic>;
+
+    using RealMatrix2d = RealMatrix<double,2,2>;
+    using RealMatrix3d = RealMatrix<double,3,3>;
+    using RealMatrix4d = RealMatrix<double,4,4>;
+    using RealMatrixXd = RealMatrix<double,Dynamic,Dynamic>;
+
+    using RealMatrix2ld = RealMatrix<long double,2,2>;
+    using RealMatrix3ld = RealMatrix<long double,3,3>;
+    using RealMatrix4ld = RealMatrix<long double,4,4>;
+    using RealMatrixXld = RealMatrix<long double,Dynamic,Dynamic>;
 }
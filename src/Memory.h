@@ -0,0 +1,392 @@
+#pragma once
+#include <cstddef> // For size_t
+#include <cstdint>
+#include <new>
+#include <vector>
+#include <algorithm>
+
+/**
+ * Alignment (in bytes) of the heap buffers of dynamically sized matrices. Define LINEAR_HEAP_ALIGNMENT before including
+ * Linear to override. Must be a power of two.
+ */
+#ifndef LINEAR_HEAP_ALIGNMENT
+#define LINEAR_HEAP_ALIGNMENT 64
+#endif
+
+namespace Linear {
+    /**
+     * Source of the heap memory used by dynamically sized matrices. Derive from it to route matrix memory through a pool,
+     * an arena, a quota tracker, etc.
+     *
+     * A matrix takes the current default resource (see UseMemoryResource) when it is created, copies included, and keeps
+     * it for its whole life: resizing or assigning to the matrix allocates from the same resource. Moving (or swapping) a
+     * matrix hands over its entries together with their resource. Temporaries created inside Linear's functions use the
+     * current default resource. A resource must outlive every matrix using it.
+     */
+    class MemoryResource {
+    public:
+        virtual ~MemoryResource() {}
+        /**
+         * Allocates bytes bytes aligned to alignment. Throws (e.g. std::bad_alloc) on failure.
+         * @param bytes Number of bytes
+         * @param alignment Power of two alignment in bytes
+         * @return Pointer to the memory
+         */
+        virtual void * Allocate(size_t bytes, size_t alignment) = 0;
+        /**
+         * Releases memory returned by Allocate.
+         * @param p Pointer returned by Allocate
+         * @param bytes Number of bytes passed to Allocate
+         * @param alignment Alignment passed to Allocate
+         */
+        virtual void Deallocate(void * p, size_t bytes, size_t alignment) = 0;
+    };
+
+    /**
+     * Memory resource using the global operator new and operator delete, over-allocating to honour the alignment.
+     * This is the default resource.
+     */
+    class NewDeleteResource : public MemoryResource {
+    public:
+        void * Allocate(size_t bytes, size_t alignment) override {
+            // Keep the pointer returned by operator new just before the aligned block.
+            char * raw = static_cast<char*>(::operator new(bytes + alignment - 1 + sizeof(void*)));
+            std::uintptr_t address = reinterpret_cast<std::uintptr_t>(raw + sizeof(void*));
+            address = (address + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1);
+            void * aligned = reinterpret_cast<void*>(address);
+            static_cast<void**>(aligned)[-1] = raw;
+            return aligned;
+        }
+        void Deallocate(void * p, size_t, size_t) override {
+            ::operator delete(static_cast<void**>(p)[-1]);
+        }
+    };
+
+    /**
+     * Memory resource that forwards to another resource while keeping track of the number of bytes in use. If a limit is
+     * given, allocations that would exceed it throw std::bad_alloc.
+     */
+    class TrackingResource : public MemoryResource {
+    public:
+        /**
+         * Constructor.
+         * @param upstream Resource to allocate from
+         * @param limit Maximum number of bytes in use at once (default = 0, no limit)
+         */
+        TrackingResource(MemoryResource * upstream, size_t limit = 0) {
+            this->upstream = upstream;
+            this->limit = limit;
+            this->inUse = 0;
+            this->peak = 0;
+            this->allocations = 0;
+        }
+        void * Allocate(size_t bytes, size_t alignment) override {
+            if (this->limit != 0 && this->inUse + bytes > this->limit)
+                throw std::bad_alloc();
+            void * p = this->upstream->Allocate(bytes, alignment);
+            this->inUse += bytes;
+            this->allocations += 1;
+            if (this->inUse > this->peak)
+                this->peak = this->inUse;
+            return p;
+        }
+        void Deallocate(void * p, size_t bytes, size_t alignment) override {
+            this->upstream->Deallocate(p, bytes, alignment);
+            this->inUse -= bytes;
+        }
+        /**
+         * @return Number of bytes currently allocated.
+         */
+        size_t BytesInUse() const { return this->inUse; }
+        /**
+         * @return Largest number of bytes allocated at once.
+         */
+        size_t PeakBytes() const { return this->peak; }
+        /**
+         * @return Number of calls to Allocate that succeeded.
+         */
+        size_t NumAllocations() const { return this->allocations; }
+    private:
+        MemoryResource * upstream;
+        size_t limit, inUse, peak, allocations;
+    };
+
+    /// \cond DO_NOT_DOCUMENT
+    inline MemoryResource *& CurrentMemoryResource() {
+        static thread_local MemoryResource * current = NULL;
+        return current;
+    }
+    /// \endcond
+
+    /**
+     * @return Resource used by new matrices on this thread.
+     */
+    inline MemoryResource * GetDefaultMemoryResource() {
+        static NewDeleteResource newDelete;
+        MemoryResource * current = CurrentMemoryResource();
+        return (current != NULL ? current : &newDelete);
+    }
+    /**
+     * Sets the resource used by new matrices on this thread.
+     * @param resource Memory resource, or NULL for the operator new based default.
+     * @return The previous resource.
+     */
+    inline MemoryResource * SetDefaultMemoryResource(MemoryResource * resource) {
+        MemoryResource * previous = GetDefaultMemoryResource();
+        CurrentMemoryResource() = resource;
+        return previous;
+    }
+
+    /**
+     * Makes resource the default for new matrices on this thread until the object goes out of scope.
+     *
+     *     TrackingResource tracker(GetDefaultMemoryResource());
+     *     {
+     *         UseMemoryResource use(&tracker);
+     *         MatrixXd A = Inverse(B);  // A and every temporary of Inverse come from tracker.
+     *     }
+     */
+    class UseMemoryResource {
+    public:
+        UseMemoryResource(MemoryResource * resource) {
+            this->previous = CurrentMemoryResource();
+            CurrentMemoryResource() = resource;
+        }
+        ~UseMemoryResource() {
+            CurrentMemoryResource() = this->previous;
+        }
+        UseMemoryResource(const UseMemoryResource&) = delete;
+        UseMemoryResource& operator=(const UseMemoryResource&) = delete;
+    private:
+        MemoryResource * previous;
+    };
+
+    /**
+     * Arena for the temporaries of decompositions and other iterative routines. Memory is handed out by bumping a pointer
+     * through a few large chunks taken from an upstream resource, and is given back all at once by Rewind() or Reset().
+     * Once a workspace has grown to fit a computation, repeating computations of the same size allocate nothing upstream.
+     *
+     * A workspace is either passed to a routine (e.g. QR::Compute(A, &workspace)) or bound to the thread with UseWorkspace.
+     * Only the temporaries of the routine come from it; its results use their own resource. A workspace must not be used
+     * by two threads at once.
+     *
+     *     Workspace workspace;
+     *     UseWorkspace use(&workspace);
+     *     Schur<double,Dynamic> schur(A);
+     *     for (...) {
+     *         schur.Compute(NextMatrix());  // No heap allocations once the workspace and schur have grown.
+     *     }
+     */
+    class Workspace : public MemoryResource {
+    public:
+        /**
+         * Position in the workspace, see GetMark() and Rewind().
+         */
+        struct Mark {
+            size_t chunk; /*!< Index of the chunk in use */
+            size_t offset; /*!< Number of bytes used in that chunk */
+        };
+
+        /**
+         * Constructor.
+         * @param capacity Number of bytes to reserve right away (default = 0, grow on demand)
+         * @param upstream Resource the chunks are allocated from (default = NULL, the current default resource)
+         */
+        explicit Workspace(size_t capacity = 0, MemoryResource * upstream = NULL) {
+            this->upstream = (upstream != NULL ? upstream : GetDefaultMemoryResource());
+            this->current = 0;
+            this->offset = 0;
+            if (capacity != 0)
+                AddChunk(capacity);
+        }
+        ~Workspace() {
+            ReleaseChunks();
+        }
+        Workspace(const Workspace&) = delete;
+        Workspace& operator=(const Workspace&) = delete;
+
+        void * Allocate(size_t bytes, size_t alignment) override {
+            for (;;) {
+                if (this->current < this->chunks.size()) {
+                    Chunk& chunk = this->chunks[this->current];
+                    std::uintptr_t base = reinterpret_cast<std::uintptr_t>(chunk.begin);
+                    std::uintptr_t address = (base + this->offset + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1);
+                    if (address - base + bytes <= chunk.size) {
+                        this->offset = address - base + bytes;
+                        return reinterpret_cast<void*>(address);
+                    }
+                }
+                if (this->current + 1 >= this->chunks.size())
+                    break;
+                // Chunks past the current one are left over from before a Rewind, reuse them.
+                this->current += 1;
+                this->offset = 0;
+            }
+            AddChunk(std::max(bytes + alignment, 2*Capacity()));
+            return Allocate(bytes, alignment);
+        }
+        /**
+         * Memory is only given back by Rewind() and Reset(), except for the most recent allocation which is released
+         * right away.
+         */
+        void Deallocate(void * p, size_t bytes, size_t) override {
+            if (this->current < this->chunks.size()) {
+                char * begin = this->chunks[this->current].begin;
+                if (static_cast<char*>(p) + bytes == begin + this->offset)
+                    this->offset = static_cast<char*>(p) - begin;
+            }
+        }
+
+        /**
+         * @return Current position, to be passed to Rewind().
+         */
+        Mark GetMark() const {
+            Mark mark = {this->current, this->offset};
+            return mark;
+        }
+        /**
+         * Releases everything allocated since mark was taken. Matrices allocated after the mark must not be used anymore.
+         * Rewinding to the very start merges the chunks into a single one.
+         * @param mark Position returned by GetMark()
+         */
+        void Rewind(const Mark& mark) {
+            this->current = mark.chunk;
+            this->offset = mark.offset;
+            if (mark.chunk == 0 && mark.offset == 0 && this->chunks.size() > 1) {
+                size_t capacity = Capacity();
+                ReleaseChunks();
+                AddChunk(capacity);
+            }
+        }
+        /**
+         * Releases everything allocated from the workspace, keeping the memory for later use.
+         */
+        void Reset() {
+            Rewind(Mark{0, 0});
+        }
+        /**
+         * @return Number of bytes handed out since the last Reset(), including padding.
+         */
+        size_t BytesInUse() const {
+            size_t bytes = this->offset;
+            for (size_t i = 0; i < this->current && i < this->chunks.size(); ++i)
+                bytes += this->chunks[i].size;
+            return bytes;
+        }
+        /**
+         * @return Number of bytes held by the workspace.
+         */
+        size_t Capacity() const {
+            size_t bytes = 0;
+            for (size_t i = 0; i < this->chunks.size(); ++i)
+                bytes += this->chunks[i].size;
+            return bytes;
+        }
+    private:
+        struct Chunk {
+            char * begin;
+            size_t size;
+        };
+
+        void AddChunk(size_t size) {
+            size = std::max(size, static_cast<size_t>(4096));
+            Chunk chunk = {static_cast<char*>(this->upstream->Allocate(size, LINEAR_HEAP_ALIGNMENT)), size};
+            this->chunks.push_back(chunk);
+            this->current = this->chunks.size()-1;
+            this->offset = 0;
+        }
+        void ReleaseChunks() {
+            for (size_t i = 0; i < this->chunks.size(); ++i)
+                this->upstream->Deallocate(this->chunks[i].begin, this->chunks[i].size, LINEAR_HEAP_ALIGNMENT);
+            this->chunks.clear();
+            this->current = 0;
+            this->offset = 0;
+        }
+
+        MemoryResource * upstream;
+        std::vector<Chunk> chunks;
+        size_t current, offset;
+    };
+
+    /// \cond DO_NOT_DOCUMENT
+    inline Workspace *& CurrentWorkspace() {
+        static thread_local Workspace * current = NULL;
+        return current;
+    }
+    /// \endcond
+
+    /**
+     * @return Workspace bound to this thread, or NULL.
+     */
+    inline Workspace * GetWorkspace() {
+        return CurrentWorkspace();
+    }
+
+    /**
+     * Binds workspace to this thread until the object goes out of scope. Routines that accept a workspace use it when
+     * none is passed to them.
+     */
+    class UseWorkspace {
+    public:
+        UseWorkspace(Workspace * workspace) {
+            this->previous = CurrentWorkspace();
+            CurrentWorkspace() = workspace;
+        }
+        ~UseWorkspace() {
+            CurrentWorkspace() = this->previous;
+        }
+        UseWorkspace(const UseWorkspace&) = delete;
+        UseWorkspace& operator=(const UseWorkspace&) = delete;
+    private:
+        Workspace * previous;
+    };
+
+    /**
+     * Allocates every new matrix from a workspace until the object goes out of scope, then rewinds the workspace. Used
+     * by routines for their temporaries:
+     *
+     *     void Compute(const MatrixXd& A, Workspace * workspace = NULL) {
+     *         WorkspaceScope scope(workspace, this->Q.Resource());
+     *         ...  // Temporaries come from the workspace, this->Q keeps its own memory.
+     *     }
+     *
+     * The workspace is the one given, or else the one bound to the thread. Without either, the scope does nothing. While
+     * the scope is open the workspace is also bound to the thread, so nested routines share it.
+     */
+    class WorkspaceScope {
+    public:
+        /**
+         * Constructor.
+         * @param workspace Workspace to use, or NULL for the one bound to the thread.
+         * @param results Resource of the matrices the routine writes its results into (default = NULL). If it is the
+         * workspace itself, the routine is running on behalf of an enclosing scope which will rewind the workspace, so
+         * this scope does nothing.
+         */
+        WorkspaceScope(Workspace * workspace, MemoryResource * results = NULL) {
+            this->workspace = (workspace != NULL ? workspace : CurrentWorkspace());
+            this->active = (this->workspace != NULL && this->workspace != results);
+            if (!this->active)
+                return;
+            this->mark = this->workspace->GetMark();
+            this->previousResource = CurrentMemoryResource();
+            this->previousWorkspace = CurrentWorkspace();
+            CurrentMemoryResource() = this->workspace;
+            CurrentWorkspace() = this->workspace;
+        }
+        ~WorkspaceScope() {
+            if (!this->active)
+                return;
+            CurrentMemoryResource() = this->previousResource;
+            CurrentWorkspace() = this->previousWorkspace;
+            this->workspace->Rewind(this->mark);
+        }
+        WorkspaceScope(const WorkspaceScope&) = delete;
+        WorkspaceScope& operator=(const WorkspaceScope&) = delete;
+    private:
+        Workspace * workspace;
+        bool active;
+        Workspace::Mark mark;
+        MemoryResource * previousResource;
+        Workspace * previousWorkspace;
+    };
+}
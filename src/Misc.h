@@ -179,4 +179,11 @@ namespace Linear {
     typename std::enable_if<(M==P||P==Dynamic||M==Dynamic), RowVector<T,M>>::type Solve(const Matrix<T,M,N,Flags>& A, const RowVector<T,P>& b) {
         return Transpose(Solve(Transpose(A), Transpose(b)));
     }
+
+    // Accept unevaluated expressions, e.g. NullSpace(A - B).
+    LINEAR_EVALUATE_EXPRESSIONS(NullSpace)
+    LINEAR_EVALUATE_EXPRESSIONS(Nullity)
+    LINEAR_EVALUATE_EXPRESSIONS(ColumnSpace)
+    LINEAR_EVALUATE_EXPRESSIONS(Rank)
+    LINEAR_EVALUATE_EXPRESSIONS(Solve)
 }
@@ -0,0 +1,202 @@
+#pragma once
+#include <cstddef> // For size_t
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Products with at least this many multiply-adds (rows*columns*inner size) are split across the threads of the pool, see
+ * SetNumThreads(). Define LINEAR_PARALLEL_THRESHOLD before including Linear to override.
+ */
+#ifndef LINEAR_PARALLEL_THRESHOLD
+#define LINEAR_PARALLEL_THRESHOLD 2097152
+#endif
+
+namespace Linear {
+    /**
+     * Fixed set of worker threads running loops for Linear. The thread calling ParallelFor() runs iterations too, so a
+     * pool of n threads starts n-1 workers, and loops started from inside a loop (or from several threads at once) cannot
+     * deadlock: each caller finishes its own loop if the workers are busy.
+     *
+     * Linear shares one pool (see SetNumThreads()), but a pool can also be created and used directly:
+     *
+     *     ThreadPool pool(4);
+     *     pool.ParallelFor(rows.size(), [&](size_t i) { Process(rows[i]); });
+     */
+    class ThreadPool {
+    public:
+        /**
+         * Constructor.
+         * @param numThreads Number of threads running each loop, including the caller (at least 1)
+         */
+        explicit ThreadPool(size_t numThreads) {
+            this->stop = false;
+            for (size_t i = 1; i < numThreads; ++i)
+                this->workers.emplace_back([this]() { WorkerLoop(); });
+        }
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->stop = true;
+            }
+            this->wake.notify_all();
+            for (size_t i = 0; i < this->workers.size(); ++i)
+                this->workers[i].join();
+        }
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * @return Number of threads running each loop, including the caller.
+         */
+        size_t NumThreads() const {
+            return this->workers.size()+1;
+        }
+
+        /**
+         * Calls f(i) for every i < count, spread over the threads of the pool, and returns once every call has. If a call
+         * throws, the remaining iterations are skipped and the first exception is rethrown here.
+         * @param count Number of iterations
+         * @param f Function taking the iteration index
+         */
+        template <typename F>
+        void ParallelFor(size_t count, const F& f) {
+            if (count == 0)
+                return;
+            if (count == 1 || this->workers.empty()) {
+                for (size_t i = 0; i < count; ++i)
+                    f(i);
+                return;
+            }
+            // Wrapped in a reference, f fits in the std::function without allocating.
+            Job job(count, std::cref(f));
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->jobs.push_back(&job);
+            }
+            this->wake.notify_all();
+            Run(job);
+            std::unique_lock<std::mutex> lock(this->mutex);
+            for (size_t i = 0; i < this->jobs.size(); ++i) {
+                if (this->jobs[i] == &job) {
+                    this->jobs.erase(this->jobs.begin()+i);
+                    break;
+                }
+            }
+            // Workers still running an iteration hold on to the job.
+            this->finished.wait(lock, [&job]() { return job.users == 0; });
+            if (job.error)
+                std::rethrow_exception(job.error);
+        }
+    private:
+        struct Job {
+            Job(size_t count, const std::function<void(size_t)>& f) : f(f), count(count), next(0), users(0), failed(false) {}
+
+            std::function<void(size_t)> f;
+            size_t count;
+            std::atomic<size_t> next;
+            size_t users; // Workers in Run(), guarded by the pool's mutex.
+            std::atomic<bool> failed;
+            std::exception_ptr error;
+        };
+
+        void Run(Job& job) {
+            for (size_t i = job.next++; i < job.count; i = job.next++) {
+                if (job.failed)
+                    continue;
+                try {
+                    job.f(i);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(this->errorMutex);
+                    if (!job.failed)
+                        job.error = std::current_exception();
+                    job.failed = true;
+                }
+            }
+        }
+        void WorkerLoop() {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            for (;;) {
+                this->wake.wait(lock, [this]() { return this->stop || !this->jobs.empty(); });
+                if (this->stop)
+                    return;
+                Job * job = this->jobs.front();
+                if (job->next >= job->count) {
+                    // Every iteration is taken, the caller removes the job.
+                    this->jobs.pop_front();
+                    continue;
+                }
+                job->users += 1;
+                lock.unlock();
+                Run(*job);
+                lock.lock();
+                job->users -= 1;
+                if (job->users == 0)
+                    this->finished.notify_all();
+            }
+        }
+
+        std::vector<std::thread> workers;
+        std::deque<Job*> jobs;
+        std::mutex mutex, errorMutex;
+        std::condition_variable wake, finished;
+        bool stop;
+    };
+
+    /// \cond DO_NOT_DOCUMENT
+    struct SharedThreadPool {
+        std::mutex mutex;
+        std::shared_ptr<ThreadPool> pool;
+        size_t numThreads;
+    };
+
+    inline SharedThreadPool& GetSharedThreadPool() {
+        static SharedThreadPool shared = {{}, NULL, std::max<size_t>(1, std::thread::hardware_concurrency())};
+        return shared;
+    }
+    /// \endcond
+
+    /**
+     * Sets the number of threads Linear splits large matrix products across, including the calling thread. Defaults to
+     * the number of hardware threads; 1 runs everything on the calling thread. Products already running keep their pool.
+     * @param numThreads Number of threads (0 means the number of hardware threads)
+     */
+    inline void SetNumThreads(size_t numThreads) {
+        if (numThreads == 0)
+            numThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        SharedThreadPool& shared = GetSharedThreadPool();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        if (shared.numThreads != numThreads) {
+            shared.numThreads = numThreads;
+            shared.pool.reset();
+        }
+    }
+
+    /**
+     * @return Number of threads Linear splits large matrix products across, see SetNumThreads().
+     */
+    inline size_t GetNumThreads() {
+        SharedThreadPool& shared = GetSharedThreadPool();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        return shared.numThreads;
+    }
+
+    /**
+     * @return Thread pool shared by Linear's routines, started on first use.
+     */
+    inline std::shared_ptr<ThreadPool> GetThreadPool() {
+        SharedThreadPool& shared = GetSharedThreadPool();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        if (!shared.pool)
+            shared.pool = std::make_shared<ThreadPool>(shared.numThreads);
+        return shared.pool;
+    }
+}
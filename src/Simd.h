@@ -0,0 +1,339 @@
+#pragma once
+#include <cstddef> // For size_t
+
+/**
+ * Define LINEAR_NO_SIMD before including Linear to only use the portable C++ kernels. Otherwise the matrix product picks
+ * the widest instruction set the processor supports when it is first used: AVX-512, AVX2 with FMA or SSE2 on x86 (with
+ * GCC or Clang), NEON on 64-bit ARM.
+ */
+#if !defined(LINEAR_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define LINEAR_SIMD_X86 1
+#include <immintrin.h>
+#elif !defined(LINEAR_NO_SIMD) && defined(__aarch64__) && defined(__ARM_NEON)
+#define LINEAR_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace Linear {
+    /// \cond DO_NOT_DOCUMENT
+    /**
+     * Instruction sets the kernels are written for, from narrowest to widest.
+     */
+    enum SimdLevel {
+        SimdNone,
+        SimdSSE2,
+        SimdAVX2,
+        SimdAVX512,
+        SimdNEON
+    };
+
+    /**
+     * @return Widest instruction set supported by both the processor and the operating system, detected once.
+     */
+    inline SimdLevel DetectSimdLevel() {
+#if defined(LINEAR_SIMD_X86)
+        static const SimdLevel level = []() {
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f"))
+                return SimdAVX512;
+            if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+                return SimdAVX2;
+            if (__builtin_cpu_supports("sse2"))
+                return SimdSSE2;
+            return SimdNone;
+        }();
+        return level;
+#elif defined(LINEAR_SIMD_NEON)
+        return SimdNEON;
+#else
+        return SimdNone;
+#endif
+    }
+
+    /*
+     * Micro-kernels of the packed matrix product (see PackedMultiplyAdd). Each computes the MRxNR block
+     *     acc = sum over p < kc of a[p*MR+i]*b[p*NR+j]
+     * from packed panels, keeping the block in vector registers, and stores it row by row into acc. The complex kernels
+     * read panels holding the MR (NR) real parts of each p followed by the imaginary parts, and store the real parts of
+     * the block followed by its imaginary parts. NR is NV vectors wide.
+     *
+     * Every instruction set gets its own copy of the two kernels, compiled for it through the target attribute, along
+     * with overloads of the few vector operations they use. Only the kernels of the detected instruction set run.
+     */
+// The kernels rely on their loops over the block being unrolled, so that the block lives in registers.
+#if defined(__clang__)
+#define LINEAR_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__)
+#define LINEAR_UNROLL _Pragma("GCC unroll 16")
+#else
+#define LINEAR_UNROLL
+#endif
+#define LINEAR_SIMD_KERNELS(Name, Ops, Target)                                                                          \
+    template <size_t MR, size_t NV, typename T>                                                                         \
+    Target void Name(size_t kc, const T * a, const T * b, T * acc) {                                                    \
+        typedef decltype(Ops::Zero(T())) V;                                                                             \
+        const size_t L = sizeof(V)/sizeof(T), NR = NV*L;                                                                \
+        V c[MR][NV];                                                                                                    \
+        LINEAR_UNROLL                                                                                                   \
+        for (size_t i = 0; i < MR; ++i)                                                                                 \
+            LINEAR_UNROLL                                                                                               \
+            for (size_t v = 0; v < NV; ++v)                                                                             \
+                c[i][v] = Ops::Zero(T());                                                                               \
+        for (size_t p = 0; p < kc; ++p, a += MR, b += NR) {                                                             \
+            V bv[NV];                                                                                                   \
+            LINEAR_UNROLL                                                                                               \
+            for (size_t v = 0; v < NV; ++v)                                                                             \
+                bv[v] = Ops::Load(b + v*L);                                                                             \
+            LINEAR_UNROLL                                                                                               \
+            for (size_t i = 0; i < MR; ++i) {                                                                           \
+                V ai = Ops::Broadcast(a + i);                                                                           \
+                LINEAR_UNROLL                                                                                           \
+                for (size_t v = 0; v < NV; ++v)                                                                         \
+                    c[i][v] = Ops::MulAdd(ai, bv[v], c[i][v]);                                                          \
+            }                                                                                                           \
+        }                                                                                                               \
+        LINEAR_UNROLL                                                                                                   \
+        for (size_t i = 0; i < MR; ++i)                                                                                 \
+            LINEAR_UNROLL                                                                                               \
+            for (size_t v = 0; v < NV; ++v)                                                                             \
+                Ops::Store(acc + i*NR + v*L, c[i][v]);                                                                  \
+    }                                                                                                                   \
+    template <size_t MR, size_t NV, typename T>                                                                         \
+    Target void Name##Complex(size_t kc, const T * a, const T * b, T * acc) {                                           \
+        typedef decltype(Ops::Zero(T())) V;                                                                             \
+        const size_t L = sizeof(V)/sizeof(T), NR = NV*L;                                                                \
+        V re[MR][NV], im[MR][NV];                                                                                       \
+        LINEAR_UNROLL                                                                                                   \
+        for (size_t i = 0; i < MR; ++i)                                                                                 \
+            LINEAR_UNROLL                                                                                               \
+            for (size_t v = 0; v < NV; ++v)                                                                             \
+                re[i][v] = im[i][v] = Ops::Zero(T());                                                                   \
+        for (size_t p = 0; p < kc; ++p, a += 2*MR, b += 2*NR) {                                                         \
+            V br[NV], bi[NV];                                                                                           \
+            LINEAR_UNROLL                                                                                               \
+            for (size_t v = 0; v < NV; ++v) {                                                                           \
+                br[v] = Ops::Load(b + v*L);                                                                             \
+                bi[v] = Ops::Load(b + NR + v*L);                                                                        \
+            }                                                                                                           \
+            LINEAR_UNROLL                                                                                               \
+            for (size_t i = 0; i < MR; ++i) {                                                                           \
+                V ar = Ops::Broadcast(a + i), ai = Ops::Broadcast(a + MR + i);                                          \
+                LINEAR_UNROLL                                                                                           \
+                for (size_t v = 0; v < NV; ++v) {                                                                       \
+                    re[i][v] = Ops::MulSub(ai, bi[v], Ops::MulAdd(ar, br[v], re[i][v]));                                \
+                    im[i][v] = Ops::MulAdd(ai, br[v], Ops::MulAdd(ar, bi[v], im[i][v]));                                \
+                }                                                                                                       \
+            }                                                                                                           \
+        }                                                                                                               \
+        LINEAR_UNROLL                                                                                                   \
+        for (size_t i = 0; i < MR; ++i) {                                                                               \
+            LINEAR_UNROLL                                                                                               \
+            for (size_t v = 0; v < NV; ++v) {                                                                           \
+                Ops::Store(acc + i*NR + v*L, re[i][v]);                                                                 \
+                Ops::Store(acc + MR*NR + i*NR + v*L, im[i][v]);                                                         \
+            }                                                                                                           \
+        }                                                                                                               \
+    }
+
+/*
+ * Kernels of the matrix-vector product (see GemvMultiplyAdd), on arrays of reals (complex entries count as two).
+ * Columns computes, for the rows i < rows of the array a whose column j starts at a + j*lda,
+ *     acc1[i] = sum over j < n of a[j*lda+i]*xr[j]    and    acc2[i] = sum over j < n of a[j*lda+i]*xi[j]
+ * (acc2 only if xi is not NULL), four columns at a time. Rows computes, for each row r < count of the
+ * array a whose row r starts at a + r*lda, the sums over j < k of a[r*lda+j]*v[j] at even j and at odd j into
+ * sums[4*r] and sums[4*r+1], and likewise with w into sums[4*r+2] and sums[4*r+3] (0 if w is NULL), four rows at a time.
+ */
+#define LINEAR_SIMD_GEMV_KERNELS(Name, Ops, Target)                                                                     \
+    template <bool Two, size_t NC, typename T>                                                                          \
+    Target void Name##ColumnGroup(size_t h, const T * a, size_t lda, const T * xr, const T * xi, T * acc1, T * acc2) {  \
+        typedef decltype(Ops::Zero(T())) V;                                                                             \
+        const size_t L = sizeof(V)/sizeof(T);                                                                           \
+        V br[NC], bi[NC];                                                                                               \
+        LINEAR_UNROLL                                                                                                   \
+        for (size_t c = 0; c < NC; ++c) {                                                                               \
+            br[c] = Ops::Broadcast(xr + c);                                                                             \
+            bi[c] = (Two ? Ops::Broadcast(xi + c) : br[c]);                                                             \
+        }                                                                                                               \
+        for (size_t i = 0; i < h; i += L) {                                                                             \
+            V r = Ops::Load(acc1 + i), s = (Two ? Ops::Load(acc2 + i) : r);                                             \
+            LINEAR_UNROLL                                                                                               \
+            for (size_t c = 0; c < NC; ++c) {                                                                           \
+                V av = Ops::Load(a + c*lda + i);                                                                        \
+                r = Ops::MulAdd(av, br[c], r);                                                                          \
+                if (Two)                                                                                                \
+                    s = Ops::MulAdd(av, bi[c], s);                                                                      \
+            }                                                                                                           \
+            Ops::Store(acc1 + i, r);                                                                                    \
+            if (Two)                                                                                                    \
+                Ops::Store(acc2 + i, s);                                                                                \
+        }                                                                                                               \
+    }                                                                                                                   \
+    template <bool Two, typename T>                                                                                     \
+    Target void Name##ColumnBlocks(size_t rows, size_t n, const T * a, size_t lda, const T * xr, const T * xi,          \
+                                   T * acc1, T * acc2) {                                                                \
+        typedef decltype(Ops::Zero(T())) V;                                                                             \
+        const size_t L = sizeof(V)/sizeof(T);                                                                           \
+        for (size_t i = 0; i < rows; ++i) {                                                                             \
+            acc1[i] = T(0);                                                                                             \
+            if (Two)                                                                                                    \
+                acc2[i] = T(0);                                                                                         \
+        }                                                                                                               \
+        /* Blocks of rows short enough for their sums to stay in L1, added to four columns at a time. */                \
+        for (size_t i0 = 0; i0 < rows; i0 += 1024) {                                                                    \
+            const size_t h = (rows-i0 < 1024 ? rows-i0 : 1024), hv = h/L*L;                                             \
+            T * s1 = acc1 + i0, * s2 = (Two ? acc2 + i0 : acc2);                                                        \
+            size_t j = 0;                                                                                               \
+            for (; j + 4 <= n; j += 4)                                                                                  \
+                Name##ColumnGroup<Two,4>(hv, a + j*lda + i0, lda, xr + j, (Two ? xi + j : xi), s1, s2);                 \
+            for (; j < n; ++j)                                                                                          \
+                Name##ColumnGroup<Two,1>(hv, a + j*lda + i0, lda, xr + j, (Two ? xi + j : xi), s1, s2);                 \
+            for (size_t i = hv; i < h; ++i) {                                                                           \
+                for (j = 0; j < n; ++j) {                                                                               \
+                    s1[i] += a[j*lda+i0+i]*xr[j];                                                                       \
+                    if (Two)                                                                                            \
+                        s2[i] += a[j*lda+i0+i]*xi[j];                                                                   \
+                }                                                                                                       \
+            }                                                                                                           \
+        }                                                                                                               \
+    }                                                                                                                   \
+    template <typename T>                                                                                               \
+    Target void Name##Columns(size_t rows, size_t n, const T * a, size_t lda, const T * xr, const T * xi,               \
+                              T * acc1, T * acc2) {                                                                     \
+        if (xi != NULL)                                                                                                 \
+            Name##ColumnBlocks<true>(rows, n, a, lda, xr, xi, acc1, acc2);                                              \
+        else                                                                                                            \
+            Name##ColumnBlocks<false>(rows, n, a, lda, xr, xi, acc1, acc2);                                             \
+    }                                                                                                                   \
+    template <bool Two, size_t R, typename T>                                                                           \
+    Target void Name##RowBlock(size_t k, const T * a, size_t lda, const T * v, const T * w, T * sums) {                 \
+        typedef decltype(Ops::Zero(T())) V;                                                                             \
+        const size_t L = sizeof(V)/sizeof(T);                                                                           \
+        V p[R], q[R];                                                                                                   \
+        LINEAR_UNROLL                                                                                                   \
+        for (size_t r = 0; r < R; ++r)                                                                                  \
+            p[r] = q[r] = Ops::Zero(T());                                                                               \
+        size_t j = 0;                                                                                                   \
+        for (; j + L <= k; j += L) {                                                                                    \
+            V vv = Ops::Load(v + j), ww = (Two ? Ops::Load(w + j) : vv);                                                \
+            LINEAR_UNROLL                                                                                               \
+            for (size_t r = 0; r < R; ++r) {                                                                            \
+                V ar = Ops::Load(a + r*lda + j);                                                                        \
+                p[r] = Ops::MulAdd(ar, vv, p[r]);                                                                       \
+                if (Two)                                                                                                \
+                    q[r] = Ops::MulAdd(ar, ww, q[r]);                                                                   \
+            }                                                                                                           \
+        }                                                                                                               \
+        for (size_t r = 0; r < R; ++r) {                                                                                \
+            T bp[sizeof(V)/sizeof(T)], bq[sizeof(V)/sizeof(T)], s[4] = {};                                              \
+            Ops::Store(bp, p[r]);                                                                                       \
+            Ops::Store(bq, q[r]);                                                                                       \
+            for (size_t l = 0; l < L; ++l) {                                                                            \
+                s[l%2] += bp[l];                                                                                        \
+                s[2+l%2] += bq[l];                                                                                      \
+            }                                                                                                           \
+            for (size_t t = j; t < k; ++t) {                                                                            \
+                s[t%2] += a[r*lda+t]*v[t];                                                                              \
+                if (Two)                                                                                                \
+                    s[2+t%2] += a[r*lda+t]*w[t];                                                                        \
+            }                                                                                                           \
+            for (size_t l = 0; l < 4; ++l)                                                                              \
+                sums[4*r+l] = s[l];                                                                                     \
+        }                                                                                                               \
+    }                                                                                                                   \
+    template <typename T>                                                                                               \
+    Target void Name##Rows(size_t count, size_t k, const T * a, size_t lda, const T * v, const T * w, T * sums) {       \
+        size_t r = 0;                                                                                                   \
+        for (; r + 4 <= count; r += 4) {                                                                                \
+            if (w != NULL)                                                                                              \
+                Name##RowBlock<true,4>(k, a + r*lda, lda, v, w, sums + 4*r);                                            \
+            else                                                                                                        \
+                Name##RowBlock<false,4>(k, a + r*lda, lda, v, w, sums + 4*r);                                           \
+        }                                                                                                               \
+        for (; r < count; ++r) {                                                                                        \
+            if (w != NULL)                                                                                              \
+                Name##RowBlock<true,1>(k, a + r*lda, lda, v, w, sums + 4*r);                                            \
+            else                                                                                                        \
+                Name##RowBlock<false,1>(k, a + r*lda, lda, v, w, sums + 4*r);                                           \
+        }                                                                                                               \
+    }
+
+#if defined(LINEAR_SIMD_X86)
+#define LINEAR_TARGET_SSE2 __attribute__((target("sse2")))
+#define LINEAR_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define LINEAR_TARGET_AVX512 __attribute__((target("avx512f")))
+
+    struct SSE2Ops {
+        LINEAR_TARGET_SSE2 static inline __m128d Zero(double) { return _mm_setzero_pd(); }
+        LINEAR_TARGET_SSE2 static inline __m128 Zero(float) { return _mm_setzero_ps(); }
+        LINEAR_TARGET_SSE2 static inline __m128d Load(const double * p) { return _mm_loadu_pd(p); }
+        LINEAR_TARGET_SSE2 static inline __m128 Load(const float * p) { return _mm_loadu_ps(p); }
+        LINEAR_TARGET_SSE2 static inline __m128d Broadcast(const double * p) { return _mm_set1_pd(*p); }
+        LINEAR_TARGET_SSE2 static inline __m128 Broadcast(const float * p) { return _mm_set1_ps(*p); }
+        LINEAR_TARGET_SSE2 static inline __m128d MulAdd(__m128d a, __m128d b, __m128d c) { return _mm_add_pd(c, _mm_mul_pd(a, b)); }
+        LINEAR_TARGET_SSE2 static inline __m128 MulAdd(__m128 a, __m128 b, __m128 c) { return _mm_add_ps(c, _mm_mul_ps(a, b)); }
+        LINEAR_TARGET_SSE2 static inline __m128d MulSub(__m128d a, __m128d b, __m128d c) { return _mm_sub_pd(c, _mm_mul_pd(a, b)); }
+        LINEAR_TARGET_SSE2 static inline __m128 MulSub(__m128 a, __m128 b, __m128 c) { return _mm_sub_ps(c, _mm_mul_ps(a, b)); }
+        LINEAR_TARGET_SSE2 static inline void Store(double * p, __m128d x) { _mm_storeu_pd(p, x); }
+        LINEAR_TARGET_SSE2 static inline void Store(float * p, __m128 x) { _mm_storeu_ps(p, x); }
+    };
+
+    struct AVX2Ops {
+        LINEAR_TARGET_AVX2 static inline __m256d Zero(double) { return _mm256_setzero_pd(); }
+        LINEAR_TARGET_AVX2 static inline __m256 Zero(float) { return _mm256_setzero_ps(); }
+        LINEAR_TARGET_AVX2 static inline __m256d Load(const double * p) { return _mm256_loadu_pd(p); }
+        LINEAR_TARGET_AVX2 static inline __m256 Load(const float * p) { return _mm256_loadu_ps(p); }
+        LINEAR_TARGET_AVX2 static inline __m256d Broadcast(const double * p) { return _mm256_broadcast_sd(p); }
+        LINEAR_TARGET_AVX2 static inline __m256 Broadcast(const float * p) { return _mm256_broadcast_ss(p); }
+        LINEAR_TARGET_AVX2 static inline __m256d MulAdd(__m256d a, __m256d b, __m256d c) { return _mm256_fmadd_pd(a, b, c); }
+        LINEAR_TARGET_AVX2 static inline __m256 MulAdd(__m256 a, __m256 b, __m256 c) { return _mm256_fmadd_ps(a, b, c); }
+        LINEAR_TARGET_AVX2 static inline __m256d MulSub(__m256d a, __m256d b, __m256d c) { return _mm256_fnmadd_pd(a, b, c); }
+        LINEAR_TARGET_AVX2 static inline __m256 MulSub(__m256 a, __m256 b, __m256 c) { return _mm256_fnmadd_ps(a, b, c); }
+        LINEAR_TARGET_AVX2 static inline void Store(double * p, __m256d x) { _mm256_storeu_pd(p, x); }
+        LINEAR_TARGET_AVX2 static inline void Store(float * p, __m256 x) { _mm256_storeu_ps(p, x); }
+    };
+
+    struct AVX512Ops {
+        LINEAR_TARGET_AVX512 static inline __m512d Zero(double) { return _mm512_setzero_pd(); }
+        LINEAR_TARGET_AVX512 static inline __m512 Zero(float) { return _mm512_setzero_ps(); }
+        LINEAR_TARGET_AVX512 static inline __m512d Load(const double * p) { return _mm512_loadu_pd(p); }
+        LINEAR_TARGET_AVX512 static inline __m512 Load(const float * p) { return _mm512_loadu_ps(p); }
+        LINEAR_TARGET_AVX512 static inline __m512d Broadcast(const double * p) { return _mm512_set1_pd(*p); }
+        LINEAR_TARGET_AVX512 static inline __m512 Broadcast(const float * p) { return _mm512_set1_ps(*p); }
+        LINEAR_TARGET_AVX512 static inline __m512d MulAdd(__m512d a, __m512d b, __m512d c) { return _mm512_fmadd_pd(a, b, c); }
+        LINEAR_TARGET_AVX512 static inline __m512 MulAdd(__m512 a, __m512 b, __m512 c) { return _mm512_fmadd_ps(a, b, c); }
+        LINEAR_TARGET_AVX512 static inline __m512d MulSub(__m512d a, __m512d b, __m512d c) { return _mm512_fnmadd_pd(a, b, c); }
+        LINEAR_TARGET_AVX512 static inline __m512 MulSub(__m512 a, __m512 b, __m512 c) { return _mm512_fnmadd_ps(a, b, c); }
+        LINEAR_TARGET_AVX512 static inline void Store(double * p, __m512d x) { _mm512_storeu_pd(p, x); }
+        LINEAR_TARGET_AVX512 static inline void Store(float * p, __m512 x) { _mm512_storeu_ps(p, x); }
+    };
+
+    LINEAR_SIMD_KERNELS(GemmKernelSSE2, SSE2Ops, LINEAR_TARGET_SSE2)
+    LINEAR_SIMD_KERNELS(GemmKernelAVX2, AVX2Ops, LINEAR_TARGET_AVX2)
+    LINEAR_SIMD_KERNELS(GemmKernelAVX512, AVX512Ops, LINEAR_TARGET_AVX512)
+    LINEAR_SIMD_GEMV_KERNELS(GemvKernelSSE2, SSE2Ops, LINEAR_TARGET_SSE2)
+    LINEAR_SIMD_GEMV_KERNELS(GemvKernelAVX2, AVX2Ops, LINEAR_TARGET_AVX2)
+    LINEAR_SIMD_GEMV_KERNELS(GemvKernelAVX512, AVX512Ops, LINEAR_TARGET_AVX512)
+#elif defined(LINEAR_SIMD_NEON)
+    struct NEONOps {
+        static inline float64x2_t Zero(double) { return vdupq_n_f64(0.0); }
+        static inline float32x4_t Zero(float) { return vdupq_n_f32(0.0f); }
+        static inline float64x2_t Load(const double * p) { return vld1q_f64(p); }
+        static inline float32x4_t Load(const float * p) { return vld1q_f32(p); }
+        static inline float64x2_t Broadcast(const double * p) { return vld1q_dup_f64(p); }
+        static inline float32x4_t Broadcast(const float * p) { return vld1q_dup_f32(p); }
+        static inline float64x2_t MulAdd(float64x2_t a, float64x2_t b, float64x2_t c) { return vfmaq_f64(c, a, b); }
+        static inline float32x4_t MulAdd(float32x4_t a, float32x4_t b, float32x4_t c) { return vfmaq_f32(c, a, b); }
+        static inline float64x2_t MulSub(float64x2_t a, float64x2_t b, float64x2_t c) { return vfmsq_f64(c, a, b); }
+        static inline float32x4_t MulSub(float32x4_t a, float32x4_t b, float32x4_t c) { return vfmsq_f32(c, a, b); }
+        static inline void Store(double * p, float64x2_t x) { vst1q_f64(p, x); }
+        static inline void Store(float * p, float32x4_t x) { vst1q_f32(p, x); }
+    };
+
+    LINEAR_SIMD_KERNELS(GemmKernelNEON, NEONOps, )
+    LINEAR_SIMD_GEMV_KERNELS(GemvKernelNEON, NEONOps, )
+#endif
+#undef LINEAR_SIMD_KERNELS
+#undef LINEAR_SIMD_GEMV_KERNELS
+#undef LINEAR_UNROLL
+    /// \endcond
+}
@@ -0,0 +1,180 @@
+#pragma once
+#include <cstddef> // For size_t
+#include <type_traits>
+#include "Complex.h"
+
+namespace Linear {
+    /// \cond DO_NOT_DOCUMENT
+    /**
+     * Whether an MxN size is known at compile time and small enough (at most 4x4) for the straight-line kernels below.
+     * Dynamic sizes are 0.
+     */
+    template <size_t M, size_t N>
+    struct IsSmallSize : std::integral_constant<bool, (M != 0 && N != 0 && M <= 4 && N <= 4)> {};
+
+    /**
+     * Whether an MxN size is a fixed 2x2, 3x3 or 4x4, which SmallSquare has a closed-form adjugate for.
+     */
+    template <size_t M, size_t N>
+    struct IsSmallSquare : std::integral_constant<bool, (IsSmallSize<M,N>::value && M == N && M >= 2)> {};
+
+// The kernels rely on their loops over the entries being unrolled, leaving straight-line code with every index a constant.
+#if defined(__clang__)
+#define LINEAR_SMALL_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__)
+#define LINEAR_SMALL_UNROLL _Pragma("GCC unroll 4")
+#else
+#define LINEAR_SMALL_UNROLL
+#endif
+
+    /**
+     * Offset of entry (r,c) in the array of a fixed-size MxN matrix, which has no padding.
+     */
+    template <size_t M, size_t N, bool ColMajor>
+    constexpr size_t SmallIndex(size_t r, size_t c) {
+        return (ColMajor ? c*M+r : r*N+c);
+    }
+
+    /**
+     * c = a*b for an MxK array a and a KxN array b, in the arithmetic of the entries of c.
+     */
+    template <size_t M, size_t K, size_t N, bool CA, bool CB, bool CC, typename SA, typename SB, typename SC>
+    inline void SmallMultiply(const SA * a, const SB * b, SC * c) {
+        LINEAR_SMALL_UNROLL
+        for (size_t i = 0; i < M; ++i) {
+            LINEAR_SMALL_UNROLL
+            for (size_t j = 0; j < N; ++j) {
+                SC sum = SC(a[SmallIndex<M,K,CA>(i,0)]*b[SmallIndex<K,N,CB>(0,j)]);
+                LINEAR_SMALL_UNROLL
+                for (size_t p = 1; p < K; ++p)
+                    sum += a[SmallIndex<M,K,CA>(i,p)]*b[SmallIndex<K,N,CB>(p,j)];
+                c[SmallIndex<M,N,CC>(i,j)] = sum;
+            }
+        }
+    }
+
+    /**
+     * b = a^T (or a^*, if Conj is true) for an MxN array a, b and a sharing their storage order.
+     */
+    template <size_t M, size_t N, bool ColMajor, bool Conj = false, typename S>
+    inline void SmallTranspose(const S * a, S * b) {
+        LINEAR_SMALL_UNROLL
+        for (size_t i = 0; i < M; ++i) {
+            LINEAR_SMALL_UNROLL
+            for (size_t j = 0; j < N; ++j) {
+                const S& x = a[SmallIndex<M,N,ColMajor>(i,j)];
+                b[SmallIndex<N,M,ColMajor>(j,i)] = (Conj ? Conjugate(x) : x);
+            }
+        }
+    }
+
+    /**
+     * Closed-form determinant of an NxN array, N from 1 to 4, and adjugate, N from 2 to 4. Adjugate() also returns the
+     * determinant, which it gets from the same products.
+     */
+    template <size_t N, bool ColMajor>
+    struct SmallSquare;
+
+    template <bool ColMajor>
+    struct SmallSquare<1,ColMajor> {
+        template <typename S>
+        static S Determinant(const S * a) {
+            return a[0];
+        }
+    };
+
+    template <bool ColMajor>
+    struct SmallSquare<2,ColMajor> {
+        template <typename S>
+        static S Determinant(const S * a) {
+            return a[0]*a[3] - a[1]*a[2];
+        }
+        template <typename S>
+        static S Adjugate(const S * a, S * adj) {
+            // The adjugate of a 2x2 matrix has the same form in either storage order.
+            adj[0] = a[3];
+            adj[1] = -a[1];
+            adj[2] = -a[2];
+            adj[3] = a[0];
+            return Determinant(a);
+        }
+    };
+
+    template <bool ColMajor>
+    struct SmallSquare<3,ColMajor> {
+        static constexpr size_t I(size_t r, size_t c) { return SmallIndex<3,3,ColMajor>(r,c); }
+
+        template <typename S>
+        static S Determinant(const S * a) {
+            return a[I(0,0)]*(a[I(1,1)]*a[I(2,2)] - a[I(1,2)]*a[I(2,1)])
+                 - a[I(0,1)]*(a[I(1,0)]*a[I(2,2)] - a[I(1,2)]*a[I(2,0)])
+                 + a[I(0,2)]*(a[I(1,0)]*a[I(2,1)] - a[I(1,1)]*a[I(2,0)]);
+        }
+        template <typename S>
+        static S Adjugate(const S * a, S * adj) {
+            adj[I(0,0)] = a[I(1,1)]*a[I(2,2)] - a[I(1,2)]*a[I(2,1)];
+            adj[I(1,0)] = a[I(1,2)]*a[I(2,0)] - a[I(1,0)]*a[I(2,2)];
+            adj[I(2,0)] = a[I(1,0)]*a[I(2,1)] - a[I(1,1)]*a[I(2,0)];
+            adj[I(0,1)] = a[I(0,2)]*a[I(2,1)] - a[I(0,1)]*a[I(2,2)];
+            adj[I(1,1)] = a[I(0,0)]*a[I(2,2)] - a[I(0,2)]*a[I(2,0)];
+            adj[I(2,1)] = a[I(0,1)]*a[I(2,0)] - a[I(0,0)]*a[I(2,1)];
+            adj[I(0,2)] = a[I(0,1)]*a[I(1,2)] - a[I(0,2)]*a[I(1,1)];
+            adj[I(1,2)] = a[I(0,2)]*a[I(1,0)] - a[I(0,0)]*a[I(1,2)];
+            adj[I(2,2)] = a[I(0,0)]*a[I(1,1)] - a[I(0,1)]*a[I(1,0)];
+            return a[I(0,0)]*adj[I(0,0)] + a[I(0,1)]*adj[I(1,0)] + a[I(0,2)]*adj[I(2,0)];
+        }
+    };
+
+    template <bool ColMajor>
+    struct SmallSquare<4,ColMajor> {
+        static constexpr size_t I(size_t r, size_t c) { return SmallIndex<4,4,ColMajor>(r,c); }
+
+        // The 2x2 minors of the top two rows (s) and of the bottom two rows (c), from which the determinant and every
+        // cofactor are built.
+        template <typename S>
+        static void Minors(const S * a, S * s, S * c) {
+            s[0] = a[I(0,0)]*a[I(1,1)] - a[I(1,0)]*a[I(0,1)];
+            s[1] = a[I(0,0)]*a[I(1,2)] - a[I(1,0)]*a[I(0,2)];
+            s[2] = a[I(0,0)]*a[I(1,3)] - a[I(1,0)]*a[I(0,3)];
+            s[3] = a[I(0,1)]*a[I(1,2)] - a[I(1,1)]*a[I(0,2)];
+            s[4] = a[I(0,1)]*a[I(1,3)] - a[I(1,1)]*a[I(0,3)];
+            s[5] = a[I(0,2)]*a[I(1,3)] - a[I(1,2)]*a[I(0,3)];
+            c[0] = a[I(2,0)]*a[I(3,1)] - a[I(3,0)]*a[I(2,1)];
+            c[1] = a[I(2,0)]*a[I(3,2)] - a[I(3,0)]*a[I(2,2)];
+            c[2] = a[I(2,0)]*a[I(3,3)] - a[I(3,0)]*a[I(2,3)];
+            c[3] = a[I(2,1)]*a[I(3,2)] - a[I(3,1)]*a[I(2,2)];
+            c[4] = a[I(2,1)]*a[I(3,3)] - a[I(3,1)]*a[I(2,3)];
+            c[5] = a[I(2,2)]*a[I(3,3)] - a[I(3,2)]*a[I(2,3)];
+        }
+        template <typename S>
+        static S Determinant(const S * a) {
+            S s[6], c[6];
+            Minors(a, s, c);
+            return s[0]*c[5] - s[1]*c[4] + s[2]*c[3] + s[3]*c[2] - s[4]*c[1] + s[5]*c[0];
+        }
+        template <typename S>
+        static S Adjugate(const S * a, S * adj) {
+            S s[6], c[6];
+            Minors(a, s, c);
+            adj[I(0,0)] =  a[I(1,1)]*c[5] - a[I(1,2)]*c[4] + a[I(1,3)]*c[3];
+            adj[I(0,1)] = -a[I(0,1)]*c[5] + a[I(0,2)]*c[4] - a[I(0,3)]*c[3];
+            adj[I(0,2)] =  a[I(3,1)]*s[5] - a[I(3,2)]*s[4] + a[I(3,3)]*s[3];
+            adj[I(0,3)] = -a[I(2,1)]*s[5] + a[I(2,2)]*s[4] - a[I(2,3)]*s[3];
+            adj[I(1,0)] = -a[I(1,0)]*c[5] + a[I(1,2)]*c[2] - a[I(1,3)]*c[1];
+            adj[I(1,1)] =  a[I(0,0)]*c[5] - a[I(0,2)]*c[2] + a[I(0,3)]*c[1];
+            adj[I(1,2)] = -a[I(3,0)]*s[5] + a[I(3,2)]*s[2] - a[I(3,3)]*s[1];
+            adj[I(1,3)] =  a[I(2,0)]*s[5] - a[I(2,2)]*s[2] + a[I(2,3)]*s[1];
+            adj[I(2,0)] =  a[I(1,0)]*c[4] - a[I(1,1)]*c[2] + a[I(1,3)]*c[0];
+            adj[I(2,1)] = -a[I(0,0)]*c[4] + a[I(0,1)]*c[2] - a[I(0,3)]*c[0];
+            adj[I(2,2)] =  a[I(3,0)]*s[4] - a[I(3,1)]*s[2] + a[I(3,3)]*s[0];
+            adj[I(2,3)] = -a[I(2,0)]*s[4] + a[I(2,1)]*s[2] - a[I(2,3)]*s[0];
+            adj[I(3,0)] = -a[I(1,0)]*c[3] + a[I(1,1)]*c[1] - a[I(1,2)]*c[0];
+            adj[I(3,1)] =  a[I(0,0)]*c[3] - a[I(0,1)]*c[1] + a[I(0,2)]*c[0];
+            adj[I(3,2)] = -a[I(3,0)]*s[3] + a[I(3,1)]*s[1] - a[I(3,2)]*s[0];
+            adj[I(3,3)] =  a[I(2,0)]*s[3] - a[I(2,1)]*s[1] + a[I(2,2)]*s[0];
+            return s[0]*c[5] - s[1]*c[4] + s[2]*c[3] + s[3]*c[2] - s[4]*c[1] + s[5]*c[0];
+        }
+    };
+#undef LINEAR_SMALL_UNROLL
+    /// \endcond
+}
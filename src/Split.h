@@ -0,0 +1,500 @@
+#pragma once
+#include <cmath>
+#include <type_traits>
+#include "Complex.h"
+#include "Storage.h"
+#include "Expression.h"
+#include "Matrix.h"
+#include "Vector.h"
+#include "Functions.h"
+#include "Types.h"
+
+namespace Linear {
+    template <typename T, size_t M, size_t N, unsigned int Flags>
+    class SplitMatrix;
+
+    /// \cond DO_NOT_DOCUMENT
+    template <typename T, size_t M, size_t N, unsigned int F>
+    struct ExpressionTraits<SplitMatrix<T,M,N,F>> {
+        typedef T Real;
+        static const size_t Rows = M;
+        static const size_t Columns = N;
+        static const unsigned int Flags = F & ~RealStorage;
+        static const bool StoresEntries = true;
+        static const bool MixedLayout = false;
+        typedef const SplitMatrix<T,M,N,F>& Nested;
+    };
+    /// \endcond
+
+    /**
+     * Complex matrix stored in split layout: the real parts of all entries form one contiguous array (plane) and the
+     * imaginary parts another, instead of interleaving them as Complex<T>{Re, Im}. Arithmetic on the planes needs no
+     * shuffles, so the kernels below (products, Dot, Conjugate, Abs and the entrywise functions) run on full-width vectors.
+     *
+     * A SplitMatrix is a MatrixExpression: it can be printed, compared, combined with + and - and passed to any function
+     * of Linear, which evaluates it to an interleaved Matrix first. Converting either way is a single pass over the entries:
+     *
+     *     MatrixXf A = ...;
+     *     SplitMatrix<float,Dynamic,Dynamic> S = A;   // Interleaved to split.
+     *     S = S*S;                                     // Split product.
+     *     MatrixXf B = S;                              // Split to interleaved.
+     *
+     * Entries are read with operator() and written with Set(), since there is no Complex<T> in memory to reference.
+     * @param T Type of the real and imaginary parts of each entry.
+     * @param M Number of rows. Use Dynamic to allow this value to change over time.
+     * @param N Number of columns. Use Dynamic to allow this value to change over time.
+     * @param Flags Whether the planes are row major or column major (default = row major).
+     */
+    template <typename T, size_t M, size_t N, unsigned int Flags = 0>
+    class SplitMatrix : public MatrixExpression<SplitMatrix<T,M,N,Flags>> {
+    public:
+        typedef Complex<T> Scalar;
+
+        /**
+         * Constructor.
+         * Creates the M-by-N zero matrix. If M or N are set to Dynamic, a 0x0 matrix will be created.
+         */
+        SplitMatrix() {
+            Fill(T(0), T(0));
+        }
+        /**
+         * Constructor.
+         * Creates the M-by-N matrix \f$A\f$ where \f$a_{ij}=z\f$ for all \f$i,j\f$. If M is set to Dynamic, it will be set to
+         * nrows. If N is set to Dynamic, it will be set to ncols. Otherwise, the nrows and ncols parameters are ignored.
+         * @param nrows Size to set M if it is set to Dynamic.
+         * @param ncols Size to set N if it is set to Dynamic.
+         * @param z Complex number (default = 0)
+         */
+        SplitMatrix(size_t nrows, size_t ncols, const Complex<T>& z = Complex<T>()) {
+            Allocate((M == Dynamic ? nrows : M), (N == Dynamic ? ncols : N));
+            Fill(z.Re, z.Im);
+        }
+        /**
+         * Constructor.
+         * Splits the entries of the expression e (e.g. a Matrix, or A+B) into the two planes. If M or N is Dynamic it is
+         * taken from e. Otherwise, if the sizes differ, an exception is raised.
+         * @param e Matrix expression
+         */
+        template <typename E>
+        SplitMatrix(const MatrixExpression<E>& e) {
+            Allocate((M == Dynamic ? e.NumRows() : M), (N == Dynamic ? e.NumColumns() : N));
+            if (NumRows() != e.NumRows() || NumColumns() != e.NumColumns())
+                throw "Cannot assign matrix to a matrix of different size.";
+            Assign(e.Derived());
+        }
+        SplitMatrix(const SplitMatrix& other) = default;
+        SplitMatrix(SplitMatrix&& other) = default;
+
+        /**
+         * @return Number of rows
+         */
+        size_t NumRows() const { return this->re.NumRows(); }
+        /**
+         * @return Number of columns
+         */
+        size_t NumColumns() const { return this->re.NumColumns(); }
+        /**
+         * @return Number of entries (Identical to NumRows()*NumColumns())
+         */
+        size_t NumEntries() const { return NumRows()*NumColumns(); }
+        /**
+         * @return Pointer to the plane of real parts, in row major order unless Flags contains ColumnMajor.
+         */
+        T * RealData() { return this->re.Data(); }
+        const T * RealData() const { return this->re.Data(); }
+        /**
+         * @return Pointer to the plane of imaginary parts, laid out like RealData().
+         */
+        T * ImagData() { return this->im.Data(); }
+        const T * ImagData() const { return this->im.Data(); }
+
+        /**
+         * Returns the entry in row r and column c. If r or c is out of range, an exception is thrown.
+         * @param r Row index
+         * @param c Column index
+         * @return Complex number
+         */
+        Complex<T> operator() (size_t r, size_t c) const {
+            if (LINEAR_BOUNDS_CHECK && (r >= NumRows() || c >= NumColumns()))
+                throw "Cannot access matrix. Row and column out of range.";
+            return At(r, c);
+        }
+        /**
+         * Same as operator()(r,c), but the indices are never checked.
+         * @param r Row index
+         * @param c Column index
+         * @return Complex number
+         */
+        Complex<T> At(size_t r, size_t c) const {
+            size_t i = Index(r, c);
+            return Complex<T>(this->re.Data()[i], this->im.Data()[i]);
+        }
+        /**
+         * Sets the entry in row r and column c to z. If r or c is out of range, an exception is thrown.
+         * @param r Row index
+         * @param c Column index
+         * @param z Complex number
+         */
+        void Set(size_t r, size_t c, const Complex<T>& z) {
+            if (r >= NumRows() || c >= NumColumns())
+                throw "Cannot access matrix. Row and column out of range.";
+            size_t i = Index(r, c);
+            this->re.Data()[i] = z.Re;
+            this->im.Data()[i] = z.Im;
+        }
+
+        // Assignments
+        SplitMatrix& operator=(const SplitMatrix& other) = default;
+        SplitMatrix& operator=(SplitMatrix&& other) = default;
+        /**
+         * Set the matrix to the expression e (e.g. a Matrix, or A+B). If M or N are Dynamic, they are set to the size of e.
+         * Otherwise, if the sizes differ an exception is raised.
+         * @param e Matrix expression
+         * @return This matrix
+         */
+        template <typename E>
+        SplitMatrix& operator=(const MatrixExpression<E>& e) {
+            if (NumRows() != e.NumRows() || NumColumns() != e.NumColumns()) {
+                // e may read this matrix, so build the result on the side.
+                SplitMatrix result(e);
+                return *this = std::move(result);
+            }
+            // Every expression reads entry (r,c) of its operands to compute entry (r,c), so writing in place is safe.
+            Assign(e.Derived());
+            return *this;
+        }
+        /**
+         * Adds other entrywise. If the sizes differ an exception is raised.
+         * @param other MxN split matrix
+         * @return This matrix
+         */
+        template <size_t P, size_t Q, unsigned int Flags2>
+        SplitMatrix& operator+=(const SplitMatrix<T,P,Q,Flags2>& other) {
+            if (NumRows() != other.NumRows() || NumColumns() != other.NumColumns())
+                throw "Cannot add two matrices of differing sizes.";
+            if ((Flags & ColumnMajor) != (Flags2 & ColumnMajor))
+                return *this = *this + other;
+            T * xr = RealData(), * xi = ImagData();
+            const T * yr = other.RealData(), * yi = other.ImagData();
+            for (size_t i = 0; i < NumEntries(); ++i) {
+                xr[i] += yr[i];
+                xi[i] += yi[i];
+            }
+            return *this;
+        }
+        /**
+         * Subtracts other entrywise. If the sizes differ an exception is raised.
+         * @param other MxN split matrix
+         * @return This matrix
+         */
+        template <size_t P, size_t Q, unsigned int Flags2>
+        SplitMatrix& operator-=(const SplitMatrix<T,P,Q,Flags2>& other) {
+            if (NumRows() != other.NumRows() || NumColumns() != other.NumColumns())
+                throw "Cannot subtract two matrices of differing sizes.";
+            if ((Flags & ColumnMajor) != (Flags2 & ColumnMajor))
+                return *this = *this - other;
+            T * xr = RealData(), * xi = ImagData();
+            const T * yr = other.RealData(), * yi = other.ImagData();
+            for (size_t i = 0; i < NumEntries(); ++i) {
+                xr[i] -= yr[i];
+                xi[i] -= yi[i];
+            }
+            return *this;
+        }
+        template <typename E>
+        SplitMatrix& operator+=(const MatrixExpression<E>& e) {
+            return *this = *this + e.Derived();
+        }
+        template <typename E>
+        SplitMatrix& operator-=(const MatrixExpression<E>& e) {
+            return *this = *this - e.Derived();
+        }
+        SplitMatrix& operator*=(T x) {
+            T * xr = RealData(), * xi = ImagData();
+            for (size_t i = 0; i < NumEntries(); ++i) {
+                xr[i] *= x;
+                xi[i] *= x;
+            }
+            return *this;
+        }
+        SplitMatrix& operator*=(const Complex<T>& s) {
+            T * xr = RealData(), * xi = ImagData();
+            for (size_t i = 0; i < NumEntries(); ++i) {
+                T a = xr[i], b = xi[i];
+                xr[i] = a*s.Re - b*s.Im;
+                xi[i] = a*s.Im + b*s.Re;
+            }
+            return *this;
+        }
+        SplitMatrix& operator/=(T x) {
+            return *this *= T(1)/x;
+        }
+        SplitMatrix& operator/=(const Complex<T>& s) {
+            return *this *= Complex<T>(T(1))/s;
+        }
+
+        /**
+         * Exchanges the contents of the matrix with other.
+         * @param other MxN split matrix
+         */
+        void Swap(SplitMatrix& other) noexcept {
+            this->re.Swap(other.re);
+            this->im.Swap(other.im);
+        }
+
+        /// \cond DO_NOT_DOCUMENT
+        // The planes are only reachable through split matrices, so they never overlap the memory of another expression.
+        template <typename D>
+        bool ConflictsWith(const D&, bool) const {
+            return false;
+        }
+        /// \endcond
+    private:
+        size_t Index(size_t r, size_t c) const {
+            return ((Flags & ColumnMajor) ? c*NumRows()+r : r*NumColumns()+c);
+        }
+        void Allocate(size_t rows, size_t cols) {
+            this->re.Allocate(rows, cols);
+            this->im.Allocate(rows, cols);
+        }
+        void Fill(T x, T y) {
+            std::fill(RealData(), RealData()+NumEntries(), x);
+            std::fill(ImagData(), ImagData()+NumEntries(), y);
+        }
+        template <typename E>
+        void Assign(const E& e) {
+            T * xr = RealData(), * xi = ImagData();
+            for (size_t r = 0; r < NumRows(); ++r) {
+                for (size_t c = 0; c < NumColumns(); ++c) {
+                    Complex<T> z = e.At(r,c);
+                    xr[Index(r,c)] = z.Re;
+                    xi[Index(r,c)] = z.Im;
+                }
+            }
+        }
+        template <size_t P, size_t Q, unsigned int Flags2>
+        void Assign(const Matrix<T,P,Q,Flags2>& A) {
+            if ((Flags2 & (RealStorage | ColumnMajor)) != (Flags & ColumnMajor) || !A.IsContiguous())
+                return Assign<Matrix<T,P,Q,Flags2>>(A);
+            // Same layout: deinterleave in one sweep.
+            const Complex<T> * data = reinterpret_cast<const Complex<T>*>(A.Data());
+            T * xr = RealData(), * xi = ImagData();
+            for (size_t i = 0; i < NumEntries(); ++i) {
+                xr[i] = data[i].Re;
+                xi[i] = data[i].Im;
+            }
+        }
+
+        DenseStorage<T,M,N> re, im;
+    };
+
+    /// \cond DO_NOT_DOCUMENT
+    /**
+     * C += A*B on split planes. Entry (r,c) of each operand lives at r*rowStride+c*columnStride. The innermost loop runs
+     * along the contiguous dimension of C, so it is a plain multiply-add over two pairs of arrays.
+     */
+    template <typename T>
+    void SplitMultiplyAdd(size_t m, size_t n, size_t k,
+                          const T * ar, const T * ai, size_t ars, size_t acs,
+                          const T * br, const T * bi, size_t brs, size_t bcs,
+                          T * cr, T * ci, size_t crs, size_t ccs) {
+        if (ccs == 1) {
+            for (size_t r = 0; r < m; ++r) {
+                T * cre = cr + r*crs, * cim = ci + r*crs;
+                for (size_t p = 0; p < k; ++p) {
+                    T xr = ar[r*ars+p*acs], xi = ai[r*ars+p*acs];
+                    const T * bre = br + p*brs, * bim = bi + p*brs;
+                    for (size_t c = 0; c < n; ++c) {
+                        cre[c] += xr*bre[c*bcs] - xi*bim[c*bcs];
+                        cim[c] += xr*bim[c*bcs] + xi*bre[c*bcs];
+                    }
+                }
+            }
+        }
+        else {
+            for (size_t c = 0; c < n; ++c) {
+                T * cre = cr + c*ccs, * cim = ci + c*ccs;
+                for (size_t p = 0; p < k; ++p) {
+                    T yr = br[p*brs+c*bcs], yi = bi[p*brs+c*bcs];
+                    const T * are = ar + p*acs, * aim = ai + p*acs;
+                    for (size_t r = 0; r < m; ++r) {
+                        cre[r*crs] += are[r*ars]*yr - aim[r*ars]*yi;
+                        cim[r*crs] += are[r*ars]*yi + aim[r*ars]*yr;
+                    }
+                }
+            }
+        }
+    }
+    /// \endcond
+
+    /**
+     * Computes the MxQ split matrix \f$C=AB\f$ in split arithmetic. If \f$N\ne P\f$ an exception is raised.
+     * @param A MxN split matrix
+     * @param B PxQ split matrix
+     * @return MxQ split matrix
+     */
+    template <typename T, size_t M, size_t N, unsigned int Flags, size_t P, size_t Q, unsigned int Flags2>
+    SplitMatrix<T,M,Q,Flags> operator*(const SplitMatrix<T,M,N,Flags>& A, const SplitMatrix<T,P,Q,Flags2>& B) {
+        if (A.NumColumns() != B.NumRows())
+            throw "Cannot muliply two matrices due to size mismatch.";
+        SplitMatrix<T,M,Q,Flags> C(A.NumRows(), B.NumColumns());
+        bool aColumnMajor = (Flags & ColumnMajor) != 0, bColumnMajor = (Flags2 & ColumnMajor) != 0;
+        SplitMultiplyAdd(A.NumRows(), B.NumColumns(), A.NumColumns(),
+                         A.RealData(), A.ImagData(), (aColumnMajor ? 1 : A.NumColumns()), (aColumnMajor ? A.NumRows() : 1),
+                         B.RealData(), B.ImagData(), (bColumnMajor ? 1 : B.NumColumns()), (bColumnMajor ? B.NumRows() : 1),
+                         C.RealData(), C.ImagData(), (aColumnMajor ? 1 : C.NumColumns()), (aColumnMajor ? C.NumRows() : 1));
+        return C;
+    }
+
+    /**
+     * Computes the dot product \f$\sum_{i=0}^{N-1}\overline{a_i}b_i\f$ of two split vectors. If either a or b is not a vector,
+     * or they have differing sizes, an exception is thrown.
+     * @param a Row/column split vector
+     * @param b Row/column split vector
+     * @return Complex number
+     */
+    template <typename T, size_t M, size_t N, unsigned int Flags, size_t P, size_t Q, unsigned int Flags2>
+    Complex<T> Dot(const SplitMatrix<T,M,N,Flags>& a, const SplitMatrix<T,P,Q,Flags2>& b) {
+        if ((a.NumRows() != 1 && a.NumColumns() != 1) || (b.NumRows() != 1 && b.NumColumns() != 1))
+            throw "Dot product is only defined for vectors.";
+        if (a.NumEntries() != b.NumEntries())
+            throw "Cannot take the dot product of two different sized vectors.";
+        // A vector's planes are in order whatever the layout.
+        const T * ar = a.RealData(), * ai = a.ImagData(), * br = b.RealData(), * bi = b.ImagData();
+        T re = T(0), im = T(0);
+        for (size_t i = 0; i < a.NumEntries(); ++i) {
+            re += ar[i]*br[i] + ai[i]*bi[i];
+            im += ar[i]*bi[i] - ai[i]*br[i];
+        }
+        return Complex<T>(re, im);
+    }
+
+    /**
+     * Computes the split matrix \f$C\f$ defined by \f$c_{ij}=a_{ij}b_{ij}\f$. If the sizes differ an exception is thrown.
+     * @param A MxN split matrix
+     * @param B MxN split matrix
+     * @return MxN split matrix
+     */
+    template <typename T, size_t M, size_t N, unsigned int Flags, size_t P, size_t Q, unsigned int Flags2>
+    SplitMatrix<T,M,N,Flags> EntrywiseProduct(SplitMatrix<T,M,N,Flags> A, const SplitMatrix<T,P,Q,Flags2>& B) {
+        if (A.NumRows() != B.NumRows() || A.NumColumns() != B.NumColumns())
+            throw "Cannot perform entrywise product when matrices have varying sizes.";
+        if ((Flags & ColumnMajor) != (Flags2 & ColumnMajor))
+            return EntrywiseProduct(A, SplitMatrix<T,P,Q,Flags>(B));
+        T * xr = A.RealData(), * xi = A.ImagData();
+        const T * yr = B.RealData(), * yi = B.ImagData();
+        for (size_t i = 0; i < A.NumEntries(); ++i) {
+            T a = xr[i], b = xi[i];
+            xr[i] = a*yr[i] - b*yi[i];
+            xi[i] = a*yi[i] + b*yr[i];
+        }
+        return A;
+    }
+
+    /**
+     * Computes the split matrix \f$B\f$ defined by \f$b_{ij}=\overline{a_{ij}}\f$.
+     * @param A MxN split matrix
+     * @return MxN split matrix
+     */
+    template <typename T, size_t M, size_t N, unsigned int Flags>
+    SplitMatrix<T,M,N,Flags> Conjugate(SplitMatrix<T,M,N,Flags> A) {
+        T * xi = A.ImagData();
+        for (size_t i = 0; i < A.NumEntries(); ++i)
+            xi[i] = -xi[i];
+        return A;
+    }
+    /**
+     * Computes the split matrix \f$B\f$ defined by \f$b_{ij}=|a_{ij}|\f$.
+     * @param A MxN split matrix
+     * @return MxN split matrix
+     */
+    template <typename T, size_t M, size_t N, unsigned int Flags>
+    SplitMatrix<T,M,N,Flags> Abs(SplitMatrix<T,M,N,Flags> A) {
+        T * xr = A.RealData(), * xi = A.ImagData();
+        for (size_t i = 0; i < A.NumEntries(); ++i) {
+            xr[i] = std::sqrt(xr[i]*xr[i] + xi[i]*xi[i]);
+            xi[i] = T(0);
+        }
+        return A;
+    }
+    /**
+     * Computes the split matrix \f$B\f$ defined by \f$b_{ij}=arg(a_{ij})\f$.
+     * @param A MxN split matrix
+     * @return MxN split matrix
+     */
+    template <typename T, size_t M, size_t N, unsigned int Flags>
+    SplitMatrix<T,M,N,Flags> Arg(SplitMatrix<T,M,N,Flags> A) {
+        T * xr = A.RealData(), * xi = A.ImagData();
+        for (size_t i = 0; i < A.NumEntries(); ++i) {
+            xr[i] = std::atan2(xi[i], xr[i]);
+            xi[i] = T(0);
+        }
+        return A;
+    }
+    /**
+     * If A is not square, computes the split matrix \f$B\f$ defined by \f$b_{ij}=e^{a_{ij}}\f$ on the planes. Otherwise it
+     * computes the matrix exponential, see Exp(Matrix<T,M,N,Flags>).
+     * @param A MxN split matrix
+     * @return MxN split matrix
+     */
+    template <typename T, size_t M, size_t N, unsigned int Flags>
+    SplitMatrix<T,M,N,Flags> Exp(SplitMatrix<T,M,N,Flags> A) {
+        if (A.NumRows() == A.NumColumns())
+            return SplitMatrix<T,M,N,Flags>(Exp(A.Eval()));
+        T * xr = A.RealData(), * xi = A.ImagData();
+        for (size_t i = 0; i < A.NumEntries(); ++i) {
+            T scale = std::exp(xr[i]);
+            xr[i] = scale*std::cos(xi[i]);
+            xi[i] = scale*std::sin(xi[i]);
+        }
+        return A;
+    }
+
+    /// \cond DO_NOT_DOCUMENT
+    /**
+     * Defines the entrywise function Name on split matrices by applying Name(Complex<T>) to every entry of the planes.
+     */
+    #define LINEAR_SPLIT_ENTRYWISE(Name) \
+    template <typename T, size_t M, size_t N, unsigned int Flags> \
+    SplitMatrix<T,M,N,Flags> Name(SplitMatrix<T,M,N,Flags> A) { \
+        T * xr = A.RealData(), * xi = A.ImagData(); \
+        for (size_t i = 0; i < A.NumEntries(); ++i) { \
+            Complex<T> z = Name(Complex<T>(xr[i], xi[i])); \
+            xr[i] = z.Re; \
+            xi[i] = z.Im; \
+        } \
+        return A; \
+    }
+    /// \endcond
+
+    LINEAR_SPLIT_ENTRYWISE(Sign)
+    LINEAR_SPLIT_ENTRYWISE(Sqrt)
+    LINEAR_SPLIT_ENTRYWISE(Log)
+    LINEAR_SPLIT_ENTRYWISE(Sin)
+    LINEAR_SPLIT_ENTRYWISE(Cos)
+    LINEAR_SPLIT_ENTRYWISE(Tan)
+    LINEAR_SPLIT_ENTRYWISE(Csc)
+    LINEAR_SPLIT_ENTRYWISE(Sec)
+    LINEAR_SPLIT_ENTRYWISE(Cot)
+    LINEAR_SPLIT_ENTRYWISE(ASin)
+    LINEAR_SPLIT_ENTRYWISE(ACos)
+    LINEAR_SPLIT_ENTRYWISE(ATan)
+    LINEAR_SPLIT_ENTRYWISE(ACsc)
+    LINEAR_SPLIT_ENTRYWISE(ASec)
+    LINEAR_SPLIT_ENTRYWISE(ACot)
+    LINEAR_SPLIT_ENTRYWISE(Sinh)
+    LINEAR_SPLIT_ENTRYWISE(Cosh)
+    LINEAR_SPLIT_ENTRYWISE(Tanh)
+    LINEAR_SPLIT_ENTRYWISE(Csch)
+    LINEAR_SPLIT_ENTRYWISE(Sech)
+    LINEAR_SPLIT_ENTRYWISE(Coth)
+    LINEAR_SPLIT_ENTRYWISE(ASinh)
+    LINEAR_SPLIT_ENTRYWISE(ACosh)
+    LINEAR_SPLIT_ENTRYWISE(ATanh)
+    LINEAR_SPLIT_ENTRYWISE(ACsch)
+    LINEAR_SPLIT_ENTRYWISE(ASech)
+    LINEAR_SPLIT_ENTRYWISE(ACoth)
+
+    using SplitMatrixXf = SplitMatrix<float,Dynamic,Dynamic>;
+    using SplitMatrixXd = SplitMatrix<double,Dynamic,Dynamic>;
+}
@@ -0,0 +1,716 @@
+#pragma once
+#include <cstddef> // For size_t
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+#include <atomic>
+#include <vector>
+#include "Complex.h"
+#include "Global.h"
+#include "Memory.h"
+
+/**
+ * Alignment (in bytes) of the inline storage of statically sized matrices. Defaults to the widest SIMD register enabled
+ * at compile time. Over-aligned types are only safe inside std::vector and new expressions with aligned new (C++17 or
+ * -faligned-new), so without it the alignment is capped at 16 bytes. Define LINEAR_ALIGNMENT before including Linear
+ * to override.
+ */
+#ifndef LINEAR_ALIGNMENT
+#if defined(__cpp_aligned_new) && defined(__AVX512F__)
+#define LINEAR_ALIGNMENT 64
+#elif defined(__cpp_aligned_new) && defined(__AVX__)
+#define LINEAR_ALIGNMENT 32
+#else
+#define LINEAR_ALIGNMENT 16
+#endif
+#endif
+
+/**
+ * Number of entries a dynamically sized matrix keeps inside the object before it allocates from its MemoryResource. Small
+ * dynamic matrices (2x2 blocks, short vectors) then never touch the heap, at the cost of a larger matrix object. Define
+ * LINEAR_INLINE_ENTRIES before including Linear to override, 0 disables it.
+ */
+#ifndef LINEAR_INLINE_ENTRIES
+#define LINEAR_INLINE_ENTRIES 16
+#endif
+
+/**
+ * Side (in entries) of the square tiles in which loops walk a matrix when the matrices they read and write are stored in
+ * different orders, e.g. when copying a row-major matrix into a column-major one or transposing. Define LINEAR_TILE before
+ * including Linear to override.
+ */
+#ifndef LINEAR_TILE
+#define LINEAR_TILE 8
+#endif
+
+namespace Linear {
+    const unsigned int Dynamic = 0;
+    const unsigned int RowMajor = 0x0000;
+    const unsigned int ColumnMajor = 0x0001;
+    const unsigned int RealStorage = 0x0002;
+    const unsigned int CopyOnWrite = 0x0004;
+
+    /// \cond DO_NOT_DOCUMENT
+    /**
+     * Flags of the result of combining a matrix with flags1 and a matrix with flags2. The storage order is taken from flags1,
+     * and the result only uses real storage if both operands do.
+     */
+    constexpr unsigned int PromoteFlags(unsigned int flags1, unsigned int flags2) {
+        return flags1 & ~(RealStorage & ~flags2);
+    }
+
+    /**
+     * Type used to store each entry of a matrix.
+     * @param T Type of the real and imaginary parts.
+     * @param Real Whether the matrix uses real storage.
+     */
+    template <typename T, bool Real>
+    struct ScalarTraits {
+        typedef Complex<T> Scalar;
+        static Complex<T> FromComplex(const Complex<T>& z) { return z; }
+    };
+
+    template <typename T>
+    struct ScalarTraits<T,true> {
+        typedef T Scalar;
+        static T FromComplex(const Complex<T>& z) {
+            // Imaginary parts within Tol are rounding errors from complex arithmetic on real data.
+            if (Abs(z.Im) > T(Tol)*std::max(T(1), Abs(z.Re)))
+                throw "Cannot store a complex number in a real matrix.";
+            return z.Re;
+        }
+    };
+
+    /**
+     * Smallest leading dimension of at least inner entries that starts every line (row, or column if column major) on a
+     * LINEAR_HEAP_ALIGNMENT boundary and does not put the lines a multiple of 512 bytes apart. Lines that far apart map to a
+     * handful of cache sets, so walking down a column of a matrix with a power-of-two number of columns keeps evicting itself.
+     * @param inner Number of entries in each line
+     * @return Leading dimension, in entries
+     */
+    template <typename S>
+    size_t PaddedLeadingDimension(size_t inner) {
+        if (LINEAR_HEAP_ALIGNMENT % sizeof(S) != 0)
+            return inner;
+        const size_t align = LINEAR_HEAP_ALIGNMENT / sizeof(S);
+        size_t ld = (inner + align - 1) / align * align;
+        if ((ld * sizeof(S)) % 512 == 0)
+            ld += align;
+        return ld;
+    }
+
+    /// \cond DO_NOT_DOCUMENT
+    /**
+     * Writes the transpose of the lines-by-inner array src (lines srcLd entries apart) into dst (lines dstLd entries apart),
+     * passing every entry through op. Both arrays are walked a LINEAR_TILE x LINEAR_TILE tile at a time, so neither is
+     * accessed a whole line apart from one entry to the next.
+     */
+    template <typename S, typename D, typename Op>
+    void TransposeEntries(const S * src, size_t lines, size_t inner, size_t srcLd, D * dst, size_t dstLd, Op op) {
+        for (size_t i = 0; i < lines; i += LINEAR_TILE) {
+            size_t iEnd = std::min(lines, i+LINEAR_TILE);
+            for (size_t j = 0; j < inner; j += LINEAR_TILE) {
+                size_t jEnd = std::min(inner, j+LINEAR_TILE);
+                for (size_t k = j; k < jEnd; ++k) {
+                    for (size_t l = i; l < iEnd; ++l)
+                        dst[k*dstLd+l] = op(src[l*srcLd+k]);
+                }
+            }
+        }
+    }
+    /**
+     * Transposes the n-by-n array data (lines ld entries apart) in place, swapping tiles across the diagonal.
+     */
+    template <typename S>
+    void TransposeSquareEntries(S * data, size_t n, size_t ld) {
+        for (size_t i = 0; i < n; i += LINEAR_TILE) {
+            size_t iEnd = std::min(n, i+LINEAR_TILE);
+            for (size_t l = i; l < iEnd; ++l) {
+                for (size_t k = l+1; k < iEnd; ++k)
+                    std::swap(data[l*ld+k], data[k*ld+l]);
+            }
+            for (size_t j = iEnd; j < n; j += LINEAR_TILE) {
+                size_t jEnd = std::min(n, j+LINEAR_TILE);
+                for (size_t l = i; l < iEnd; ++l) {
+                    for (size_t k = j; k < jEnd; ++k)
+                        std::swap(data[l*ld+k], data[k*ld+l]);
+                }
+            }
+        }
+    }
+    /**
+     * Turns the lines-by-inner array data (lines ld entries apart) into its inner-by-lines transpose, stored without padding
+     * in the same memory. The lines are packed first, then every cycle of the permutation is followed once, marking moved
+     * entries in a bitmap of one bit per entry.
+     */
+    template <typename S>
+    void TransposeEntriesInPlace(S * data, size_t lines, size_t inner, size_t ld) {
+        for (size_t l = 1; l < lines && ld != inner; ++l)
+            std::copy(data+l*ld, data+l*ld+inner, data+l*inner);
+        size_t count = lines*inner;
+        if (lines <= 1 || inner <= 1)
+            return;
+        // Entry p (line p/inner, position p%inner) belongs at position p/inner of line p%inner.
+        std::vector<bool> moved(count, false);
+        for (size_t start = 1; start+1 < count; ++start) {
+            if (moved[start])
+                continue;
+            S value = data[start];
+            size_t p = start;
+            do {
+                p = (p % inner)*lines + p/inner;
+                std::swap(value, data[p]);
+                moved[p] = true;
+            } while (p != start);
+        }
+    }
+    /// \endcond
+
+    /**
+     * Storage for the entries of a matrix.
+     * If both R and C are known at compile time, the entries are kept inline in the object. Otherwise (R or C is Dynamic)
+     * they are kept in an array allocated from a MemoryResource, aligned to LINEAR_HEAP_ALIGNMENT bytes, unless there are
+     * at most LINEAR_INLINE_ENTRIES of them; those fit in a buffer inside the object.
+     *
+     * The entries are stored line by line: row by row, or column by column if ColMajor. Lines start LeadingDimension()
+     * entries apart, which for dynamic storage may be more than the length of a line; the entries in between are padding.
+     * @param S Type of each entry.
+     * @param R Number of rows (0 for Dynamic).
+     * @param C Number of columns (0 for Dynamic).
+     * @param ColMajor Whether the lines are columns.
+     */
+    template <typename S, size_t R, size_t C, bool ColMajor = false, bool Static = (R != 0 && C != 0)>
+    class DenseStorage;
+
+    template <typename S, size_t R, size_t C, bool ColMajor>
+    class DenseStorage<S,R,C,ColMajor,true> {
+    public:
+        DenseStorage() {}
+        /**
+         * Inline storage does not use a memory resource, the argument is ignored.
+         */
+        explicit DenseStorage(MemoryResource *) {}
+        size_t NumRows() const { return R; }
+        size_t NumColumns() const { return C; }
+        /**
+         * Inline storage is never padded.
+         */
+        size_t LeadingDimension() const { return (ColMajor ? R : C); }
+        size_t Capacity() const { return R*C; }
+        S * Data() { return this->data; }
+        S * WritableData() { return this->data; }
+        const S * Data() const { return this->data; }
+        MemoryResource * Resource() const { return NULL; }
+        /**
+         * Statically sized storage never changes size, this is a no-op.
+         */
+        void Allocate(size_t, size_t, size_t = 0, size_t = 0) {}
+        /**
+         * Statically sized storage never changes size, this is a no-op.
+         */
+        void SetLayout(size_t, size_t, size_t) {}
+        /**
+         * Copies the entries of other, which stores the same matrix in the other order, transposing them.
+         * @param other Storage in the other order
+         */
+        void AdoptTransposed(DenseStorage<S,R,C,!ColMajor,true>& other) {
+            TransposeEntries(other.data, (ColMajor ? R : C), (ColMajor ? C : R), (ColMajor ? C : R), this->data, (ColMajor ? R : C),
+                             [](const S& x) { return x; });
+        }
+        /**
+         * Exchanges the entries with other. The entries live inline, so they have to be swapped one by one.
+         * @param other Storage to swap with
+         */
+        void Swap(DenseStorage& other) noexcept {
+            std::swap_ranges(this->data, this->data+R*C, other.data);
+        }
+    private:
+        template <typename, size_t, size_t, bool, bool> friend class DenseStorage;
+
+        alignas(LINEAR_ALIGNMENT) S data[R*C];
+    };
+
+    template <typename S, size_t R, size_t C, bool ColMajor>
+    class DenseStorage<S,R,C,ColMajor,false> {
+    public:
+        DenseStorage() : DenseStorage(GetDefaultMemoryResource()) {}
+        /**
+         * Creates empty storage that will allocate from resource.
+         */
+        explicit DenseStorage(MemoryResource * resource) {
+            this->data = NULL;
+            this->m = R;
+            this->n = C;
+            this->ld = Inner();
+            this->capacity = 0;
+            this->resource = resource;
+        }
+        /**
+         * Copies the entries (and the leading dimension, but not the spare capacity) of other, allocating from the current
+         * default resource.
+         */
+        DenseStorage(const DenseStorage& other) : DenseStorage() {
+            Allocate(other.m, other.n, other.ld);
+            std::copy(other.data, other.data+other.Used(), this->data);
+        }
+        /**
+         * Takes over other's array (and resource), leaving other empty. Inline entries are copied.
+         */
+        DenseStorage(DenseStorage&& other) noexcept {
+            this->data = NULL;
+            MoveFrom(other);
+        }
+        /**
+         * Copies the entries of other, keeping our resource. If the sizes match, our array and leading dimension are kept
+         * and the entries are copied line by line. Otherwise the layout of other is taken, reusing the array when it is
+         * large enough.
+         */
+        DenseStorage& operator=(const DenseStorage& other) {
+            if (this == &other)
+                return *this;
+            if (this->m == other.m && this->n == other.n) {
+                for (size_t l = 0; l < Lines(); ++l)
+                    std::copy(other.data+l*other.ld, other.data+l*other.ld+Inner(), this->data+l*this->ld);
+                return *this;
+            }
+            if (this->capacity < other.Used())
+                Allocate(other.m, other.n, other.ld);
+            this->m = other.m;
+            this->n = other.n;
+            this->ld = other.ld;
+            std::copy(other.data, other.data+other.Used(), this->data);
+            return *this;
+        }
+        /**
+         * Takes over other's array if both use the same resource, unless that would change our leading dimension without
+         * changing our size. Otherwise the entries are copied, so that the storage never ends up holding memory from a
+         * resource it was not created with (e.g. a Workspace).
+         */
+        DenseStorage& operator=(DenseStorage&& other) {
+            bool keepLayout = (this->m == other.m && this->n == other.n && this->ld != other.ld);
+            if (this->resource == other.resource && !keepLayout)
+                Swap(other);
+            else
+                *this = static_cast<const DenseStorage&>(other);
+            return *this;
+        }
+        ~DenseStorage() {
+            Release();
+        }
+        size_t NumRows() const { return this->m; }
+        size_t NumColumns() const { return this->n; }
+        /**
+         * @return Distance (in entries) between the starts of consecutive lines.
+         */
+        size_t LeadingDimension() const { return this->ld; }
+        /**
+         * @return Number of entries (padding included) the array has room for.
+         */
+        size_t Capacity() const { return this->capacity; }
+        S * Data() { return this->data; }
+        S * WritableData() { return this->data; }
+        const S * Data() const { return this->data; }
+        /**
+         * @return Resource the entries are allocated from.
+         */
+        MemoryResource * Resource() const { return this->resource; }
+        /**
+         * Points the storage at a fresh rows-by-cols array, releasing the previous one. The entries (and the padding) are
+         * default constructed.
+         * @param rows Number of rows
+         * @param cols Number of columns
+         * @param ld Leading dimension. Values below the length of a line (e.g. the default 0) mean no padding.
+         * @param lines Number of lines to make room for. Values below the number of lines (e.g. the default 0) mean no spare room.
+         */
+        void Allocate(size_t rows, size_t cols, size_t ld = 0, size_t lines = 0) {
+            Release();
+            this->m = rows;
+            this->n = cols;
+            this->ld = std::max(ld, Inner());
+            size_t count = std::max(lines, Lines())*this->ld;
+            if (count != 0) {
+                S * entries = (count <= InlineEntries ? Buffer()
+                               : static_cast<S*>(this->resource->Allocate(count*sizeof(S), Alignment())));
+                this->capacity = (count <= InlineEntries ? size_t(InlineEntries) : count);
+                for (size_t i = 0; i < this->capacity; ++i)
+                    new (entries+i) S();
+                this->data = entries;
+            }
+        }
+        /**
+         * Changes the size (and the leading dimension) without moving any entry. The new layout must fit: a line may not
+         * be longer than the leading dimension, and all lines have to fit in Capacity(). Entries that come into view are left
+         * as they are.
+         * @param rows Number of rows
+         * @param cols Number of columns
+         * @param ld Leading dimension
+         */
+        void SetLayout(size_t rows, size_t cols, size_t ld) {
+            this->m = rows;
+            this->n = cols;
+            this->ld = ld;
+        }
+        /**
+         * Takes over the entries of other, which stores the same matrix in the other order, transposing them in place.
+         * Padding is dropped and other is left empty. Must only be called on storage without entries.
+         * @param other Storage in the other order
+         */
+        void AdoptTransposed(DenseStorage<S,R,C,!ColMajor,false>& other) {
+            if (other.data != NULL)
+                TransposeEntriesInPlace(other.data, other.Lines(), other.Inner(), other.ld);
+            if (other.IsInline()) {
+                std::copy(other.data, other.data+other.capacity, Buffer());
+                this->data = Buffer();
+            }
+            else {
+                this->data = other.data;
+            }
+            this->m = other.m;
+            this->n = other.n;
+            this->ld = Inner();
+            this->capacity = other.capacity;
+            this->resource = other.resource;
+            other.data = NULL;
+            other.m = R;
+            other.n = C;
+            other.ld = other.Inner();
+            other.capacity = 0;
+        }
+        /**
+         * Exchanges the arrays (and sizes and resources) with other. Inline entries are copied across.
+         * @param other Storage to swap with
+         */
+        void Swap(DenseStorage& other) noexcept {
+            if (!IsInline() && !other.IsInline()) {
+                std::swap(this->data, other.data);
+                std::swap(this->m, other.m);
+                std::swap(this->n, other.n);
+                std::swap(this->ld, other.ld);
+                std::swap(this->capacity, other.capacity);
+                std::swap(this->resource, other.resource);
+                return;
+            }
+            DenseStorage temp(std::move(other));
+            other.MoveFrom(*this);
+            MoveFrom(temp);
+        }
+    private:
+        static_assert(std::is_trivially_destructible<S>::value, "Matrix entries are released without running destructors.");
+        static const size_t InlineEntries = LINEAR_INLINE_ENTRIES;
+        template <typename, size_t, size_t, bool, bool> friend class DenseStorage;
+
+        static constexpr size_t Alignment() {
+            return (LINEAR_HEAP_ALIGNMENT > alignof(S) ? LINEAR_HEAP_ALIGNMENT : alignof(S));
+        }
+        size_t Lines() const { return (ColMajor ? this->n : this->m); }
+        size_t Inner() const { return (ColMajor ? this->m : this->n); }
+        // Entries from the start of the first line to the end of the padding of the last one.
+        size_t Used() const { return Lines()*this->ld; }
+        S * Buffer() { return reinterpret_cast<S*>(this->buffer); }
+        bool IsInline() const { return this->data == reinterpret_cast<const S*>(this->buffer); }
+        /**
+         * Takes over the entries of other, which is left empty. Must only be called on storage without entries.
+         */
+        void MoveFrom(DenseStorage& other) noexcept {
+            if (other.IsInline()) {
+                std::copy(other.data, other.data+other.capacity, Buffer());
+                this->data = Buffer();
+            }
+            else {
+                this->data = other.data;
+            }
+            this->m = other.m;
+            this->n = other.n;
+            this->ld = other.ld;
+            this->capacity = other.capacity;
+            this->resource = other.resource;
+            other.data = NULL;
+            other.m = R;
+            other.n = C;
+            other.ld = other.Inner();
+            other.capacity = 0;
+        }
+        void Release() {
+            if (this->data != NULL && !IsInline())
+                this->resource->Deallocate(this->data, this->capacity*sizeof(S), Alignment());
+            this->data = NULL;
+            this->capacity = 0;
+        }
+
+        S * data;
+        size_t m, n;
+        size_t ld;
+        size_t capacity;
+        MemoryResource * resource;
+        alignas(LINEAR_ALIGNMENT > alignof(S) ? LINEAR_ALIGNMENT : alignof(S))
+        unsigned char buffer[(InlineEntries > 0 ? InlineEntries : 1)*sizeof(S)];
+    };
+
+    /**
+     * Storage for the entries of a dynamically sized matrix with the CopyOnWrite flag. Copies share one reference-counted
+     * array, as long as they allocate from the same MemoryResource, and WritableData() gives a storage its own copy of a
+     * shared array before returning it. The count is atomic, so copies may live in different threads.
+     *
+     * The non-const Data() does the same, but the pointer it returns may be kept (as references, iterators and views into
+     * a matrix are), so it also marks the array unshareable: later copies copy it, and writes through the pointer never
+     * show up in them. An unshareable array is never shared, so Data() skips the reference count from then on. The mark
+     * goes with the array and is cleared when the storage gets a new one.
+     *
+     * Entries allocated from a Workspace are never shared: the copy made by the first write could land inside a nested
+     * WorkspaceScope and be rewound while the matrix still uses it.
+     *
+     * The count sits in front of the entries, in the same allocation. Otherwise this behaves like DenseStorage.
+     * @param S Type of each entry.
+     * @param R Number of rows (0 for Dynamic).
+     * @param C Number of columns (0 for Dynamic).
+     * @param ColMajor Whether the lines are columns.
+     */
+    template <typename S, size_t R, size_t C, bool ColMajor = false>
+    class SharedStorage {
+    public:
+        SharedStorage() : SharedStorage(GetDefaultMemoryResource()) {}
+        /**
+         * Creates empty storage that will allocate from resource.
+         */
+        explicit SharedStorage(MemoryResource * resource) {
+            this->data = NULL;
+            this->m = R;
+            this->n = C;
+            this->ld = Inner();
+            this->capacity = 0;
+            this->resource = resource;
+            this->shareable = true;
+        }
+        /**
+         * Shares the entries of other if it allocates from the current default resource and they are shareable, otherwise
+         * copies them.
+         */
+        SharedStorage(const SharedStorage& other) : SharedStorage() {
+            if (CanShare(other))
+                Share(other);
+            else
+                CopyFrom(other);
+        }
+        /**
+         * Takes over other's array (and resource), leaving other empty.
+         */
+        SharedStorage(SharedStorage&& other) noexcept {
+            this->data = other.data;
+            this->m = other.m;
+            this->n = other.n;
+            this->ld = other.ld;
+            this->capacity = other.capacity;
+            this->resource = other.resource;
+            this->shareable = other.shareable;
+            other.data = NULL;
+            other.m = R;
+            other.n = C;
+            other.ld = other.Inner();
+            other.capacity = 0;
+            other.shareable = true;
+        }
+        /**
+         * Shares the entries of other if both use the same resource and they are shareable, unless our size does not change
+         * and either our leading dimension would, or our entries are unshareable (references to them must keep pointing at
+         * our entries). Otherwise the entries are copied, as in DenseStorage.
+         */
+        SharedStorage& operator=(const SharedStorage& other) {
+            if (this == &other || (this->data != NULL && this->data == other.data))
+                return *this;
+            bool sameSize = (this->m == other.m && this->n == other.n);
+            if (CanShare(other) && !(sameSize && (this->ld != other.ld || !this->shareable))) {
+                Share(other);
+            }
+            else if (sameSize) {
+                if (this->data != NULL && !Unique())
+                    Allocate(other.m, other.n, size_t(this->ld));
+                for (size_t l = 0; l < Lines(); ++l)
+                    std::copy(other.data+l*other.ld, other.data+l*other.ld+Inner(), this->data+l*this->ld);
+            }
+            else {
+                CopyFrom(other);
+            }
+            return *this;
+        }
+        SharedStorage& operator=(SharedStorage&& other) {
+            bool keepLayout = (this->m == other.m && this->n == other.n && this->ld != other.ld);
+            if (this->resource == other.resource && !keepLayout)
+                Swap(other);
+            else
+                *this = static_cast<const SharedStorage&>(other);
+            return *this;
+        }
+        ~SharedStorage() {
+            Release();
+        }
+        size_t NumRows() const { return this->m; }
+        size_t NumColumns() const { return this->n; }
+        /**
+         * @return Distance (in entries) between the starts of consecutive lines.
+         */
+        size_t LeadingDimension() const { return this->ld; }
+        /**
+         * @return Number of entries (padding included) the array has room for.
+         */
+        size_t Capacity() const { return this->capacity; }
+        /**
+         * Returns the entries for writing through a pointer the caller may keep. If the array is shared, it is copied first,
+         * and it is no longer shared with later copies.
+         */
+        S * Data() {
+            if (this->shareable) {
+                WritableData();
+                this->shareable = false;
+            }
+            return this->data;
+        }
+        /**
+         * Returns the entries for a write that does not keep the pointer. If the array is shared, it is copied first.
+         */
+        S * WritableData() {
+            if (this->shareable && this->data != NULL && !Unique())
+                Detach();
+            return this->data;
+        }
+        const S * Data() const { return this->data; }
+        /**
+         * @return Resource the entries are allocated from.
+         */
+        MemoryResource * Resource() const { return this->resource; }
+        /**
+         * Points the storage at a fresh, unshared rows-by-cols array, releasing the previous one. The entries (and the
+         * padding) are default constructed.
+         * @param rows Number of rows
+         * @param cols Number of columns
+         * @param ld Leading dimension. Values below the length of a line (e.g. the default 0) mean no padding.
+         * @param lines Number of lines to make room for. Values below the number of lines (e.g. the default 0) mean no spare room.
+         */
+        void Allocate(size_t rows, size_t cols, size_t ld = 0, size_t lines = 0) {
+            Release();
+            this->m = rows;
+            this->n = cols;
+            this->ld = std::max(ld, Inner());
+            size_t count = std::max(lines, Lines())*this->ld;
+            if (count != 0) {
+                char * block = static_cast<char*>(this->resource->Allocate(Header() + count*sizeof(S), Alignment()));
+                new (block) std::atomic<size_t>(1);
+                S * entries = reinterpret_cast<S*>(block + Header());
+                for (size_t i = 0; i < count; ++i)
+                    new (entries+i) S();
+                this->data = entries;
+                this->capacity = count;
+            }
+        }
+        /**
+         * Changes the size (and the leading dimension) without moving any entry, as in DenseStorage. The array must not be shared.
+         * @param rows Number of rows
+         * @param cols Number of columns
+         * @param ld Leading dimension
+         */
+        void SetLayout(size_t rows, size_t cols, size_t ld) {
+            this->m = rows;
+            this->n = cols;
+            this->ld = ld;
+        }
+        /**
+         * Takes over the entries of other, which stores the same matrix in the other order, transposing them in place (after
+         * giving other its own copy if they are shared). Padding is dropped and other is left empty. Must only be called on
+         * storage without entries.
+         * @param other Storage in the other order
+         */
+        void AdoptTransposed(SharedStorage<S,R,C,!ColMajor>& other) {
+            if (other.data != NULL) {
+                other.WritableData();
+                TransposeEntriesInPlace(other.data, other.Lines(), other.Inner(), other.ld);
+            }
+            this->data = other.data;
+            this->m = other.m;
+            this->n = other.n;
+            this->ld = Inner();
+            this->capacity = other.capacity;
+            this->resource = other.resource;
+            this->shareable = other.shareable;
+            other.data = NULL;
+            other.m = R;
+            other.n = C;
+            other.ld = other.Inner();
+            other.capacity = 0;
+            other.shareable = true;
+        }
+        /**
+         * Exchanges the arrays (and sizes and resources) with other.
+         * @param other Storage to swap with
+         */
+        void Swap(SharedStorage& other) noexcept {
+            std::swap(this->data, other.data);
+            std::swap(this->m, other.m);
+            std::swap(this->n, other.n);
+            std::swap(this->ld, other.ld);
+            std::swap(this->capacity, other.capacity);
+            std::swap(this->resource, other.resource);
+            std::swap(this->shareable, other.shareable);
+        }
+    private:
+        template <typename, size_t, size_t, bool> friend class SharedStorage;
+        static_assert(std::is_trivially_destructible<S>::value, "Matrix entries are released without running destructors.");
+
+        static constexpr size_t Alignment() {
+            return (LINEAR_HEAP_ALIGNMENT > alignof(S) ? LINEAR_HEAP_ALIGNMENT : alignof(S));
+        }
+        // Bytes in front of the entries holding the count, keeping the entries aligned.
+        static constexpr size_t Header() {
+            return (sizeof(std::atomic<size_t>) + Alignment() - 1) / Alignment() * Alignment();
+        }
+        size_t Lines() const { return (ColMajor ? this->n : this->m); }
+        size_t Inner() const { return (ColMajor ? this->m : this->n); }
+        // Entries from the start of the first line to the end of the padding of the last one.
+        size_t Used() const { return Lines()*this->ld; }
+        std::atomic<size_t>& References() const {
+            return *reinterpret_cast<std::atomic<size_t>*>(reinterpret_cast<char*>(this->data) - Header());
+        }
+        bool CanShare(const SharedStorage& other) const {
+            return other.shareable && this->resource == other.resource && dynamic_cast<Workspace*>(this->resource) == NULL;
+        }
+        bool Unique() const {
+            return References().load(std::memory_order_acquire) == 1;
+        }
+        void Share(const SharedStorage& other) {
+            Release();
+            this->data = other.data;
+            this->m = other.m;
+            this->n = other.n;
+            this->ld = other.ld;
+            this->capacity = other.capacity;
+            if (this->data != NULL)
+                References().fetch_add(1, std::memory_order_relaxed);
+        }
+        void CopyFrom(const SharedStorage& other) {
+            Allocate(other.m, other.n, other.ld);
+            std::copy(other.data, other.data+other.Used(), this->data);
+        }
+        // Unlike a copy, the private copy keeps the spare capacity, which the matrix may be about to grow into.
+        void Detach() {
+            SharedStorage copy(this->resource);
+            copy.Allocate(this->m, this->n, this->ld, this->capacity/this->ld);
+            std::copy(this->data, this->data+Used(), copy.data);
+            Swap(copy);
+        }
+        void Release() {
+            // The last owner frees the array. The release/acquire pair orders every owner's writes before the free.
+            if (this->data != NULL && References().fetch_sub(1, std::memory_order_acq_rel) == 1)
+                this->resource->Deallocate(reinterpret_cast<char*>(this->data) - Header(), Header() + this->capacity*sizeof(S), Alignment());
+            this->data = NULL;
+            this->capacity = 0;
+            this->shareable = true;
+        }
+
+        S * data;
+        size_t m, n;
+        size_t ld;
+        size_t capacity;
+        MemoryResource * resource;
+        // False once a pointer from Data() may be in use; the array is then never shared.
+        bool shareable;
+    };
+    /// \endcond
+}
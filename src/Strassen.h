@@ -0,0 +1,237 @@
+#pragma once
+#include <cstddef> // For size_t
+#include <algorithm>
+#include <memory>
+#include "Complex.h"
+#include "Memory.h"
+#include "Gemm.h"
+#include "Gemv.h"
+
+/**
+ * Default size below which the Strassen-Winograd product (see UseStrassen) falls back to the classical product: blocks are
+ * split while all of their dimensions are at least this large. Define LINEAR_STRASSEN_CROSSOVER before including Linear to
+ * override.
+ */
+#ifndef LINEAR_STRASSEN_CROSSOVER
+#define LINEAR_STRASSEN_CROSSOVER 1024
+#endif
+
+namespace Linear {
+    /// \cond DO_NOT_DOCUMENT
+    inline size_t& StrassenCrossover() {
+        static thread_local size_t crossover = 0;
+        return crossover;
+    }
+    /// \endcond
+
+    /**
+     * Computes the products of large matrices on this thread with the Strassen-Winograd algorithm until the object goes out
+     * of scope. Each level of the recursion splits the operands into 2x2 blocks and forms the product from 7 block
+     * products instead of 8, so an NxN product takes about \f$N^{2.81}\f$ multiply-adds instead of \f$N^3\f$:
+     *
+     *     UseStrassen strassen;
+     *     MatrixXd C = A*B;          // 4096x4096: three levels of recursion over the classical product.
+     *     MatrixXd P = Pow(A, 8);
+     *
+     * Products of matrices or views whose dimensions are all at least crossover are split, blocks of odd size are peeled
+     * by one row or column, and blocks below the crossover use the classical product. The temporaries come from the
+     * workspace bound to the thread (see UseWorkspace), or else from one workspace allocated for the whole product.
+     *
+     * The result differs from the classical product by rounding errors that grow a little faster with the size of the
+     * matrices, so Strassen is never used unless asked for.
+     */
+    class UseStrassen {
+    public:
+        /**
+         * Constructor.
+         * @param crossover Size below which blocks use the classical product (default = LINEAR_STRASSEN_CROSSOVER, at least 2)
+         */
+        explicit UseStrassen(size_t crossover = LINEAR_STRASSEN_CROSSOVER) {
+            this->previous = StrassenCrossover();
+            StrassenCrossover() = std::max<size_t>(crossover, 2);
+        }
+        ~UseStrassen() {
+            StrassenCrossover() = this->previous;
+        }
+        UseStrassen(const UseStrassen&) = delete;
+        UseStrassen& operator=(const UseStrassen&) = delete;
+    private:
+        size_t previous;
+    };
+
+    /// \cond DO_NOT_DOCUMENT
+    /**
+     * Sets the mxn block d to x+y, or x-y if subtract is true. d may be x or y.
+     */
+    template <typename D, typename X, typename Y>
+    void CombineBlocks(size_t m, size_t n, D * d, size_t drs, size_t dcs,
+                       const X * x, size_t xrs, size_t xcs, const Y * y, size_t yrs, size_t ycs, bool subtract) {
+        if (drs < dcs) {
+            std::swap(m, n);
+            std::swap(drs, dcs);
+            std::swap(xrs, xcs);
+            std::swap(yrs, ycs);
+        }
+        for (size_t i = 0; i < m; ++i) {
+            D * dr = d + i*drs;
+            const X * xr = x + i*xrs;
+            const Y * yr = y + i*yrs;
+            if (subtract) {
+                for (size_t j = 0; j < n; ++j)
+                    dr[j*dcs] = xr[j*xcs] - yr[j*ycs];
+            }
+            else {
+                for (size_t j = 0; j < n; ++j)
+                    dr[j*dcs] = xr[j*xcs] + yr[j*ycs];
+            }
+        }
+    }
+
+    /**
+     * Adds x+y (x-y if subtract is true) to the mxn block d and z to the block e in one pass. x, y and z are contiguous
+     * row-major mxn blocks, d and e blocks of the same matrix.
+     */
+    template <typename S>
+    void AccumulateBlocks(size_t m, size_t n, S * d, S * e, size_t rs, size_t cs,
+                          const S * x, const S * y, bool subtract, const S * z) {
+        for (size_t i = 0; i < m; ++i) {
+            S * dr = d + i*rs, * er = e + i*rs;
+            const S * xr = x + i*n, * yr = y + i*n, * zr = z + i*n;
+            for (size_t j = 0; j < n; ++j) {
+                dr[j*cs] += (subtract ? xr[j] - yr[j] : xr[j] + yr[j]);
+                er[j*cs] += zr[j];
+            }
+        }
+    }
+
+    /**
+     * Computes C += A*B with the classical product, on several threads if it is large. A and B are scaled as they are
+     * packed, see PackedMultiplyAdd().
+     */
+    template <typename SA, typename SB, typename SC>
+    void ClassicalMultiplyAdd(size_t m, size_t n, size_t k,
+                              const SA * a, size_t ars, size_t acs,
+                              const SB * b, size_t brs, size_t bcs,
+                              SC * c, size_t crs, size_t ccs,
+                              const GemmScale<typename GemmBlocking<SC>::Real>& scaleA = GemmScale<typename GemmBlocking<SC>::Real>(),
+                              const GemmScale<typename GemmBlocking<SC>::Real>& scaleB = GemmScale<typename GemmBlocking<SC>::Real>()) {
+        // A single row or column of C is a matrix-vector product, which the packed product is not made for.
+        if (n == 1)
+            GemvMultiplyAdd(m, k, a, ars, acs, scaleA, b, brs, scaleB, c, crs);
+        else if (m == 1)
+            GemvMultiplyAdd(n, k, b, bcs, brs, scaleB, a, acs, scaleA, c, ccs);
+        else if (m*n*k >= LINEAR_PARALLEL_THRESHOLD && GetNumThreads() > 1)
+            ParallelMultiplyAdd(m, n, k, a, ars, acs, b, brs, bcs, c, crs, ccs, scaleA, scaleB);
+        else
+            PackedMultiplyAdd(m, n, k, a, ars, acs, b, brs, bcs, c, crs, ccs, GetGemmKernel<SC>(), scaleA, scaleB);
+    }
+
+    /**
+     * Bytes of temporaries StrassenMultiplyAdd() allocates at once for an mxk times kxn product.
+     */
+    template <typename SA, typename SB, typename SC>
+    size_t StrassenBytes(size_t m, size_t n, size_t k, size_t crossover) {
+        if (std::min(m, std::min(n, k)) < crossover)
+            return 0;
+        size_t m2 = m/2, n2 = n/2, k2 = k/2;
+        size_t bytes = m2*k2*sizeof(SA) + k2*n2*sizeof(SB) + 2*m2*n2*sizeof(SC) + 4*LINEAR_HEAP_ALIGNMENT;
+        return bytes + StrassenBytes<SA,SB,SC>(m2, n2, k2, crossover);
+    }
+
+    /**
+     * Computes C += A*B with the Strassen-Winograd recursion while every dimension is at least crossover. With the even
+     * parts of A and B split into blocks A11, A12, A21, A22 and B11, ..., B22, the seven products are
+     *     P1 = A11*B11, P2 = A12*B21, P3 = S4*B22, P4 = A22*T4, P5 = S1*T1, P6 = S2*T2, P7 = S3*T3
+     * with S1 = A21+A22, S2 = S1-A11, S3 = A11-A21, S4 = A12-S2 and T1 = B12-B11, T2 = B22-T1, T3 = B22-B12, T4 = T2-B21,
+     * and C11 += P1+P2, C12 += U2+P5+P3, C21 += U3-P4, C22 += U3+P5 where U2 = P1+P6 and U3 = U2+P7. The sums are built
+     * in two buffers X and Y and the products in two buffers Q and R, reused in an order that keeps every intermediate
+     * needed later. The last row of A, column of A and column of B, if the dimensions are odd, are added separately.
+     */
+    template <typename SA, typename SB, typename SC>
+    void StrassenMultiplyAdd(size_t m, size_t n, size_t k,
+                             const SA * a, size_t ars, size_t acs,
+                             const SB * b, size_t brs, size_t bcs,
+                             SC * c, size_t crs, size_t ccs, size_t crossover) {
+        if (std::min(m, std::min(n, k)) < crossover) {
+            ClassicalMultiplyAdd(m, n, k, a, ars, acs, b, brs, bcs, c, crs, ccs);
+            return;
+        }
+        const size_t m2 = m/2, n2 = n/2, k2 = k/2;
+        const SA * a11 = a, * a12 = a + k2*acs, * a21 = a + m2*ars, * a22 = a21 + k2*acs;
+        const SB * b11 = b, * b12 = b + n2*bcs, * b21 = b + k2*brs, * b22 = b21 + n2*bcs;
+        SC * c11 = c, * c12 = c + n2*ccs, * c21 = c + m2*crs, * c22 = c21 + n2*ccs;
+        {
+            // The buffers are rewound before the odd parts are added.
+            WorkspaceScope scope(NULL);
+            MemoryResource * resource = GetDefaultMemoryResource();
+            SA * x = static_cast<SA*>(resource->Allocate(m2*k2*sizeof(SA), LINEAR_HEAP_ALIGNMENT));
+            SB * y = static_cast<SB*>(resource->Allocate(k2*n2*sizeof(SB), LINEAR_HEAP_ALIGNMENT));
+            SC * q = static_cast<SC*>(resource->Allocate(m2*n2*sizeof(SC), LINEAR_HEAP_ALIGNMENT));
+            SC * r = static_cast<SC*>(resource->Allocate(m2*n2*sizeof(SC), LINEAR_HEAP_ALIGNMENT));
+            std::fill(q, q + m2*n2, SC(0));
+            std::fill(r, r + m2*n2, SC(0));
+
+            // Q = P1, C11 += P1+P2.
+            StrassenMultiplyAdd(m2, n2, k2, a11, ars, acs, b11, brs, bcs, q, n2, 1, crossover);
+            CombineBlocks(m2, n2, c11, crs, ccs, c11, crs, ccs, q, n2, 1, false);
+            StrassenMultiplyAdd(m2, n2, k2, a12, ars, acs, b21, brs, bcs, c11, crs, ccs, crossover);
+            // X = S1, Y = T1, R = P5.
+            CombineBlocks(m2, k2, x, k2, 1, a21, ars, acs, a22, ars, acs, false);
+            CombineBlocks(k2, n2, y, n2, 1, b12, brs, bcs, b11, brs, bcs, true);
+            StrassenMultiplyAdd(m2, n2, k2, x, k2, 1, y, n2, 1, r, n2, 1, crossover);
+            // X = S2, Y = T2, Q = U2.
+            CombineBlocks(m2, k2, x, k2, 1, x, k2, 1, a11, ars, acs, true);
+            CombineBlocks(k2, n2, y, n2, 1, b22, brs, bcs, y, n2, 1, true);
+            StrassenMultiplyAdd(m2, n2, k2, x, k2, 1, y, n2, 1, q, n2, 1, crossover);
+            // X = S4, C12 += P3+U2+P5, C22 += P5.
+            CombineBlocks(m2, k2, x, k2, 1, a12, ars, acs, x, k2, 1, true);
+            StrassenMultiplyAdd(m2, n2, k2, x, k2, 1, b22, brs, bcs, c12, crs, ccs, crossover);
+            AccumulateBlocks(m2, n2, c12, c22, crs, ccs, q, r, false, r);
+            // Y = T4, R = P4, X = S3, Y = T3, Q = U3, C21 += U3-P4, C22 += U3.
+            CombineBlocks(k2, n2, y, n2, 1, y, n2, 1, b21, brs, bcs, true);
+            std::fill(r, r + m2*n2, SC(0));
+            StrassenMultiplyAdd(m2, n2, k2, a22, ars, acs, y, n2, 1, r, n2, 1, crossover);
+            CombineBlocks(m2, k2, x, k2, 1, a11, ars, acs, a21, ars, acs, true);
+            CombineBlocks(k2, n2, y, n2, 1, b22, brs, bcs, b12, brs, bcs, true);
+            StrassenMultiplyAdd(m2, n2, k2, x, k2, 1, y, n2, 1, q, n2, 1, crossover);
+            AccumulateBlocks(m2, n2, c21, c22, crs, ccs, q, r, true, q);
+        }
+
+        // Peel the odd row and columns: the last column of A times the last row of B, then the last column and row of C.
+        if (k % 2 != 0)
+            ClassicalMultiplyAdd(2*m2, 2*n2, 1, a + 2*k2*acs, ars, acs, b + 2*k2*brs, brs, bcs, c, crs, ccs);
+        if (n % 2 != 0)
+            ClassicalMultiplyAdd(2*m2, 1, k, a, ars, acs, b + 2*n2*bcs, brs, bcs, c + 2*n2*ccs, crs, ccs);
+        if (m % 2 != 0)
+            ClassicalMultiplyAdd(1, n, k, a + 2*m2*ars, ars, acs, b, brs, bcs, c + 2*m2*crs, crs, ccs);
+    }
+
+    /**
+     * Computes C += A*B, with the Strassen-Winograd recursion if a UseStrassen object is alive on this thread and the
+     * product is large enough, with the classical product otherwise. Scaled or conjugated operands (see GemmScale) always
+     * use the classical product.
+     */
+    template <typename SA, typename SB, typename SC>
+    void StridedMultiplyAdd(size_t m, size_t n, size_t k,
+                            const SA * a, size_t ars, size_t acs,
+                            const SB * b, size_t brs, size_t bcs,
+                            SC * c, size_t crs, size_t ccs,
+                            const GemmScale<typename GemmBlocking<SC>::Real>& scaleA = GemmScale<typename GemmBlocking<SC>::Real>(),
+                            const GemmScale<typename GemmBlocking<SC>::Real>& scaleB = GemmScale<typename GemmBlocking<SC>::Real>()) {
+        const size_t crossover = StrassenCrossover();
+        if (crossover == 0 || std::min(m, std::min(n, k)) < crossover || !scaleA.IsIdentity() || !scaleB.IsIdentity()) {
+            ClassicalMultiplyAdd(m, n, k, a, ars, acs, b, brs, bcs, c, crs, ccs, scaleA, scaleB);
+            return;
+        }
+        // Without a workspace bound to the thread, reserve one for every level of the recursion at once.
+        std::unique_ptr<Workspace> local;
+        if (GetWorkspace() == NULL) {
+            const GemmKernel<SC>& kernel = GetGemmKernel<SC>();
+            size_t packing = 2*(kernel.kc*(kernel.mc+kernel.nc) + kernel.mr*kernel.nr)*sizeof(SC) + 3*LINEAR_HEAP_ALIGNMENT;
+            local.reset(new Workspace(StrassenBytes<SA,SB,SC>(m, n, k, crossover) + packing));
+        }
+        UseWorkspace use(local ? local.get() : GetWorkspace());
+        StrassenMultiplyAdd(m, n, k, a, ars, acs, b, brs, bcs, c, crs, ccs, crossover);
+    }
+    /// \endcond
+}
@@ -19,7 +19,7 @@ namespace Linear {
      * @return True if M=N.
      */
     template <typename T, size_t M, size_t N, unsigned int Flags>
-    bool IsSquare(Matrix<T,M,N,Flags> A) {
+    bool IsSquare(const Matrix<T,M,N,Flags>& A) {
         return (A.NumRows() == A.NumColumns());
     }
 
@@ -206,4 +206,20 @@ namespace Linear {
     bool IsTridiagonal(const Matrix<T,M,N,Flags>& a) {
         return (IsLowerHessenberg(a) && IsUpperHessenberg(a));
     }
+
+    // Accept unevaluated expressions, e.g. IsVector(A - B).
+    LINEAR_EVALUATE_EXPRESSIONS(IsVector)
+    LINEAR_EVALUATE_EXPRESSIONS(IsSquare)
+    LINEAR_EVALUATE_EXPRESSIONS(IsUpperTriangular)
+    LINEAR_EVALUATE_EXPRESSIONS(IsLowerTriangular)
+    LINEAR_EVALUATE_EXPRESSIONS(IsTriangular)
+    LINEAR_EVALUATE_EXPRESSIONS(IsDiagonal)
+    LINEAR_EVALUATE_EXPRESSIONS(IsIdentity)
+    LINEAR_EVALUATE_EXPRESSIONS(IsCompanion)
+    LINEAR_EVALUATE_EXPRESSIONS(IsSymmetric)
+    LINEAR_EVALUATE_EXPRESSIONS(IsHermitian)
+    LINEAR_EVALUATE_EXPRESSIONS(IsUpperHessenberg)
+    LINEAR_EVALUATE_EXPRESSIONS(IsLowerHessenberg)
+    LINEAR_EVALUATE_EXPRESSIONS(IsHessenberg)
+    LINEAR_EVALUATE_EXPRESSIONS(IsTridiagonal)
 }
@@ -379,4 +379,11 @@ namespace Linear {
         }
         return res;
     }
+
+    // Accept unevaluated expressions, e.g. Dot(A - B).
+    LINEAR_EVALUATE_EXPRESSIONS(Dot)
+    LINEAR_EVALUATE_EXPRESSIONS(Normalize)
+    LINEAR_EVALUATE_EXPRESSIONS(Cross)
+    LINEAR_EVALUATE_EXPRESSIONS(Proj)
+    LINEAR_EVALUATE_EXPRESSIONS(GramSchmidt)
 }
@@ -0,0 +1,426 @@
+#pragma once
+#include <type_traits>
+#include <iterator>
+#include <cstddef>
+#include "Complex.h"
+#include "Storage.h"
+#include "Expression.h"
+#include "Global.h"
+
+namespace Linear {
+    template <typename T, unsigned int Flags, bool Const>
+    class MatrixView;
+
+    /**
+     * Unchecked, non-owning sequence of Size() entries spaced Stride() entries apart, e.g. a row or column of a matrix
+     * (see Matrix::RowSpan() and Matrix::ColumnSpan()). When Stride() is 1 the entries are contiguous and Data() can be
+     * used directly by loops the compiler vectorizes.
+     * @param S Entry type (const for read-only spans).
+     */
+    template <typename S>
+    class StridedSpan {
+    public:
+        /**
+         * Random access iterator stepping Stride() entries at a time.
+         */
+        class Iterator {
+        public:
+            typedef std::random_access_iterator_tag iterator_category;
+            typedef typename std::remove_const<S>::type value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef S * pointer;
+            typedef S & reference;
+
+            Iterator() : Iterator(NULL, 1) {}
+            Iterator(S * p, size_t stride) : p(p), stride(stride) {}
+            S & operator*() const { return *this->p; }
+            S * operator->() const { return this->p; }
+            S & operator[](difference_type i) const { return this->p[i*difference_type(this->stride)]; }
+            Iterator& operator++() { this->p += this->stride; return *this; }
+            Iterator operator++(int) { Iterator it = *this; ++*this; return it; }
+            Iterator& operator--() { this->p -= this->stride; return *this; }
+            Iterator operator--(int) { Iterator it = *this; --*this; return it; }
+            Iterator& operator+=(difference_type i) { this->p += i*difference_type(this->stride); return *this; }
+            Iterator& operator-=(difference_type i) { this->p -= i*difference_type(this->stride); return *this; }
+            Iterator operator+(difference_type i) const { Iterator it = *this; return it += i; }
+            Iterator operator-(difference_type i) const { Iterator it = *this; return it -= i; }
+            friend Iterator operator+(difference_type i, const Iterator& it) { return it + i; }
+            difference_type operator-(const Iterator& other) const { return (this->p - other.p)/difference_type(this->stride); }
+            bool operator==(const Iterator& other) const { return this->p == other.p; }
+            bool operator!=(const Iterator& other) const { return this->p != other.p; }
+            bool operator<(const Iterator& other) const { return this->p < other.p; }
+            bool operator>(const Iterator& other) const { return this->p > other.p; }
+            bool operator<=(const Iterator& other) const { return this->p <= other.p; }
+            bool operator>=(const Iterator& other) const { return this->p >= other.p; }
+        private:
+            S * p;
+            size_t stride;
+        };
+
+        /**
+         * Constructor.
+         * @param data Pointer to the first entry
+         * @param size Number of entries
+         * @param stride Distance in memory (in entries) between consecutive entries
+         */
+        StridedSpan(S * data, size_t size, size_t stride) : data(data), size(size), stride(stride) {}
+        /**
+         * A span of entries converts to a span of const entries.
+         */
+        template <typename U, typename = typename std::enable_if<std::is_convertible<U*,S*>::value>::type>
+        StridedSpan(const StridedSpan<U>& other) : data(other.Data()), size(other.Size()), stride(other.Stride()) {}
+        /**
+         * @return Number of entries
+         */
+        size_t Size() const { return this->size; }
+        /**
+         * @return Distance in memory (in entries) between consecutive entries
+         */
+        size_t Stride() const { return this->stride; }
+        /**
+         * @return Pointer to the first entry
+         */
+        S * Data() const { return this->data; }
+        /**
+         * @return Whether the entries are adjacent in memory (Stride() == 1)
+         */
+        bool IsContiguous() const { return this->stride == 1; }
+        /**
+         * Returns entry i. The index is not checked.
+         * @param i Index
+         * @return Entry
+         */
+        S & operator[](size_t i) const { return this->data[i*this->stride]; }
+        Iterator begin() const { return Iterator(this->data, this->stride); }
+        Iterator end() const { return Iterator(this->data + this->size*this->stride, this->stride); }
+    private:
+        S * data;
+        size_t size;
+        size_t stride;
+    };
+
+    /**
+     * Forward iterator over the entries of a matrix in storage order, skipping the padding at the end of each line when
+     * the leading dimension is larger than the line (see Matrix::SetLeadingDimension()). Without padding it walks one
+     * contiguous array.
+     * @param S Entry type (const for read-only iteration).
+     */
+    template <typename S>
+    class EntryIterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef typename std::remove_const<S>::type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef S * pointer;
+        typedef S & reference;
+
+        EntryIterator() : EntryIterator(NULL, 0, 0) {}
+        /**
+         * Constructor.
+         * @param p First entry of a line
+         * @param inner Number of entries in each line
+         * @param ld Distance (in entries) between the starts of consecutive lines
+         */
+        EntryIterator(S * p, size_t inner, size_t ld) : p(p), lineEnd(p + inner), inner(inner), gap(ld - inner) {}
+        S & operator*() const { return *this->p; }
+        S * operator->() const { return this->p; }
+        EntryIterator& operator++() {
+            if (++this->p == this->lineEnd) {
+                this->p += this->gap;
+                this->lineEnd = this->p + this->inner;
+            }
+            return *this;
+        }
+        EntryIterator operator++(int) { EntryIterator it = *this; ++*this; return it; }
+        bool operator==(const EntryIterator& other) const { return this->p == other.p; }
+        bool operator!=(const EntryIterator& other) const { return this->p != other.p; }
+    private:
+        S * p;
+        S * lineEnd;
+        size_t inner;
+        size_t gap;
+    };
+
+    /// \cond DO_NOT_DOCUMENT
+    template <typename T, unsigned int F, bool Const>
+    struct ExpressionTraits<MatrixView<T,F,Const>> {
+        typedef T Real;
+        static const size_t Rows = Dynamic;
+        static const size_t Columns = Dynamic;
+        static const unsigned int Flags = F;
+        static const bool StoresEntries = true;
+        static const bool MixedLayout = false;
+        // Views are cheap handles, so they are copied into expressions. The viewed matrix has to outlive the expression.
+        typedef MatrixView<T,F,Const> Nested;
+    };
+    /// \endcond
+
+    /**
+     * Non-owning reference to a rectangular, optionally strided, window of a matrix. Entry (r,c) of the view is the entry
+     * stored rowStride*r+columnStride*c entries after the first one. Views are created with Matrix::Block(), Matrix::Row()
+     * and Matrix::Column() and must not outlive the matrix they reference (or be used after it is resized).
+     *
+     * A view reads like any other MatrixExpression: it can be added, scaled, multiplied, printed and passed to the functions
+     * of Linear (which evaluate it into a Matrix first). Assigning to a non-const view writes into the viewed matrix:
+     *
+     *     Matrix3d A = { {1,2,3}, {4,5,6}, {7,8,9} };
+     *     A.Block(1, 1, 2, 2) = 2.0*A.Block(0, 0, 2, 2);
+     *     A.Row(0) *= -1.0;
+     *
+     * Copying a view copies the reference, not the entries.
+     * @param T Type of the real and imaginary parts of each entry.
+     * @param Flags Flags of the viewed matrix. Only RealStorage matters for the view itself.
+     * @param Const Whether the view is read-only (default = false).
+     */
+    template <typename T, unsigned int Flags = 0, bool Const = false>
+    class MatrixView : public MatrixExpression<MatrixView<T,Flags,Const>> {
+    public:
+        /**
+         * Type used to store each entry: T if Flags contains RealStorage, Complex<T> otherwise.
+         */
+        typedef typename ScalarTraits<T,(Flags & RealStorage) != 0>::Scalar Scalar;
+        /**
+         * Scalar, or const Scalar for read-only views.
+         */
+        typedef typename std::conditional<Const, const Scalar, Scalar>::type Entry;
+
+        /**
+         * Constructor.
+         * Views nrows-by-ncols entries starting at data.
+         * @param data Pointer to entry (0,0)
+         * @param nrows Number of rows
+         * @param ncols Number of columns
+         * @param rowStride Distance in memory (in entries) between consecutive rows
+         * @param columnStride Distance in memory (in entries) between consecutive columns
+         */
+        MatrixView(Entry * data, size_t nrows, size_t ncols, size_t rowStride, size_t columnStride) {
+            this->data = data;
+            this->m = nrows;
+            this->n = ncols;
+            this->rowStride = rowStride;
+            this->columnStride = columnStride;
+        }
+        /**
+         * Constructor.
+         * Creates a read-only view of the same entries as other.
+         * @param other Writable view
+         */
+        template <bool Const2, typename std::enable_if<Const && !Const2>::type* = nullptr>
+        MatrixView(const MatrixView<T,Flags,Const2>& other)
+            : MatrixView(other.Data(), other.NumRows(), other.NumColumns(), other.RowStride(), other.ColumnStride()) {}
+        MatrixView(const MatrixView& other) = default;
+
+        /**
+         * @return Number of rows
+         */
+        size_t NumRows() const { return this->m; }
+        /**
+         * @return Number of columns
+         */
+        size_t NumColumns() const { return this->n; }
+        /**
+         * @return Number of entries (Identical to NumRows()*NumColumns())
+         */
+        size_t NumEntries() const { return this->m*this->n; }
+        /**
+         * @return Distance in memory (in entries) between consecutive rows.
+         */
+        size_t RowStride() const { return this->rowStride; }
+        /**
+         * @return Distance in memory (in entries) between consecutive columns.
+         */
+        size_t ColumnStride() const { return this->columnStride; }
+        /**
+         * @return Pointer to entry (0,0).
+         */
+        Entry * Data() const { return this->data; }
+        /// \cond DO_NOT_DOCUMENT
+        // Same as Data(); lets the library write into views and matrices alike, see Matrix::WritableData().
+        Entry * WritableData() const { return this->data; }
+        /// \endcond
+
+        /**
+         * Returns the entry in row r and column c of the view. If r or c is out of range, an exception is thrown.
+         * @param r Row index
+         * @param c Column index
+         * @return Complex number
+         */
+        Scalar operator() (size_t r, size_t c) const {
+            if (LINEAR_BOUNDS_CHECK && (r >= NumRows() || c >= NumColumns()))
+                throw "Cannot access matrix. Row and column out of range.";
+            return At(r, c);
+        }
+        Entry & operator() (size_t r, size_t c) {
+            if (LINEAR_BOUNDS_CHECK && (r >= NumRows() || c >= NumColumns()))
+                throw "Cannot access matrix. Row and column out of range.";
+            return At(r, c);
+        }
+        /**
+         * Same as operator()(r,c), but the indices are never checked.
+         * @param r Row index
+         * @param c Column index
+         * @return Complex number
+         */
+        Entry & At(size_t r, size_t c) const {
+            return this->data[r*this->rowStride+c*this->columnStride];
+        }
+
+        /**
+         * Creates a view of part of this view: nrows rows starting at row i, taking every rowStep-th row, and ncols columns
+         * starting at column j, taking every colStep-th column. If the window does not fit in the view an exception is thrown.
+         * @param i Row offset
+         * @param j Column offset
+         * @param nrows Number of rows
+         * @param ncols Number of columns
+         * @param rowStep Step between rows (default = 1)
+         * @param colStep Step between columns (default = 1)
+         * @return nrowsxncols view
+         */
+        MatrixView Block(size_t i, size_t j, size_t nrows, size_t ncols, size_t rowStep = 1, size_t colStep = 1) const {
+            if (rowStep == 0 || colStep == 0)
+                throw "Cannot create view, steps must be positive.";
+            if ((nrows > 0 && i+(nrows-1)*rowStep >= NumRows()) || (ncols > 0 && j+(ncols-1)*colStep >= NumColumns()))
+                throw "Cannot create view, indices out of bounds.";
+            if (nrows == 0 || ncols == 0)
+                return MatrixView(this->data, nrows, ncols, this->rowStride*rowStep, this->columnStride*colStep);
+            return MatrixView(this->data + i*this->rowStride + j*this->columnStride, nrows, ncols,
+                              this->rowStride*rowStep, this->columnStride*colStep);
+        }
+        /**
+         * @param r Row index
+         * @return View of row r.
+         */
+        MatrixView Row(size_t r) const {
+            return Block(r, 0, 1, NumColumns());
+        }
+        /**
+         * @param c Column index
+         * @return View of column c.
+         */
+        MatrixView Column(size_t c) const {
+            return Block(0, c, NumRows(), 1);
+        }
+
+        // Assignments
+        /**
+         * Copies the entries of other into the viewed entries. If the sizes differ an exception is raised.
+         * @param other View
+         * @return This view
+         */
+        MatrixView& operator=(const MatrixView& other) {
+            return *this = static_cast<const MatrixExpression<MatrixView>&>(other);
+        }
+        /**
+         * Writes the expression e (e.g. A+2*B) into the viewed entries. If the sizes differ an exception is raised. When e
+         * reads entries of the viewed matrix that may be written before they are read, e is evaluated into a temporary first.
+         * @param e Matrix expression
+         * @return This view
+         */
+        template <typename E>
+        MatrixView& operator=(const MatrixExpression<E>& e) {
+            static_assert(!Const, "Cannot assign to a read-only view.");
+            if (NumRows() != e.NumRows() || NumColumns() != e.NumColumns())
+                throw "Cannot assign matrix to a matrix of different size.";
+            if (e.Derived().ConflictsWith(*this, true))
+                return *this = e.Eval();
+            ForEachIndex<(Flags & ColumnMajor) != 0, !SameLayout<Flags,E>::value>(NumRows(), NumColumns(), [&](size_t r, size_t c) {
+                At(r,c) = ToScalar(e.Derived().At(r,c));
+            });
+            return *this;
+        }
+        template <typename E>
+        MatrixView& operator+=(const MatrixExpression<E>& e) {
+            return *this = *this + e.Derived();
+        }
+        template <typename E>
+        MatrixView& operator-=(const MatrixExpression<E>& e) {
+            return *this = *this - e.Derived();
+        }
+        MatrixView& operator*=(T x) {
+            return *this = *this * x;
+        }
+        MatrixView& operator/=(T x) {
+            return *this = *this / x;
+        }
+        MatrixView& operator*=(const Complex<T>& s) {
+            return *this = *this * s;
+        }
+        MatrixView& operator/=(const Complex<T>& s) {
+            return *this = *this / s;
+        }
+
+        /// \cond DO_NOT_DOCUMENT
+        template <typename D>
+        bool ConflictsWith(const D& dest, bool inPlace) const {
+            return StorageConflicts(*this, dest, inPlace);
+        }
+        /// \endcond
+    private:
+        static Scalar ToScalar(T x) {
+            return x;
+        }
+        static Scalar ToScalar(const Complex<T>& z) {
+            return ScalarTraits<T,(Flags & RealStorage) != 0>::FromComplex(z);
+        }
+
+        Entry * data;
+        size_t m, n;
+        size_t rowStride, columnStride;
+    };
+
+    template <typename T, unsigned int Flags = 0>
+    using ConstMatrixView = MatrixView<T,Flags,true>;
+
+    /// \cond DO_NOT_DOCUMENT
+    template <unsigned int Flags, typename T, typename S>
+    MatrixView<T,Flags,std::is_const<S>::value> MapEntries(S * data, size_t nrows, size_t ncols, size_t ld) {
+        size_t inner = ((Flags & ColumnMajor) ? nrows : ncols);
+        if (ld == 0)
+            ld = inner;
+        if (ld < inner)
+            throw "Cannot map matrix. Leading dimension is shorter than a row or column.";
+        if (data == NULL && nrows != 0 && ncols != 0)
+            throw "Cannot map matrix. Data is NULL.";
+        if (Flags & ColumnMajor)
+            return MatrixView<T,Flags,std::is_const<S>::value>(data, nrows, ncols, 1, ld);
+        return MatrixView<T,Flags,std::is_const<S>::value>(data, nrows, ncols, ld, 1);
+    }
+    /// \endcond
+
+    /**
+     * Views an array owned by someone else (a file mapping, a network buffer, another library) as an nrows-by-ncols matrix,
+     * without copying it. The rows (columns if Flags contains ColumnMajor) are stored one after another, ld entries apart.
+     * The array must outlive the view; see MatrixView for what a view can do, and its constructor for arbitrary strides.
+     *
+     *     double buffer[6] = {1, 2, 3, 4, 5, 6};
+     *     auto A = Map(buffer, 2, 3);                   // Real 2x3 view, row major.
+     *     auto B = Map<ColumnMajor>(buffer, 2, 3);      // Same entries, read column by column.
+     *     MatrixXd C = A*Transpose(B);
+     *
+     * @param Flags ColumnMajor for column-major arrays (default = 0)
+     * @param data Pointer to entry (0,0)
+     * @param nrows Number of rows
+     * @param ncols Number of columns
+     * @param ld Distance (in entries) between the starts of consecutive rows (columns if column major). 0 means no padding (default = 0)
+     * @return View of the array. Writable unless data points to const.
+     */
+    template <unsigned int Flags = 0, typename T>
+    MatrixView<T,(Flags & ~RealStorage)> Map(Complex<T> * data, size_t nrows, size_t ncols, size_t ld = 0) {
+        return MapEntries<(Flags & ~RealStorage),T>(data, nrows, ncols, ld);
+    }
+    template <unsigned int Flags = 0, typename T>
+    ConstMatrixView<T,(Flags & ~RealStorage)> Map(const Complex<T> * data, size_t nrows, size_t ncols, size_t ld = 0) {
+        return MapEntries<(Flags & ~RealStorage),T>(data, nrows, ncols, ld);
+    }
+    /**
+     * Views an array of real numbers as a matrix with the RealStorage flag, see Map(Complex<T>*,size_t,size_t,size_t).
+     */
+    template <unsigned int Flags = 0, typename T, typename std::enable_if<std::is_arithmetic<T>::value>::type* = nullptr>
+    MatrixView<T,(Flags | RealStorage)> Map(T * data, size_t nrows, size_t ncols, size_t ld = 0) {
+        return MapEntries<(Flags | RealStorage),T>(data, nrows, ncols, ld);
+    }
+    template <unsigned int Flags = 0, typename T, typename std::enable_if<std::is_arithmetic<T>::value>::type* = nullptr>
+    ConstMatrixView<T,(Flags | RealStorage)> Map(const T * data, size_t nrows, size_t ncols, size_t ld = 0) {
+        return MapEntries<(Flags | RealStorage),T>(data, nrows, ncols, ld);
+    }
+}
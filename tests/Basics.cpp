@@ -26,4 +26,27 @@ int main() {
     };
     std::cout << "c = " << c << std::endl;
     std::cout << "rref(c) = " << RREF(c) << std::endl;
+
+    MatrixXf d = c;
+    d.TransposeInPlace();
+    std::cout << "d = c, d.TransposeInPlace() = " << d << std::endl;
+    std::cout << "d == c^T: " << (d == Transpose(c)) << std::endl;
+    Matrix<float,Dynamic,Dynamic,ColumnMajor> e = std::move(d);
+    std::cout << "column major e = std::move(d): " << (e == Transpose(c)) << ", e(5,2) = " << e(5,2) << std::endl;
+
+    RealMatrix<double,4,4,ColumnMajor> f = {
+        {2,1,0,3}, {1,4,1,0}, {0,2,5,1}, {3,0,1,6}
+    };
+    MatrixXd g = f;
+    std::cout << "f = " << f << std::endl;
+    std::cout << "det(f) = " << Determinant(f) << ", det(g) = " << Determinant(g) << std::endl;
+    std::cout << "adj(f) == adj(g): " << (Adjugate(f) == Adjugate(g)) << std::endl;
+    std::cout << "f^{-1}*f close to I: " << (FrobeniusNorm(Inverse(f)*f - Identity<double,4>()) < 1e-12) << std::endl;
+
+    Matrix<double,2,3> h = {
+        {Complexd(1,2), Complexd(3,4), Complexd(0,-1)}, {Complexd(5,6), Complexd(7,8), 2}
+    };
+    MatrixXd k = h;
+    std::cout << "h^* = " << ConjugateTranspose(h) << std::endl;
+    std::cout << "h^* == k^*: " << (ConjugateTranspose(h) == ConjugateTranspose(k)) << std::endl;
 }
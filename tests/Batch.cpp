@@ -0,0 +1,57 @@
+#include "../src/Linear.h"
+#include <iostream>
+using namespace Linear;
+
+int main() {
+    try {
+        RealMatrix3d A = {{4, 3, 2}, {2, 1, 3}, {3, 2, 1}};
+        RealMatrix3d B = {{1, 0, 2}, {0, 3, 1}, {2, 1, 0}};
+        Batch<RealMatrix3d> BA(11), BB(11);
+        for (size_t i = 0; i < BA.Size(); ++i) {
+            BA.Set(i, A + double(i)*B);
+            BB.Set(i, B - double(i)*A);
+        }
+        std::cout << "BA.Size() = " << BA.Size() << std::endl;
+        std::cout << "Entry (0,0) of BA: ";
+        for (size_t i = 0; i < BA.Size(); ++i)
+            std::cout << BA.RealData(0,0)[i] << " ";
+        std::cout << std::endl;
+        Batch<RealMatrix3d> BC = BA*BB;
+        std::cout << "(BA*BB)[5] = " << BC.Get(5) << std::endl;
+        bool same = true;
+        for (size_t i = 0; i < BA.Size(); ++i)
+            same = same && (BC.Get(i) == BA.Get(i)*BB.Get(i));
+        std::cout << "BA*BB matches A_i*B_i: " << same << std::endl;
+        std::cout << "Transpose(BA)[3] = " << Transpose(BA).Get(3) << std::endl;
+        std::vector<Complexd> det = Determinant(BA);
+        std::cout << "Determinant(BA): ";
+        for (size_t i = 0; i < det.size(); ++i)
+            std::cout << det[i] << " ";
+        std::cout << std::endl;
+        Batch<RealMatrix3d> inv = Inverse(BA);
+        std::cout << "Inverse(BA)[2] close to Inverse(BA[2]): " << (FrobeniusNorm(inv.Get(2) - Inverse(BA.Get(2))) < 1e-12) << std::endl;
+        RealMatrix<double,3,1> rhs = {1, 2, 3};
+        Batch<RealMatrix<double,3,1>> b(11, rhs);
+        Batch<RealMatrix<double,3,1>> x = Solve(BA, b);
+        std::cout << "BA[7]*Solve(BA,b)[7] = " << BA.Get(7)*x.Get(7) << std::endl;
+        std::cout << "=======================" << std::endl;
+
+        Matrix2d C = {{Complexd(1,1), 2}, {Complexd(0,-1), Complexd(3,2)}};
+        Batch<Matrix2d> BD(5, C);
+        Matrix2d S = {{1, 2}, {2, 4}};
+        BD.Set(4, S);
+        std::cout << "(BD*BD)[0] = " << (BD*BD).Get(0) << std::endl;
+        std::cout << "C*C = " << C*C << std::endl;
+        RealMatrix2d P = {{0, 1}, {1, 0}};
+        std::cout << "(BD*P)[0] = " << (BD*Batch<RealMatrix2d>(5, P)).Get(0) << std::endl;
+        std::vector<Complexd> cdet = Determinant(BD);
+        std::cout << "Determinant(BD): " << cdet[0] << " " << cdet[4] << std::endl;
+        std::cout << "Determinant(C) = " << Determinant(C) << std::endl;
+        std::cout << "Imaginary part of entry (1,1) of BD: " << BD.ImagData(1,1)[0] << std::endl;
+        Inverse(BD);
+    }
+    catch (const char * e) {
+        std::cout << e << std::endl;
+    }
+    return 0;
+}
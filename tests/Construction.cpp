@@ -68,6 +68,15 @@ int main() {
         std::cout << "augmented1 = " << augmented1 << std::endl;
         Matrix<float,4,2> augmented2 = RowAugmented(blocktl1, blockbr1);
         std::cout << "augmented2 = " << augmented2 << std::endl;
+
+        Vector4d quaternion = {0.5, 0.5, 0.5, 0.5};
+        Matrix3d rotation3 = Rotation<4,double,3>(quaternion);
+        Matrix4d rotation4 = Rotation<4,double,4>(quaternion);
+        std::cout << "Rotation<4,double,3>(q) = " << rotation3 << std::endl;
+        std::cout << "Rotation<4,double,4>(q) = " << rotation4 << std::endl;
+        Vector3d right = {1, 0, 0}, up = {0, 0, 1}, dir = {0, -1, 0}, eye = {1, 2, 3};
+        std::cout << "Translation(eye) = " << Translation(eye) << std::endl;
+        std::cout << "LookAt(right, up, dir, eye) = " << LookAt(right, up, dir, eye) << std::endl;
     }
     catch (const char* what) {
         std::cerr << "Error: " << what << std::endl;
@@ -0,0 +1,187 @@
+#include "../src/Linear.h"
+#include <iostream>
+#include <new>
+#include <atomic>
+#include <cstdlib>
+using namespace Linear;
+
+// Counts every heap allocation of the program, to find those made around a memory resource. The functions are called
+// through pointers, so the compiler does not pair operator new with std::free.
+static std::atomic<size_t> heapAllocations(0);
+static void * (* volatile allocate)(size_t) = std::malloc;
+static void (* volatile release)(void *) = std::free;
+void * operator new(size_t bytes) {
+    heapAllocations += 1;
+    if (void * p = allocate(bytes == 0 ? 1 : bytes))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void * p) noexcept { release(p); }
+void operator delete(void * p, size_t) noexcept { release(p); }
+
+int main() {
+    try {
+        TrackingResource tracker(GetDefaultMemoryResource());
+        {
+            UseMemoryResource use(&tracker);
+            MatrixXd A = {
+                {4,1,0,0,0}, {1,4,1,0,0}, {0,1,4,1,0}, {0,0,1,4,1}, {0,0,0,1,4}
+            };
+            std::cout << "A = " << A << std::endl;
+            std::cout << "A uses tracker: " << (A.Resource() == &tracker) << std::endl;
+            std::cout << "Entries aligned: " << (reinterpret_cast<size_t>(A.Data()) % LINEAR_HEAP_ALIGNMENT == 0) << std::endl;
+            std::cout << "Bytes in use: " << tracker.BytesInUse() << std::endl;
+
+            MatrixXd Ainv = Inverse(A);
+            std::cout << "Inverse(A) = " << Ainv << std::endl;
+            std::cout << "Bytes in use: " << tracker.BytesInUse() << std::endl;
+            std::cout << "Peak bytes: " << tracker.PeakBytes() << std::endl;
+
+            A.Resize(6, 6);
+            std::cout << "A.Resize(6,6) uses tracker: " << (A.Resource() == &tracker) << std::endl;
+            std::cout << "Bytes in use: " << tracker.BytesInUse() << std::endl;
+
+            size_t allocations = tracker.NumAllocations();
+            MatrixXd S = {
+                {1,2}, {3,4}
+            };
+            VectorXd v(LINEAR_INLINE_ENTRIES, 1.0);
+            S = S*Inverse(S);
+            std::cout << "Small matrices stay inline: " << S << v.Length() << " entries, "
+                      << tracker.NumAllocations()-allocations << " allocations" << std::endl;
+            S.Resize(5, 5);
+            std::cout << "S.Resize(5,5) moves to the heap: " << tracker.NumAllocations()-allocations << " allocations" << std::endl;
+        }
+        std::cout << "Bytes in use after scope: " << tracker.BytesInUse() << std::endl;
+        std::cout << "=======================" << std::endl;
+
+        {
+            TrackingResource quota(GetDefaultMemoryResource(), 1024);
+            UseMemoryResource use(&quota);
+            MatrixXd B(6, 6, 1.0);
+            std::cout << "6x6 within quota: " << quota.BytesInUse() << " bytes" << std::endl;
+            try {
+                MatrixXd C(16, 16, 1.0);
+                std::cout << "16x16 within quota" << std::endl;
+            }
+            catch (const std::bad_alloc&) {
+                std::cout << "16x16 exceeds quota" << std::endl;
+            }
+            Matrix4d D(1.0);
+            std::cout << "Static matrices are stored inline: " << (D.Resource() == NULL) << std::endl;
+        }
+        std::cout << "=======================" << std::endl;
+
+        {
+            typedef Matrix<double,Dynamic,Dynamic,CopyOnWrite> SharedMatrix;
+            TrackingResource shared(GetDefaultMemoryResource());
+            UseMemoryResource use(&shared);
+            SharedMatrix F(100, 100, 1.0);
+            size_t before = shared.NumAllocations();
+            SharedMatrix G = F;
+            const SharedMatrix& cF = F;
+            const SharedMatrix& cG = G;
+            std::cout << "Copy shares the entries: " << (cF.Data() == cG.Data()) << ", allocations " << shared.NumAllocations()-before << std::endl;
+            double total = 0;
+            for (int i = 0; i < 10; ++i) {
+                const SharedMatrix copy = F;
+                total += Trace(copy).Re;
+            }
+            std::cout << "Trace of 10 more copies: " << total << ", allocations " << shared.NumAllocations()-before << std::endl;
+            G(0,0) = 2.0;
+            std::cout << "Writing detaches: " << (cF.Data() != cG.Data()) << ", F(0,0) = " << cF(0,0) << ", G(0,0) = " << cG(0,0) << std::endl;
+            auto& r = F(1,1);
+            SharedMatrix K = F;
+            r = 5.0;
+            std::cout << "Copy after a reference escaped: " << (cF.Data() != K.Data()) << ", F(1,1) = " << cF(1,1) << ", K(1,1) = " << K(1,1) << std::endl;
+            SharedMatrix P(100, 100, 1.0);
+            SharedMatrix Q = P;
+            const SharedMatrix& cP = P;
+            const SharedMatrix& cQ = Q;
+            double sum = (cQ(1,1) + cQ.At(2,2)).Re;
+            std::cout << "Const reads share: " << (cP.Data() == cQ.Data()) << ", sum " << sum << std::endl;
+            Q += P;
+            const SharedMatrix S = Q;
+            std::cout << "+= detaches: " << (cP.Data() != cQ.Data()) << ", and the result shares again: " << (cQ.Data() == S.Data()) << std::endl;
+        }
+        std::cout << "=======================" << std::endl;
+
+        {
+            // The threads of the pool have their own default resource, so their packed panels must come from the caller.
+            size_t threads = GetNumThreads();
+            SetNumThreads(4);
+            RealMatrixXd X(200, 200, 1.0), Y(200, 200, 2.0);
+            // The pool starts its threads on first use.
+            RealMatrixXd W = X*Y;
+            TrackingResource products(GetDefaultMemoryResource());
+            UseMemoryResource use(&products);
+            size_t heap = heapAllocations;
+            RealMatrixXd Z = X*Y;
+            RealMatrixXd G;
+            Herk(1.0, X, OP_CONJUGATE_TRANSPOSE, 0.0, G);
+            std::cout << "Parallel products: Z(0,0) = " << Z(0,0) << ", G(0,0) = " << G(0,0) << ", allocations "
+                      << products.NumAllocations() << ", not counted " << heapAllocations-heap-products.NumAllocations() << std::endl;
+            SetNumThreads(threads);
+        }
+        std::cout << "=======================" << std::endl;
+
+        {
+            TrackingResource growth(GetDefaultMemoryResource());
+            UseMemoryResource use(&growth);
+            RealMatrixXd H;
+            RealMatrix<double,1,Dynamic> row(8, 1.0);
+            for (int i = 0; i < 1000; ++i) {
+                row[0] = i;
+                H.AppendRow(row);
+            }
+            std::cout << "1000 appended rows: " << H.NumRows() << "x" << H.NumColumns() << ", H(999,0) = " << H(999,0)
+                      << ", allocations " << growth.NumAllocations() << std::endl;
+            H.ShrinkToFit();
+            std::cout << "ShrinkToFit: capacity " << H.Capacity() << ", bytes in use " << growth.BytesInUse() << std::endl;
+            size_t before = growth.NumAllocations();
+            RealMatrixXd K;
+            K.Reserve(1000, 8);
+            for (int i = 0; i < 1000; ++i)
+                K.AppendRow(H.Row(i));
+            std::cout << "Reserve then append: " << (K == H) << ", allocations " << growth.NumAllocations()-before << std::endl;
+        }
+        std::cout << "=======================" << std::endl;
+
+        TrackingResource heap(GetDefaultMemoryResource());
+        UseMemoryResource useHeap(&heap);
+        Workspace workspace;
+        UseWorkspace useWorkspace(&workspace);
+        MatrixXd E = {
+            {4,1,2,0}, {1,3,0,1}, {2,0,5,1}, {0,1,1,2}
+        };
+        Schur<double,Dynamic> schur(E);
+        QR<double,Dynamic,Dynamic> qr(E);
+        Hessenberg<double,Dynamic> hess(E);
+        size_t allocations = heap.NumAllocations();
+        for (int i = 0; i < 10; ++i) {
+            schur.Compute(E);
+            qr.Compute(E);
+            hess.Compute(E);
+        }
+        std::cout << "Heap allocations for 10 more decompositions: " << heap.NumAllocations()-allocations << std::endl;
+        std::cout << "Workspace in use after the calls: " << workspace.BytesInUse() << std::endl;
+        std::cout << "Schur U = " << schur.U << std::endl;
+        std::cout << "QR = " << qr.Q*qr.R << std::endl;
+        std::cout << "Hessenberg H = " << hess.H << std::endl;
+
+        std::vector<Eigenpair<double,Dynamic>> pairs = Eigen(E);
+        allocations = heap.NumAllocations();
+        for (int i = 0; i < 10; ++i)
+            pairs = Eigen(E);
+        std::cout << "Heap allocations for 10 more eigenpair computations: " << heap.NumAllocations()-allocations << std::endl;
+        std::cout << "Workspace in use after the calls: " << workspace.BytesInUse() << std::endl;
+        std::cout << "Eigenvalues:";
+        for (size_t i = 0; i < pairs.size(); ++i)
+            std::cout << " " << pairs[i].value;
+        std::cout << std::endl;
+    }
+    catch (const char * e) {
+        std::cout << e << std::endl;
+    }
+    return 0;
+}
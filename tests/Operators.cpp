@@ -24,4 +24,96 @@ int main() {
     std::cout << "b*a = " << b*a << std::endl;
     std::cout << "a==b = " << (a==b ? "true" : "false") << std::endl;
     std::cout << "a!=b = " << (a!=b ? "true" : "false") << std::endl;
+
+    Matrix3f c = a + 2*b - b/2;
+    std::cout << "a+2*b-b/2 = " << c << std::endl;
+    c = c - a;
+    std::cout << "c = c-a = " << c << std::endl;
+    c += -c + b;
+    std::cout << "c += -c+b = " << c << std::endl;
+    std::cout << "(a+b)*(a-b) = " << (a+b)*(a-b) << std::endl;
+
+    Matrix<float,3,3,ColumnMajor> d = b;
+    MatrixXf e(20, 20, 1.0f);
+    e(19,0) = 2.0f;
+    Matrix<float,Dynamic,Dynamic,ColumnMajor> f = e + 2*e;
+    std::cout << "column major d = b: " << (d == b ? "true" : "false") << std::endl;
+    std::cout << "b+d = " << b+d << std::endl;
+    f -= e;
+    std::cout << "f = e+2*e-e, f(19,0) = " << f(19,0) << ", f(0,19) = " << f(0,19) << std::endl;
+
+    MatrixXd g(40, 50, 0.0), h(50, 30, 0.0);
+    for (size_t r = 0; r < 50; ++r) {
+        for (size_t c = 0; c < 50; ++c) {
+            if (r < 40)
+                g(r,c) = Complex<double>(double((r+2*c)%7), double((r*c)%3));
+            if (c < 30)
+                h(r,c) = double((3*r+c)%5);
+        }
+    }
+    Matrix<double,Dynamic,Dynamic,ColumnMajor> gc = g;
+    MatrixXd gh = g*h;
+    std::cout << "g*h = gc*h: " << (gh == gc*h ? "true" : "false") << ", (g*h)(39,29) = " << gh(39,29) << std::endl;
+    std::cout << "g.Block(10,20,10,30)*h.Block(20,0,30,30) = (g*h).Block(10,0,10,30) - g.Block(10,0,10,20)*h.Block(0,0,20,30): "
+              << (g.Block(10,20,10,30)*h.Block(20,0,30,30) == gh.Block(10,0,10,30) - g.Block(10,0,10,20)*h.Block(0,0,20,30) ? "true" : "false") << std::endl;
+
+    MatrixXd p(200, 150, 0.0), q(150, 120, 0.0);
+    for (size_t r = 0; r < 200; ++r) {
+        for (size_t c = 0; c < 150; ++c) {
+            p(r,c) = double((r+c)%9) - 4.0;
+            if (r < 150 && c < 120)
+                q(r,c) = double((r*c)%5);
+        }
+    }
+    SetNumThreads(1);
+    MatrixXd pq = p*q;
+    SetNumThreads(4);
+    std::cout << "p*q on 4 threads = p*q on 1 thread: " << (p*q == pq ? "true" : "false") << ", (p*q)(199,119) = " << pq(199,119) << std::endl;
+    {
+        UseStrassen strassen(8);
+        std::cout << "Strassen p*q = p*q: " << (p*q == pq ? "true" : "false") << ", g*h = g*h: " << (g*h == gh ? "true" : "false") << std::endl;
+    }
+
+    MatrixXd u;
+    Gemm(2, g, OP_CONJUGATE_TRANSPOSE, gh, OP_NONE, 0, u);
+    Complex<double> sum = 0;
+    for (size_t i = 0; i < 40; ++i)
+        sum += 2.0*Conjugate(g(i,49))*gh(i,29);
+    std::cout << "Gemm(2, g, OP_CONJUGATE_TRANSPOSE, g*h, OP_NONE, 0, u), u(49,29) = " << u(49,29)
+              << ", 2*sum(conj(g(i,49))*(g*h)(i,29)) = " << sum << std::endl;
+    Gemm(Complex<double>(0,1), h, OP_TRANSPOSE, q.Block(0,0,50,30), OP_NONE, 1, u.Block(0,0,30,30));
+    std::cout << "u.Block(0,0,30,30) += i*Transpose(h)*q.Block(0,0,50,30), u(29,29) = " << u(29,29) << std::endl;
+    MatrixXd v = gh;
+    Gemm(-1, g, OP_NONE, h, OP_NONE, 1, v);
+    std::cout << "g*h - g*h = 0: " << (v == MatrixXd(40, 30, 0.0) ? "true" : "false") << std::endl;
+
+    MatrixXd w, gg;
+    Herk(1, g, OP_CONJUGATE_TRANSPOSE, 0, w);
+    Gemm(1, g, OP_CONJUGATE_TRANSPOSE, g, OP_NONE, 0, gg);
+    std::cout << "Herk(1, g, OP_CONJUGATE_TRANSPOSE, 0, w) = Gemm(1, g, OP_CONJUGATE_TRANSPOSE, g, OP_NONE, 0, gg): "
+              << (w == gg ? "true" : "false") << ", w(3,7) = " << w(3,7) << ", w(7,3) = " << w(7,3) << std::endl;
+    MatrixXd pp(150, 150, 1.0);
+    Herk(0.5, p, OP_CONJUGATE_TRANSPOSE, 2.0, pp);
+    std::cout << "Herk(0.5, p, OP_CONJUGATE_TRANSPOSE, 2.0, pp), pp(149,0) = " << pp(149,0) << ", pp(0,149) = " << pp(0,149) << std::endl;
+
+    Matrix<double,Dynamic,1> x(150, 1, 0.0), y;
+    for (size_t i = 0; i < 150; ++i)
+        x(i,0) = Complex<double>(double(i%7) - 3.0, double(i%4));
+    Gemv(1, p, OP_NONE, x, 0, y);
+    std::cout << "Gemv(1, p, OP_NONE, x, 0, y) = p*x: " << (y == p*x ? "true" : "false") << ", y(199,0) = " << y(199,0) << std::endl;
+    Matrix<double,Dynamic,1> z(150, 1, 1.0);
+    Gemv(Complex<double>(0,2), p, OP_CONJUGATE_TRANSPOSE, y, 1, z);
+    Complex<double> zsum = 1;
+    for (size_t i = 0; i < 200; ++i)
+        zsum += Complex<double>(0,2)*Conjugate(p(i,149))*y(i,0);
+    std::cout << "Gemv(2i, p, OP_CONJUGATE_TRANSPOSE, y, 1, z), z(149,0) = " << z(149,0) << ", 1+2i*sum(conj(p(i,149))*y(i)) = " << zsum << std::endl;
+    Matrix<double,1,Dynamic> yt(1, 200, 0.0);
+    for (size_t i = 0; i < 200; ++i)
+        yt(0,i) = y(i,0);
+    Matrix<double,1,Dynamic> ytp = yt*p;
+    Gemv(1, p, OP_TRANSPOSE, y, 0, z);
+    bool same = true;
+    for (size_t i = 0; i < 150; ++i)
+        same = same && (ytp(0,i) == z(i,0));
+    std::cout << "Gemv(1, p, OP_TRANSPOSE, y, 0, z) = Transpose(y)*p: " << (same ? "true" : "false") << ", z(0,0) = " << z(0,0) << std::endl;
 }
@@ -0,0 +1,67 @@
+#include "../src/Linear.h"
+#include <iostream>
+using namespace Linear;
+
+int main() {
+    try {
+        RealMatrix3d A = {
+            {2,-1,0}, {-1,2,-1}, {0,-1,2}
+        };
+        Matrix3d Ac = A;
+
+        std::cout << "sizeof(RealMatrix3d) = " << sizeof(RealMatrix3d) << ", sizeof(Matrix3d) = " << sizeof(Matrix3d) << std::endl;
+        std::cout << "A = " << A << std::endl;
+        std::cout << "A*A = " << A*A << std::endl;
+        std::cout << "A*A == Ac*Ac: " << (A*A == Ac*Ac) << std::endl;
+        std::cout << "2A-A = " << 2.0*A-A << std::endl;
+        std::cout << "iA = " << Complexd(0,1)*A << std::endl;
+        std::cout << "det(A) = " << Determinant(A) << std::endl;
+        std::cout << "A^{-1} = " << Inverse(A) << std::endl;
+        std::cout << "RREF(A) = " << RREF(A) << std::endl;
+        std::cout << "Sqrt(A) = " << Sqrt(A) << std::endl;
+        std::cout << "Abs(A) = " << Abs(A) << std::endl;
+        std::cout << "||A|| = " << Norm(A) << std::endl;
+        std::cout << "=======================" << std::endl;
+
+        QR<double,3,3,RealStorage> qr(A);
+        std::cout << "Q = " << qr.Q << std::endl;
+        std::cout << "R = " << qr.R << std::endl;
+        std::cout << "QR = " << qr.Q*qr.R << std::endl;
+        LUP<double,3,RealStorage> lup(A);
+        std::cout << "L = " << lup.L << std::endl;
+        std::cout << "U = " << lup.U << std::endl;
+        std::cout << "PA = " << lup.P*A << std::endl;
+        std::cout << "LU = " << lup.L*lup.U << std::endl;
+        Cholesky<double,3,RealStorage> cholesky(A);
+        std::cout << "LDL* = " << cholesky.L*cholesky.D*cholesky.Lh << std::endl;
+        Eigendecomposition<double,3,RealStorage> eigen(A);
+        std::cout << "D = " << eigen.D << std::endl;
+        std::cout << "QDQ^{-1} = " << eigen.Q*eigen.D*eigen.Qinv << std::endl;
+        SVD<double,3,3,RealStorage> svd(A);
+        std::cout << "S = " << svd.S << std::endl;
+        Hessenberg<double,3,RealStorage> hessenberg(A);
+        std::cout << "H = " << hessenberg.H << std::endl;
+        Schur<double,3,RealStorage> schur(A);
+        std::cout << "T = " << schur.U << std::endl;
+        std::cout << "=======================" << std::endl;
+
+        // A rotation has complex eigenvalues, which come back as complex numbers.
+        RealMatrix2d B = {
+            {0,-1}, {1,0}
+        };
+        std::cout << "B = " << B << std::endl;
+        std::vector<Eigenpair<double,2>> eigenpairs = Eigen(B);
+        for (size_t i = 0; i < eigenpairs.size(); ++i) {
+            std::cout << "(" << eigenpairs[i].value << "," << Transpose(eigenpairs[i].vector) << ")" << std::endl;
+        }
+        try {
+            Eigendecomposition<double,2,RealStorage> eigenb(B);
+        }
+        catch (const char* what) {
+            std::cout << "Eigendecomposition<double,2,RealStorage>(B): " << what << std::endl;
+        }
+    }
+    catch (const char* what) {
+        std::cerr << "Error: " << what << std::endl;
+    }
+}
@@ -0,0 +1,47 @@
+#include "../src/Linear.h"
+#include <iostream>
+using namespace Linear;
+
+int main() {
+    try {
+        Matrix<double,2,3> A = {
+            {Complexd(1,1), 2, Complexd(0,-1)}, {3, Complexd(2,-2), 1}
+        };
+        Matrix<double,3,2,ColumnMajor> B = {
+            {1, Complexd(0,1)}, {Complexd(1,-1), 2}, {0, Complexd(3,1)}
+        };
+        SplitMatrix<double,2,3> SA = A;
+        SplitMatrix<double,3,2,ColumnMajor> SB = B;
+
+        std::cout << "SA = " << SA << std::endl;
+        std::cout << "Real plane of SA: ";
+        for (size_t i = 0; i < SA.NumEntries(); ++i)
+            std::cout << SA.RealData()[i] << " ";
+        std::cout << std::endl << "Imaginary plane of SA: ";
+        for (size_t i = 0; i < SA.NumEntries(); ++i)
+            std::cout << SA.ImagData()[i] << " ";
+        std::cout << std::endl;
+        std::cout << "SA*SB = " << SA*SB << std::endl;
+        std::cout << "SA*SB == A*B: " << ((SA*SB).Eval() == A*B) << std::endl;
+        std::cout << "SA+SA = " << SA+SA << std::endl;
+        std::cout << "Conjugate(SA) = " << Conjugate(SA) << std::endl;
+        std::cout << "Abs(SA) = " << Abs(SA) << std::endl;
+        std::cout << "Exp(SA) == Exp(A): " << (Exp(SA).Eval() == Exp(A)) << std::endl;
+        std::cout << "Sin(SA) == Sin(A): " << (Sin(SA).Eval() == Sin(A)) << std::endl;
+        std::cout << "EntrywiseProduct(SA,SA) = " << EntrywiseProduct(SA, SA) << std::endl;
+        std::cout << "=======================" << std::endl;
+
+        SplitMatrix<double,1,Dynamic> x = A.Row(0), y = A.Row(1);
+        std::cout << "Dot(x,y) = " << Dot(x, y) << std::endl;
+        SA.Set(0, 0, Complexd(5, 5));
+        SA *= Complexd(0, 1);
+        std::cout << "SA = " << SA << std::endl;
+        Matrix<double,2,3> C = SA;
+        std::cout << "C = " << C << std::endl;
+        std::cout << "FrobeniusNorm(SA) = " << FrobeniusNorm(SA) << std::endl;
+    }
+    catch (const char * e) {
+        std::cout << e << std::endl;
+    }
+    return 0;
+}
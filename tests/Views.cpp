@@ -0,0 +1,87 @@
+#include "../src/Linear.h"
+#include <iostream>
+using namespace Linear;
+
+int main() {
+    try {
+        Matrix3d A = {
+            {1,2,3}, {4,5,6}, {7,8,9}
+        };
+        const Matrix3d& cA = A;
+
+        std::cout << "A = " << A << std::endl;
+        std::cout << "A.Block(0,1,2,2) = " << A.Block(0,1,2,2) << std::endl;
+        std::cout << "A.Block(0,0,2,2,2,2) = " << A.Block(0,0,2,2,2,2) << std::endl;
+        std::cout << "A.Row(1) = " << A.Row(1) << std::endl;
+        std::cout << "A.Column(2) = " << cA.Column(2) << std::endl;
+        std::cout << "det(A.Block(1,1,2,2)) = " << Determinant(A.Block(1,1,2,2)) << std::endl;
+        std::cout << "A*A.Column(0) = " << A*A.Column(0) << std::endl;
+        std::cout << "=======================" << std::endl;
+
+        A.Row(0) *= -1.0;
+        std::cout << "A.Row(0) *= -1: " << A << std::endl;
+        A.Column(2) = A.Column(0) + A.Column(1);
+        std::cout << "A.Column(2) = A.Column(0) + A.Column(1): " << A << std::endl;
+        A.Block(1,1,2,2) = 2.0*A.Block(0,0,2,2);
+        std::cout << "A.Block(1,1,2,2) = 2*A.Block(0,0,2,2): " << A << std::endl;
+
+        RealMatrix<double,3,3,ColumnMajor> R = A;
+        R.Block(0,0,2,2) += R.Block(1,1,2,2);
+        std::cout << "R.Block(0,0,2,2) += R.Block(1,1,2,2): " << R << std::endl;
+        std::cout << "=======================" << std::endl;
+
+        double sum = 0;
+        for (double x : R)
+            sum += x;
+        std::cout << "sum of R's entries: " << sum << std::endl;
+        for (double& x : R.RowSpan(0))
+            x = 0;
+        std::cout << "R.RowSpan(0) = 0: " << R << std::endl;
+        StridedSpan<const double> column = R.ColumnSpan(1);
+        std::cout << "R.ColumnSpan(1): size " << column.Size() << ", stride " << column.Stride()
+                  << ", contiguous " << column.IsContiguous() << ", last entry " << column[2] << std::endl;
+        std::cout << "R.At(2,1) = " << R.At(2,1) << std::endl;
+        std::cout << "=======================" << std::endl;
+
+        MatrixXd P = A;
+        P.SetLeadingDimension(8);
+        std::cout << "P.LeadingDimension() = " << P.LeadingDimension() << ", contiguous " << P.IsContiguous() << std::endl;
+        std::cout << "P == A: " << (P == A) << std::endl;
+        std::cout << "P*P - A*A = " << P*P - A*A << std::endl;
+        P.Row(2) = P.Row(0) + P.Row(1);
+        std::cout << "P.Row(2) = P.Row(0) + P.Row(1): " << P << std::endl;
+        size_t count = 0;
+        for (auto& p : P) {
+            p = p*2.0;
+            count += 1;
+        }
+        std::cout << "entries visited: " << count << std::endl;
+        MatrixXd Big(64, 64, 1.0);
+        Big.Pad();
+        std::cout << "Big.Pad(): leading dimension " << Big.LeadingDimension() << ", trace " << Trace(Big) << std::endl;
+        std::cout << "=======================" << std::endl;
+
+        double buffer[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+        auto Q = Map(buffer, 2, 3, 4);
+        std::cout << "Map(buffer, 2, 3, 4) = " << Q << std::endl;
+        std::cout << "Map<ColumnMajor>(buffer, 2, 4) = " << Map<ColumnMajor>(buffer, 2, 4) << std::endl;
+        Q.Row(1) = 2.0*Q.Row(0);
+        std::cout << "Q.Row(1) = 2*Q.Row(0) writes the buffer: " << buffer[4] << " " << buffer[6] << " " << buffer[7] << std::endl;
+        const Complex<double> entries[4] = {Complex<double>(1,1), 2, 3, Complex<double>(0,-1)};
+        std::cout << "Inverse(Map(entries, 2, 2)) = " << Inverse(Map(entries, 2, 2)) << std::endl;
+        std::cout << "=======================" << std::endl;
+
+        try {
+            A.Row(0) = A.Column(0);
+        } catch (const char * e) {
+            std::cout << "A.Row(0) = A.Column(0): " << e << std::endl;
+        }
+        try {
+            A.Block(2,2,2,2);
+        } catch (const char * e) {
+            std::cout << "A.Block(2,2,2,2): " << e << std::endl;
+        }
+    } catch (const char * e) {
+        std::cout << "Exception: " << e << std::endl;
+    }
+}
@@ -1,5 +1,6 @@
 #include "../src/Matrix.h"
 #include <iostream>
+#include <utility>
 using namespace Linear;
 
 int main() {
@@ -76,6 +77,17 @@ int main() {
     std::cout << "matrix_copy_4 = " << matrix_copy_4 << std::endl;
     std::cout << "size(matrix_copy_4) = " << matrix_copy_4.Size() << std::endl;
 
+    MatrixXf matrix_move_1(std::move(matrix_dynamic_7));
+    std::cout << "matrix_move_1 = " << matrix_move_1 << std::endl;
+    std::cout << "size(matrix_move_1) = " << matrix_move_1.Size() << std::endl;
+    std::cout << "size(matrix_dynamic_7) = " << matrix_dynamic_7.Size() << std::endl;
+
+    MatrixXf matrix_assign_1 = matrix_dynamic_6;
+    matrix_assign_1 = matrix_move_1;
+    matrix_assign_1(0,0) = 0;
+    std::cout << "matrix_assign_1 = " << matrix_assign_1 << std::endl;
+    std::cout << "matrix_move_1 = " << matrix_move_1 << std::endl;
+
     MatrixXd matrix_empty_1;
     std::cout << "matrix_empty_1 = " << matrix_empty_1 << std::endl;
     std::cout << "size(matrix_empty_1) = " << matrix_empty_1.Size() << std::endl;